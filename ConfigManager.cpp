@@ -17,6 +17,12 @@ bool ConfigManager::saveConfig(const BotConfig& config, const std::string& filen
     configMap["twitchOAuth"] = config.twitchOAuth;
     configMap["twitchChannel"] = config.twitchChannel;
     configMap["twitchEnabled"] = config.twitchEnabled ? "true" : "false";
+    configMap["twitchChannelsPerConnection"] = std::to_string(config.twitchChannelsPerConnection);
+    configMap["twitchRawIrc"] = config.twitchRawIrc ? "true" : "false";
+    configMap["triggerRules"] = config.triggerRules;
+    configMap["mentionAliases"] = config.mentionAliases;
+    configMap["userCooldownSecs"] = std::to_string(config.userCooldownSecs);
+    configMap["channelCooldownSecs"] = std::to_string(config.channelCooldownSecs);
     configMap["announceMessage"] = config.announceMessage;
     configMap["announceDiscordChannel"] = config.announceDiscordChannel;
     configMap["announceHours"] = std::to_string(config.announceHours);
@@ -56,6 +62,15 @@ bool ConfigManager::loadConfig(BotConfig& config, const std::string& filename) {
     config.twitchOAuth = SimpleJSON::getString(configMap, "twitchOAuth");
     config.twitchChannel = SimpleJSON::getString(configMap, "twitchChannel");
     config.twitchEnabled = SimpleJSON::getString(configMap, "twitchEnabled") == "true";
+    std::string perConnStr = SimpleJSON::getString(configMap, "twitchChannelsPerConnection");
+    config.twitchChannelsPerConnection = perConnStr.empty() ? 50 : std::stoi(perConnStr);
+    config.twitchRawIrc = SimpleJSON::getString(configMap, "twitchRawIrc") == "true";
+    config.triggerRules = SimpleJSON::getString(configMap, "triggerRules");
+    config.mentionAliases = SimpleJSON::getString(configMap, "mentionAliases");
+    std::string userCooldownStr = SimpleJSON::getString(configMap, "userCooldownSecs");
+    config.userCooldownSecs = userCooldownStr.empty() ? 10 : std::stoi(userCooldownStr);
+    std::string channelCooldownStr = SimpleJSON::getString(configMap, "channelCooldownSecs");
+    config.channelCooldownSecs = channelCooldownStr.empty() ? 0 : std::stoi(channelCooldownStr);
     config.announceMessage = SimpleJSON::getString(configMap, "announceMessage");
     config.announceDiscordChannel = SimpleJSON::getString(configMap, "announceDiscordChannel");
     std::string hoursStr = SimpleJSON::getString(configMap, "announceHours");
@@ -80,38 +95,40 @@ bool ConfigManager::loadConfig(BotConfig& config, const std::string& filename) {
 // ============================================
 
 std::string ProfileManager::buildProfilesJson(const std::vector<BotConfig>& profiles) {
-    std::string json = "[\n";
+    std::string json;
+    JsonWriter writer(json, 2);
     
-    for (size_t i = 0; i < profiles.size(); i++) {
-        const BotConfig& p = profiles[i];
-        
-        json += "  {\n";
-        json += "    \"profileName\": \"" + SimpleJSON::escape(p.profileName) + "\",\n";
-        json += "    \"discordToken\": \"" + SimpleJSON::escape(p.discordToken) + "\",\n";
-        json += "    \"discordEnabled\": \"" + std::string(p.discordEnabled ? "true" : "false") + "\",\n";
-        json += "    \"apiKey\": \"" + SimpleJSON::escape(p.apiKey) + "\",\n";
-        json += "    \"aiId\": \"" + SimpleJSON::escape(p.aiId) + "\",\n";
-        json += "    \"baseUrl\": \"" + SimpleJSON::escape(p.baseUrl) + "\",\n";
-        json += "    \"personaName\": \"" + SimpleJSON::escape(p.personaName) + "\",\n";
-        json += "    \"twitchUsername\": \"" + SimpleJSON::escape(p.twitchUsername) + "\",\n";
-        json += "    \"twitchOAuth\": \"" + SimpleJSON::escape(p.twitchOAuth) + "\",\n";
-        json += "    \"twitchChannel\": \"" + SimpleJSON::escape(p.twitchChannel) + "\",\n";
-        json += "    \"twitchEnabled\": \"" + std::string(p.twitchEnabled ? "true" : "false") + "\",\n";
-        json += "    \"announceMessage\": \"" + SimpleJSON::escape(p.announceMessage) + "\",\n";
-        json += "    \"announceDiscordChannel\": \"" + SimpleJSON::escape(p.announceDiscordChannel) + "\",\n";
-        json += "    \"announceHours\": \"" + std::to_string(p.announceHours) + "\",\n";
-        json += "    \"announceMins\": \"" + std::to_string(p.announceMins) + "\",\n";
-        json += "    \"announceDiscord\": \"" + std::string(p.announceDiscord ? "true" : "false") + "\",\n";
-        json += "    \"announceTwitch\": \"" + std::string(p.announceTwitch ? "true" : "false") + "\"\n";
-        json += "  }";
-        
-        if (i < profiles.size() - 1) {
-            json += ",";
-        }
-        json += "\n";
+    // Every value is written as a string - parseProfilesJson only reads strings
+    writer.beginArray();
+    for (const BotConfig& p : profiles) {
+        writer.beginObject();
+        writer.key("profileName").string(p.profileName);
+        writer.key("discordToken").string(p.discordToken);
+        writer.key("discordEnabled").string(p.discordEnabled ? "true" : "false");
+        writer.key("apiKey").string(p.apiKey);
+        writer.key("aiId").string(p.aiId);
+        writer.key("baseUrl").string(p.baseUrl);
+        writer.key("personaName").string(p.personaName);
+        writer.key("twitchUsername").string(p.twitchUsername);
+        writer.key("twitchOAuth").string(p.twitchOAuth);
+        writer.key("twitchChannel").string(p.twitchChannel);
+        writer.key("twitchEnabled").string(p.twitchEnabled ? "true" : "false");
+        writer.key("twitchChannelsPerConnection").string(std::to_string(p.twitchChannelsPerConnection));
+        writer.key("twitchRawIrc").string(p.twitchRawIrc ? "true" : "false");
+        writer.key("triggerRules").string(p.triggerRules);
+        writer.key("mentionAliases").string(p.mentionAliases);
+        writer.key("userCooldownSecs").string(std::to_string(p.userCooldownSecs));
+        writer.key("channelCooldownSecs").string(std::to_string(p.channelCooldownSecs));
+        writer.key("announceMessage").string(p.announceMessage);
+        writer.key("announceDiscordChannel").string(p.announceDiscordChannel);
+        writer.key("announceHours").string(std::to_string(p.announceHours));
+        writer.key("announceMins").string(std::to_string(p.announceMins));
+        writer.key("announceDiscord").string(p.announceDiscord ? "true" : "false");
+        writer.key("announceTwitch").string(p.announceTwitch ? "true" : "false");
+        writer.endObject();
     }
+    writer.endArray();
     
-    json += "]";
     return json;
 }
 
@@ -167,6 +184,15 @@ std::vector<BotConfig> ProfileManager::parseProfilesJson(const std::string& json
                     profile.twitchOAuth = SimpleJSON::getString(obj, "twitchOAuth");
                     profile.twitchChannel = SimpleJSON::getString(obj, "twitchChannel");
                     profile.twitchEnabled = SimpleJSON::getString(obj, "twitchEnabled") == "true";
+                    std::string perConnStr = SimpleJSON::getString(obj, "twitchChannelsPerConnection");
+                    profile.twitchChannelsPerConnection = perConnStr.empty() ? 50 : std::stoi(perConnStr);
+                    profile.twitchRawIrc = SimpleJSON::getString(obj, "twitchRawIrc") == "true";
+                    profile.triggerRules = SimpleJSON::getString(obj, "triggerRules");
+                    profile.mentionAliases = SimpleJSON::getString(obj, "mentionAliases");
+                    std::string userCooldownStr = SimpleJSON::getString(obj, "userCooldownSecs");
+                    profile.userCooldownSecs = userCooldownStr.empty() ? 10 : std::stoi(userCooldownStr);
+                    std::string channelCooldownStr = SimpleJSON::getString(obj, "channelCooldownSecs");
+                    profile.channelCooldownSecs = channelCooldownStr.empty() ? 0 : std::stoi(channelCooldownStr);
                     profile.announceMessage = SimpleJSON::getString(obj, "announceMessage");
                     profile.announceDiscordChannel = SimpleJSON::getString(obj, "announceDiscordChannel");
                     std::string hoursStr = SimpleJSON::getString(obj, "announceHours");
@@ -0,0 +1,94 @@
+#include "KindroidBot.h"
+
+// ============================================
+// CooldownTable - bounded expiring hash table
+// ============================================
+
+CooldownTable::CooldownTable(size_t capacity) : evicted(0) {
+    size_t size = MAX_PROBE;
+    while (size < capacity) size <<= 1;
+    slots.assign(size, Slot{ 0, 0 });
+    mask = size - 1;
+}
+
+uint64_t CooldownTable::makeKey(std::string_view platform, std::string_view channel, std::string_view user) {
+    // FNV-1a over the parts (with separators), then a splitmix finish so the low
+    // bits used for the slot index depend on every input byte
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](std::string_view part) {
+        for (unsigned char c : part) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        h ^= 0xFF;
+        h *= 1099511628211ULL;
+    };
+    mix(platform);
+    mix(channel);
+    mix(user);
+    
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h ? h : 1; // 0 marks a never-used slot
+}
+
+CooldownTable::Slot* CooldownTable::findLocked(uint64_t key, ULONGLONG now, bool insert) {
+    Slot* reusable = nullptr; // First empty or expired slot in the window
+    Slot* oldest = nullptr;   // Live slot closest to expiry, evicted if nothing else is free
+    
+    size_t index = (size_t)key & mask;
+    for (size_t probe = 0; probe < MAX_PROBE; probe++) {
+        Slot& slot = slots[(index + probe) & mask];
+        if (slot.key == key) return &slot;
+        
+        bool expired = slot.expiresAt <= now;
+        if (expired && !reusable) reusable = &slot;
+        if (slot.key == 0) break; // Inserts fill the first free slot, so the key is not further on
+        if (!expired && (!oldest || slot.expiresAt < oldest->expiresAt)) oldest = &slot;
+    }
+    if (!insert) return nullptr;
+    
+    Slot* slot = reusable;
+    if (!slot) {
+        slot = oldest;
+        evicted++;
+    }
+    slot->key = key;
+    slot->expiresAt = 0;
+    return slot;
+}
+
+bool CooldownTable::tryAcquire(uint64_t key, DWORD cooldownMs) {
+    if (cooldownMs == 0) return true;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    ULONGLONG now = GetTickCount64();
+    Slot* slot = findLocked(key, now, true);
+    if (slot->expiresAt > now) return false;
+    slot->expiresAt = now + cooldownMs;
+    return true;
+}
+
+bool CooldownTable::tryAcquire(uint64_t keyA, DWORD cooldownA, uint64_t keyB, DWORD cooldownB) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ULONGLONG now = GetTickCount64();
+    
+    // Check both before starting either
+    Slot* a = cooldownA ? findLocked(keyA, now, false) : nullptr;
+    if (a && a->expiresAt > now) return false;
+    Slot* b = cooldownB ? findLocked(keyB, now, false) : nullptr;
+    if (b && b->expiresAt > now) return false;
+    
+    if (cooldownA) findLocked(keyA, now, true)->expiresAt = now + cooldownA;
+    if (cooldownB) findLocked(keyB, now, true)->expiresAt = now + cooldownB;
+    return true;
+}
+
+void CooldownTable::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::fill(slots.begin(), slots.end(), Slot{ 0, 0 });
+    evicted = 0;
+}
@@ -2,23 +2,63 @@
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <sstream>
+#include <chrono>
 
 #pragma comment(lib, "ws2_32.lib")
 
+// Discord puts at most 2500 guilds on a shard; the name cache is sized for all of
+// them, with room for this many channels and threads each
+static const size_t GUILDS_PER_SHARD = 2500;
+static const size_t CACHED_CHANNELS_PER_GUILD = 40;
+
+// Replies run one at a time per channel, so each waiting mention adds a whole
+// Kindroid round trip (a few seconds) to the ones behind it. Past this many the
+// answers would land long after the conversation moved on; later mentions are
+// skipped until the channel catches up.
+static const size_t PENDING_REPLIES_PER_CHANNEL = 5;
+
 DiscordBot::DiscordBot(const std::string& token, KindroidAPI* api, HWND console)
     : token(token), kindroid(api), consoleHwnd(console), running(false),
-      sequenceNumber(0), shouldReconnect(true), currentSocket(INVALID_SOCKET) {
+      shouldReconnect(true), shardCount(1), maxConcurrency(1),
+      handledEvents(0), skippedEvents(0), userCooldownMs(10000), channelCooldownMs(0),
+      outbox([this](const std::string& channelId, const std::string& content) {
+          return postDiscordMessage(channelId, content);
+      }),
+      typing(outbox, [this](const std::string& channelId) { return postTyping(channelId); }),
+      backfills(1, 0, 64),
+      // One Kindroid call at a time per channel, so replies keep the order of the
+      // mentions; up to 16 channels at once across all guilds. Pacing is left to the outbox.
+      replies(16, 0, PENDING_REPLIES_PER_CHANNEL) {
+    stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
 }
 
 DiscordBot::~DiscordBot() {
     stop();
+    // stop() skips a run that ended on its own; no reply may end typing once typing is gone
+    outbox.stop();
+    // Shards are destroyed with the bot; their threads must be gone first
+    if (botThread.joinable()) botThread.join();
+    if (stopEvent) CloseHandle(stopEvent);
 }
 
 void DiscordBot::start() {
     if (running) return;
     
+    // A previous run that ended on its own (e.g. WSAStartup failed) still needs joining
+    if (botThread.joinable()) botThread.join();
+    
     running = true;
     shouldReconnect = true;
+    ResetEvent(stopEvent);
+    {
+        // Lookups still queued when the last run stopped were dropped with it
+        std::lock_guard<std::mutex> lock(stateMutex);
+        pendingLookups.clear();
+    }
+    outbox.start();
+    typing.start();
+    backfills.start();
+    replies.start();
     
     log("[INFO] Starting bot thread...");
     
@@ -31,20 +71,27 @@ void DiscordBot::stop() {
     log("[INFO] Stopping bot...");
     shouldReconnect = false;
     running = false;
+    SetEvent(stopEvent);
+    replies.stop();
+    backfills.stop();
+    typing.stop();
+    outbox.stop();
     
-    // Close the current socket to unblock any pending recv() calls
+    // Close every shard socket to unblock any pending recv() calls
     {
         std::lock_guard<std::mutex> lock(socketMutex);
-        if (currentSocket != INVALID_SOCKET) {
-            closesocket(currentSocket);
-            currentSocket = INVALID_SOCKET;
+        for (auto& shard : shards) {
+            if (shard->socket != INVALID_SOCKET) {
+                closesocket(shard->socket);
+                shard->socket = INVALID_SOCKET;
+            }
         }
     }
     
-    // Don't join here - let the thread finish on its own
-    // We'll detach it instead to avoid blocking the GUI
+    // run() joins the shard threads, so once it returns nothing touches the bot.
+    // With the sockets closed and stopEvent set every wait ends promptly.
     if (botThread.joinable()) {
-        botThread.detach();
+        botThread.join();
     }
     
     log("[INFO] Bot stopped");
@@ -69,10 +116,10 @@ void DiscordBot::log(const std::string& message) {
     }
     
     if (consoleHwnd && IsWindow(consoleHwnd)) {
-        // Use SendMessage instead of PostMessage for synchronous delivery
+        // Posted, not sent: stop() joins the bot's threads on the GUI thread, so a
+        // synchronous send from one of them would deadlock. The handler frees the copy.
         char* msgCopy = _strdup(logMsg.c_str());
-        SendMessageA(consoleHwnd, WM_USER + 100, 0, (LPARAM)msgCopy);
-        // Don't free here - the handler will free it
+        if (!PostMessageA(consoleHwnd, WM_USER + 100, 0, (LPARAM)msgCopy)) free(msgCopy);
     }
 }
 
@@ -90,26 +137,156 @@ void DiscordBot::run() {
     
     log("[INFO] Connecting to Discord...");
     
+    // Ask Discord how many shards to open before connecting any of them
+    ReconnectPolicy lookupRetry;
+    while (running && shouldReconnect && !fetchGatewayInfo()) {
+        DWORD delay = lookupRetry.nextDelay();
+        log("[INFO] Retrying gateway lookup in " + std::to_string(delay) + "ms...");
+        if (WaitForSingleObject(stopEvent, delay) == WAIT_OBJECT_0) break;
+    }
+    
+    if (running && shouldReconnect) {
+        {
+            std::lock_guard<std::mutex> lock(socketMutex);
+            shards.clear();
+            for (int i = 0; i < shardCount; i++) {
+                shards.push_back(std::make_unique<DiscordShard>(i));
+            }
+        }
+        identifyBuckets.assign(maxConcurrency, 0);
+        
+        size_t guildLimit = GUILDS_PER_SHARD * (size_t)shardCount;
+        guildCache.setLimits(guildLimit * CACHED_CHANNELS_PER_GUILD, guildLimit);
+        
+        for (auto& shard : shards) {
+            shard->thread = std::thread(&DiscordBot::runShard, this, shard.get());
+        }
+        for (auto& shard : shards) {
+            if (shard->thread.joinable()) shard->thread.join();
+        }
+    }
+    
+    log("[INFO] Guild cache: " + guildCache.statsString());
+    log("[INFO] Outbox: " + outbox.statsString());
+    log("[INFO] Replies: " + replies.statsString());
+    log("[INFO] Typing: " + typing.statsString());
+    log("[INFO] Gateway events: " + std::to_string(handledEvents) + " handled, " +
+        std::to_string(skippedEvents) + " skipped by pre-filter, last RTT: " +
+        std::to_string(getGatewayRtt()) + "ms");
+    
+    WSACleanup();
+    log("[INFO] Bot thread stopped");
+    running = false;
+}
+
+void DiscordBot::runShard(DiscordShard* shard) {
     while (running && shouldReconnect) {
         try {
-            connectWebSocket();
+            connectWebSocket(shard);
         } catch (const std::exception& e) {
-            log("[ERROR] Exception: " + std::string(e.what()));
+            log("[ERROR] Shard " + std::to_string(shard->id) + " exception: " + std::string(e.what()));
         } catch (...) {
-            log("[ERROR] Unknown exception");
+            log("[ERROR] Shard " + std::to_string(shard->id) + " unknown exception");
         }
         
-        if (shouldReconnect && running) {
-            log("[INFO] Reconnecting in 5 seconds...");
-            for (int i = 0; i < 50 && running; i++) {
-                Sleep(100);
-            }
+        if (!running || !shouldReconnect) break;
+        
+        bool resuming = shard->resumeNow.exchange(false);
+        DWORD delay = shard->reconnect.nextDelay();
+        std::string shardName = "Shard " + std::to_string(shard->id);
+        if (delay == 0) {
+            log("[INFO] " + shardName + (resuming ? " resuming immediately" : " reconnecting immediately"));
+        } else {
+            log("[INFO] " + shardName + " reconnecting in " + std::to_string(delay) + "ms (attempt " +
+                std::to_string(shard->reconnect.attempts()) + ")...");
         }
+        
+        // stop() signals the event, so a pending backoff never delays shutdown
+        if (WaitForSingleObject(stopEvent, delay) == WAIT_OBJECT_0) break;
     }
+}
+
+// Read an integer member ("key":123) from a JSON string, or return fallback
+static int extractJsonInt(const std::string& json, const std::string& key, int fallback) {
+    size_t keyPos = json.find("\"" + key + "\"");
+    if (keyPos == std::string::npos) return fallback;
     
-    WSACleanup();
-    log("[INFO] Bot thread stopped");
-    running = false;
+    size_t colonPos = json.find(':', keyPos + key.length() + 2);
+    if (colonPos == std::string::npos) return fallback;
+    
+    size_t numStart = colonPos + 1;
+    while (numStart < json.length() && (json[numStart] == ' ' || json[numStart] == '\t')) numStart++;
+    size_t numEnd = numStart;
+    while (numEnd < json.length() && isdigit((unsigned char)json[numEnd])) numEnd++;
+    if (numEnd == numStart || numEnd - numStart > 9) return fallback;
+    
+    return std::stoi(json.substr(numStart, numEnd - numStart));
+}
+
+bool DiscordBot::fetchGatewayInfo() {
+    log("[INFO] Getting Discord Gateway URL...");
+    
+    // /gateway/bot also tells us the recommended shard count and identify concurrency
+    std::string gatewayResp = httpRequest("discord.com", "/api/v10/gateway/bot");
+    if (gatewayResp.empty()) {
+        log("[ERROR] Failed to get gateway URL");
+        return false;
+    }
+    
+    auto gatewayData = SimpleJSON::parseObject(gatewayResp);
+    std::string wsUrl = SimpleJSON::getString(gatewayData, "url");
+    if (wsUrl.empty()) {
+        log("[ERROR] Invalid gateway response (check the bot token)");
+        log("[DEBUG] Gateway response: " + gatewayResp.substr(0, 200));
+        return false;
+    }
+    
+    // Parse URL
+    size_t hostStart = wsUrl.find("://");
+    if (hostStart == std::string::npos) {
+        log("[ERROR] Invalid URL");
+        return false;
+    }
+    hostStart += 3;
+    
+    std::string host = wsUrl.substr(hostStart);
+    size_t pathPos = host.find('/');
+    if (pathPos != std::string::npos) {
+        host = host.substr(0, pathPos);
+    }
+    gatewayHost = host;
+    
+    shardCount = extractJsonInt(gatewayResp, "shards", 1);
+    if (shardCount < 1) shardCount = 1;
+    maxConcurrency = extractJsonInt(gatewayResp, "max_concurrency", 1);
+    if (maxConcurrency < 1) maxConcurrency = 1;
+    
+    int remaining = extractJsonInt(gatewayResp, "remaining", -1);
+    if (remaining >= 0 && remaining < shardCount) {
+        log("[WARNING] Only " + std::to_string(remaining) + " session starts left today for " +
+            std::to_string(shardCount) + " shards");
+    }
+    
+    log("[INFO] Gateway: " + gatewayHost + ", shards: " + std::to_string(shardCount) +
+        ", max_concurrency: " + std::to_string(maxConcurrency));
+    return true;
+}
+
+bool DiscordBot::waitForIdentifySlot(DiscordShard* shard) {
+    // Shards share an IDENTIFY bucket by (shard_id % max_concurrency);
+    // each bucket may start one session every 5 seconds.
+    int bucket = shard->id % maxConcurrency;
+    
+    // Take the bucket's next slot now, so queued shards go in order without polling
+    ULONGLONG now = GetTickCount64();
+    ULONGLONG slot;
+    {
+        std::lock_guard<std::mutex> lock(identifyMutex);
+        slot = identifyBuckets[bucket] > now ? identifyBuckets[bucket] : now;
+        identifyBuckets[bucket] = slot + 5000;
+    }
+    if (slot == now) return running;
+    return WaitForSingleObject(stopEvent, (DWORD)(slot - now)) == WAIT_TIMEOUT;
 }
 
 // WebSocket helper functions
@@ -125,39 +302,14 @@ static std::string makeWebSocketHandshake(const std::string& host, const std::st
     return req.str();
 }
 
-static bool sendWSFrame(SchannelContext* ssl, const std::string& data) {
-    std::vector<unsigned char> frame;
-    frame.push_back(0x81); // FIN + text frame
-    
-    size_t len = data.length();
-    if (len < 126) {
-        frame.push_back((unsigned char)(0x80 | len));
-    } else if (len < 65536) {
-        frame.push_back(0x80 | 126);
-        frame.push_back((unsigned char)((len >> 8) & 0xFF));
-        frame.push_back((unsigned char)(len & 0xFF));
-    } else {
-        frame.push_back(0x80 | 127);
-        for (int i = 7; i >= 0; i--) {
-            frame.push_back((unsigned char)((len >> (i * 8)) & 0xFF));
-        }
-    }
-    
-    // Mask key
-    unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
-    for (int i = 0; i < 4; i++) frame.push_back(mask[i]);
-    
-    // Masked payload
-    for (size_t i = 0; i < data.length(); i++) {
-        frame.push_back(data[i] ^ mask[i % 4]);
-    }
-    
-    return SchannelSend(ssl, frame.data(), (int)frame.size()) == (int)frame.size();
+static bool sendWSFrame(SchannelContext* ssl, const std::string& data, std::mutex& sendMutex) {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    return WebSocketSend(ssl, 0x1, data.data(), data.length()); // Text frame
 }
 
-static std::string recvWSFrame(SchannelContext* ssl) {
+static std::string recvWSFrame(SchannelContext* ssl, std::mutex& sendMutex) {
     unsigned char header[2];
-    int headerResult = SchannelRecv(ssl, header, 2);
+    int headerResult = SchannelRecvAll(ssl, header, 2);
     
     if (headerResult != 2) {
         return "";
@@ -168,12 +320,12 @@ static std::string recvWSFrame(SchannelContext* ssl) {
     
     if (payloadLen == 126) {
         unsigned char extLen[2];
-        int extResult = SchannelRecv(ssl, extLen, 2);
+        int extResult = SchannelRecvAll(ssl, extLen, 2);
         if (extResult != 2) return "";
         payloadLen = (extLen[0] << 8) | extLen[1];
     } else if (payloadLen == 127) {
         unsigned char extLen[8];
-        if (SchannelRecv(ssl, extLen, 8) != 8) return "";
+        if (SchannelRecvAll(ssl, extLen, 8) != 8) return "";
         payloadLen = 0;
         for (int i = 0; i < 8; i++) {
             payloadLen = (payloadLen << 8) | extLen[i];
@@ -195,68 +347,52 @@ static std::string recvWSFrame(SchannelContext* ssl) {
     if (opcode == 0x8) { // Close frame
         return ""; // Signal connection closed
     }
-    if (opcode == 0x9) { // Ping
-        sendWSFrame(ssl, payload);
-        return recvWSFrame(ssl);
+    if (opcode == 0x9) { // Ping - answer with a pong carrying the same payload
+        {
+            std::lock_guard<std::mutex> lock(sendMutex);
+            WebSocketSend(ssl, 0xA, payload.data(), payload.length());
+        }
+        return recvWSFrame(ssl, sendMutex);
     }
     
     return payload;
 }
 
-void DiscordBot::connectWebSocket() {
-    log("[INFO] Getting Discord Gateway URL...");
-    
-    std::string gatewayResp = httpRequest("discord.com", "/api/v10/gateway");
-    if (gatewayResp.empty()) {
-        log("[ERROR] Failed to get gateway URL");
-        return;
-    }
-    
-    auto gatewayData = SimpleJSON::parseObject(gatewayResp);
-    std::string wsUrl = SimpleJSON::getString(gatewayData, "url");
-    if (wsUrl.empty()) {
-        log("[ERROR] Invalid gateway response");
-        return;
+void DiscordBot::dropConnection(DiscordShard* shard) {
+    // shutdown() unblocks the read loop, which then closes the socket itself
+    std::lock_guard<std::mutex> lock(socketMutex);
+    if (shard->socket != INVALID_SOCKET) {
+        shutdown(shard->socket, SD_BOTH);
     }
-    
-    // Parse URL
-    size_t hostStart = wsUrl.find("://");
-    if (hostStart == std::string::npos) {
-        log("[ERROR] Invalid URL");
-        return;
-    }
-    hostStart += 3;
-    
-    std::string host = wsUrl.substr(hostStart);
-    size_t pathPos = host.find('/');
-    if (pathPos != std::string::npos) {
-        host = host.substr(0, pathPos);
-    }
-    
-    log("[INFO] Connecting to: " + host);
-    
-    // Create socket
-    struct addrinfo hints = {0}, *result = NULL;
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
-    
-    if (getaddrinfo(host.c_str(), "443", &hints, &result) != 0) {
-        log("[ERROR] DNS resolution failed");
-        return;
+}
+
+void DiscordBot::connectWebSocket(DiscordShard* shard) {
+    // Resume on the host Discord handed us in READY when we still have a session
+    bool resuming = !shard->sessionId.empty();
+    std::string host = (resuming && !shard->resumeHost.empty()) ? shard->resumeHost : gatewayHost;
+    
+    log("[INFO] Shard " + std::to_string(shard->id) + " connecting to: " + host);
+    
+    // Discord's gateway URLs carry no port; a mock server's may ("wss://127.0.0.1:<port>")
+    std::string port = "443";
+    size_t portStart = host.find(':');
+    if (portStart != std::string::npos) {
+        port = host.substr(portStart + 1);
+        host.erase(portStart);
     }
     
-    SOCKET sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    // Resolve (cached) and race the IPv6/IPv4 addresses
+    ULONGLONG connectStart = GetTickCount64();
+    SOCKET sock = NetConnect(host, port);
     if (sock == INVALID_SOCKET) {
-        log("[ERROR] Socket creation failed");
-        freeaddrinfo(result);
+        log(WSAGetLastError() == WSAHOST_NOT_FOUND ? "[ERROR] DNS resolution failed" : "[ERROR] Connection failed");
         return;
     }
     
     // Store socket so Stop button can close it
     {
         std::lock_guard<std::mutex> lock(socketMutex);
-        currentSocket = sock;
+        shard->socket = sock;
     }
     
     // Set timeouts - longer timeout since heartbeats keep connection alive
@@ -264,18 +400,12 @@ void DiscordBot::connectWebSocket() {
     setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
     setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeout, sizeof(timeout));
     
-    if (connect(sock, result->ai_addr, (int)result->ai_addrlen) == SOCKET_ERROR) {
-        log("[ERROR] Connection failed");
-        closesocket(sock);
-        freeaddrinfo(result);
-        return;
-    }
-    
-    freeaddrinfo(result);
-    log("[INFO] TCP connected, starting TLS handshake...");
+    log("[INFO] TCP connected in " + std::to_string(GetTickCount64() - connectStart) +
+        "ms, starting TLS handshake...");
     
     // Create Schannel SSL context
     SchannelContext* ssl = SchannelCreate(sock);
+    ULONGLONG handshakeStart = GetTickCount64();
     if (!SchannelHandshake(ssl, host.c_str())) {
         log("[ERROR] TLS handshake failed");
         SchannelDestroy(ssl);
@@ -283,6 +413,8 @@ void DiscordBot::connectWebSocket() {
         return;
     }
     
+    log("[DEBUG] TLS handshake took " + std::to_string(GetTickCount64() - handshakeStart) + "ms" +
+        (SchannelSessionResumed(ssl) ? " (session resumed)" : " (full handshake)"));
     log("[INFO] TLS established, performing WebSocket handshake...");
     
     // WebSocket handshake
@@ -303,7 +435,7 @@ void DiscordBot::connectWebSocket() {
     
     // Wait for HELLO
     log("[DEBUG] Waiting for HELLO message...");
-    std::string helloMsg = recvWSFrame(ssl);
+    std::string helloMsg = recvWSFrame(ssl, shard->sendMutex);
     if (helloMsg.empty()) {
         log("[ERROR] No HELLO received");
         SchannelDestroy(ssl);
@@ -315,37 +447,36 @@ void DiscordBot::connectWebSocket() {
     log("[DEBUG] HELLO content: " + helloMsg.substr(0, 200) + "...");
     
     // Parse heartbeat interval
-    int heartbeatInterval = 41250;
-    size_t hbPos = helloMsg.find("heartbeat_interval");
-    if (hbPos != std::string::npos) {
-        size_t colonPos = helloMsg.find(':', hbPos);
-        if (colonPos != std::string::npos) {
-            size_t numStart = colonPos + 1;
-            while (numStart < helloMsg.length() && !isdigit(helloMsg[numStart])) numStart++;
-            size_t numEnd = numStart;
-            while (numEnd < helloMsg.length() && isdigit(helloMsg[numEnd])) numEnd++;
-            if (numEnd > numStart) {
-                heartbeatInterval = std::stoi(helloMsg.substr(numStart, numEnd - numStart));
-            }
-        }
-    }
+    int heartbeatInterval = extractJsonInt(helloMsg, "heartbeat_interval", 41250);
     
     log("[INFO] Heartbeat interval: " + std::to_string(heartbeatInterval) + "ms");
     
-    // Send IDENTIFY
-    sendIdentify(ssl);
+    if (resuming) {
+        sendResume(ssl, shard);
+    } else {
+        // Send IDENTIFY (rate limited per max_concurrency bucket)
+        if (waitForIdentifySlot(shard)) sendIdentify(ssl, shard);
+    }
     
-    // Start heartbeat thread
-    std::atomic<bool> hbRunning(true);
-    std::thread hbThread([this, ssl, heartbeatInterval, &hbRunning]() {
+    // Heartbeat scheduler: first beat after a random fraction of the interval, then
+    // one per interval. A beat that falls due while the previous one is still
+    // unacknowledged means a zombie connection, so drop it and resume straight away.
+    HANDLE connClosed = CreateEvent(NULL, TRUE, FALSE, NULL);
+    shard->awaitingAck = false;
+    std::thread hbThread([this, ssl, shard, heartbeatInterval, connClosed]() {
         log("[DEBUG] Heartbeat thread started");
-        while (hbRunning && running) {
-            // Send heartbeat first
-            log("[DEBUG] Sending heartbeat...");
-            sendHeartbeat(ssl, heartbeatInterval);
-            
-            // Then wait for next interval
-            Sleep(heartbeatInterval);
+        HANDLE waits[2] = { stopEvent, connClosed };
+        DWORD delay = randomDelay((DWORD)heartbeatInterval);
+        
+        while (WaitForMultipleObjects(2, waits, FALSE, delay) == WAIT_TIMEOUT) {
+            if (shard->awaitingAck) {
+                log("[WARNING] Shard " + std::to_string(shard->id) + " missed heartbeat ACK, resuming connection");
+                shard->resumeNow = true;
+                dropConnection(shard);
+                break;
+            }
+            sendHeartbeat(ssl, shard);
+            delay = (DWORD)heartbeatInterval;
         }
         log("[DEBUG] Heartbeat thread stopped");
     });
@@ -353,10 +484,8 @@ void DiscordBot::connectWebSocket() {
     log("[INFO] Entering main message loop...");
     
     // Main message loop
-    int messageCount = 0;
     while (running) {
-        log("[DEBUG] Waiting for next message... (count: " + std::to_string(messageCount) + ")");
-        std::string msg = recvWSFrame(ssl);
+        std::string msg = recvWSFrame(ssl, shard->sendMutex);
         
         if (msg.empty()) {
             log("[ERROR] Connection lost (empty message received)");
@@ -365,14 +494,13 @@ void DiscordBot::connectWebSocket() {
             break;
         }
         
-        messageCount++;
-        log("[DEBUG] Message #" + std::to_string(messageCount) + " received, length: " + std::to_string(msg.length()));
-        handleGatewayMessage(msg, ssl);
+        handleGatewayMessage(msg, shard, ssl);
     }
     
     log("[INFO] Exiting main message loop");
-    hbRunning = false;
+    SetEvent(connClosed);
     if (hbThread.joinable()) hbThread.join();
+    CloseHandle(connClosed);
     
     SchannelDestroy(ssl);
     closesocket(sock);
@@ -380,196 +508,362 @@ void DiscordBot::connectWebSocket() {
     // Clear socket handle
     {
         std::lock_guard<std::mutex> lock(socketMutex);
-        currentSocket = INVALID_SOCKET;
+        shard->socket = INVALID_SOCKET;
     }
 }
 
-void DiscordBot::sendHeartbeat(SchannelContext* ssl, int interval) {
-    std::string hb = "{\"op\":1,\"d\":";
-    hb += (sequenceNumber > 0) ? std::to_string(sequenceNumber) : "null";
-    hb += "}";
-    sendWSFrame(ssl, hb);
+void DiscordBot::sendHeartbeat(SchannelContext* ssl, DiscordShard* shard) {
+    // Called from both the heartbeat and read threads, so each gets its own buffer
+    static thread_local std::string hb;
+    hb.clear();
+    
+    JsonWriter writer(hb);
+    writer.beginObject().key("op").number(1).key("d");
+    int seq = shard->sequenceNumber;
+    if (seq > 0) writer.number(seq); else writer.null();
+    writer.endObject();
+    
+    shard->heartbeatSentAt = GetTickCount64();
+    shard->awaitingAck = true;
+    sendWSFrame(ssl, hb, shard->sendMutex);
 }
 
-void DiscordBot::sendIdentify(SchannelContext* ssl) {
-    log("[INFO] Sending IDENTIFY...");
+void DiscordBot::sendIdentify(SchannelContext* ssl, DiscordShard* shard) {
+    log("[INFO] Sending IDENTIFY for shard " + std::to_string(shard->id) + "/" + std::to_string(shardCount) + "...");
     
     // Intents: GUILDS (1) + GUILD_MESSAGES (512) + MESSAGE_CONTENT (32768) = 33281
-    std::string identify = "{\"op\":2,\"d\":{";
-    identify += "\"token\":\"" + token + "\",";
-    identify += "\"intents\":33281,";
-    identify += "\"properties\":{";
-    identify += "\"os\":\"windows\",";
-    identify += "\"browser\":\"kindroid_bot\",";
-    identify += "\"device\":\"kindroid_bot\"";
-    identify += "}}}";
+    std::string identify;
+    identify.reserve(256 + token.size()); // One allocation instead of one per doubling
+    JsonWriter writer(identify);
+    writer.beginObject().key("op").number(2).key("d").beginObject();
+    writer.key("token").string(token);
+    writer.key("intents").number(33281);
+    writer.key("shard").beginArray().number(shard->id).number(shardCount).endArray();
+    writer.key("properties").beginObject();
+    writer.key("os").string("windows");
+    writer.key("browser").string("kindroid_bot");
+    writer.key("device").string("kindroid_bot");
+    writer.endObject().endObject().endObject();
     
     log("[DEBUG] IDENTIFY payload: " + identify);
     
-    bool sent = sendWSFrame(ssl, identify);
+    bool sent = sendWSFrame(ssl, identify, shard->sendMutex);
     log("[DEBUG] IDENTIFY send result: " + std::to_string(sent));
 }
 
-void DiscordBot::sendResume(SchannelContext* ssl) {
-    log("[INFO] Sending RESUME...");
-    
-    std::string resume = "{\"op\":6,\"d\":{";
-    resume += "\"token\":\"" + token + "\",";
-    resume += "\"session_id\":\"" + sessionId + "\",";
-    resume += "\"seq\":" + std::to_string(sequenceNumber);
-    resume += "}}";
+void DiscordBot::sendResume(SchannelContext* ssl, DiscordShard* shard) {
+    log("[INFO] Sending RESUME for shard " + std::to_string(shard->id) + "...");
+    
+    std::string resume;
+    resume.reserve(96 + token.size() + shard->sessionId.size());
+    JsonWriter writer(resume);
+    writer.beginObject().key("op").number(6).key("d").beginObject();
+    writer.key("token").string(token);
+    writer.key("session_id").string(shard->sessionId);
+    writer.key("seq").number(shard->sequenceNumber);
+    writer.endObject().endObject();
+    
+    sendWSFrame(ssl, resume, shard->sendMutex);
+}
+
+// Frame head of a gateway payload: op, s and t, read without touching "d"
+struct GatewayFrameHead {
+    int op;
+    int seq;
+    size_t typeStart; // Event name span inside the frame ("t"), empty if null
+    size_t typeLen;
+};
+
+static bool peekGatewayFrame(const std::string& frame, GatewayFrameHead& head) {
+    head.op = -1;
+    head.seq = -1;
+    head.typeStart = 0;
+    head.typeLen = 0;
+    
+    size_t pos = frame.find('{');
+    if (pos == std::string::npos) return false;
+    pos++;
+    
+    // Discord sends t, s, op before d, so this normally stops before the payload body
+    bool haveOp = false, haveSeq = false, haveType = false;
+    size_t len = frame.length();
+    while (pos < len && !(haveOp && haveSeq && haveType)) {
+        while (pos < len && frame[pos] != '"' && frame[pos] != '}') pos++;
+        if (pos >= len || frame[pos] == '}') break;
+        
+        size_t keyStart = pos + 1;
+        size_t keyEnd = SimpleJSON::skipValue(frame, pos) - 1;
+        if (keyEnd >= len) break;
+        pos = keyEnd + 1;
+        while (pos < len && (frame[pos] == ':' || frame[pos] == ' ')) pos++;
+        size_t valueEnd = SimpleJSON::skipValue(frame, pos);
+        
+        size_t keyLen = keyEnd - keyStart;
+        if (keyLen == 2 && frame[keyStart] == 'o' && frame[keyStart + 1] == 'p') {
+            head.op = atoi(frame.c_str() + pos);
+            haveOp = true;
+        } else if (keyLen == 1 && frame[keyStart] == 's') {
+            if (frame[pos] != 'n') head.seq = atoi(frame.c_str() + pos);
+            haveSeq = true;
+        } else if (keyLen == 1 && frame[keyStart] == 't') {
+            if (frame[pos] == '"' && valueEnd > pos + 1) {
+                head.typeStart = pos + 1;
+                head.typeLen = valueEnd - pos - 2;
+            }
+            haveType = true;
+        }
+        
+        pos = valueEnd;
+        while (pos < len && frame[pos] != ',' && frame[pos] != '}') pos++;
+        if (pos < len && frame[pos] == ',') pos++;
+    }
     
-    sendWSFrame(ssl, resume);
+    return haveOp;
+}
+
+// Dispatch events the bot acts on; everything else is dropped before parsing
+static bool isHandledEvent(const std::string& frame, const GatewayFrameHead& head) {
+    static const char* const handled[] = {
+        "READY", "RESUMED", "MESSAGE_CREATE", "MESSAGE_UPDATE", "MESSAGE_DELETE",
+        "GUILD_CREATE", "GUILD_UPDATE", "GUILD_DELETE",
+        "CHANNEL_CREATE", "CHANNEL_UPDATE", "CHANNEL_DELETE",
+        "THREAD_CREATE", "THREAD_UPDATE", "THREAD_DELETE",
+    };
+    for (const char* name : handled) {
+        if (strlen(name) == head.typeLen && frame.compare(head.typeStart, head.typeLen, name) == 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void DiscordBot::handleGatewayMessage(const std::string& message, SchannelContext* ssl) {
-    log("[DEBUG] Received gateway message (length: " + std::to_string(message.length()) + ")");
+// The MESSAGE_CREATE fields we read, pulled out of the frame in one pass
+// (d.mentions is checked separately by the pre-filter)
+enum MessageField {
+    MSG_CONTENT, MSG_USERNAME, MSG_AUTHOR_ID, MSG_CHANNEL_ID, MSG_GUILD_ID, MSG_ID,
+    MESSAGE_FIELD_COUNT
+};
+static constexpr JsonPathSet<MESSAGE_FIELD_COUNT> MESSAGE_FIELDS({
+    "d.content", "d.author.username", "d.author.id", "d.channel_id", "d.guild_id", "d.id"
+});
+static constexpr JsonPathSet<1> MENTIONS_FIELD({ "d.mentions" });
+
+// MESSAGE_UPDATE / MESSAGE_DELETE: which message
+enum MessageRefField { REF_ID, REF_CHANNEL_ID, MESSAGE_REF_FIELD_COUNT };
+static constexpr JsonPathSet<MESSAGE_REF_FIELD_COUNT> MESSAGE_REF_FIELDS({ "d.id", "d.channel_id" });
+
+bool DiscordBot::mentionsBot(const std::string& frame) {
+    std::string needle;
+    std::shared_ptr<const MentionMatcher> matcher;
+    bool aliases;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        needle = mentionNeedle;
+        matcher = mentionMatcher;
+        aliases = !mentionAliases.empty();
+    }
+    if (needle.empty()) return true; // READY not seen yet - let the full parser decide
+    if (triggers.hasTriggers()) return true; // Keyword rules need to see every message
     
-    // Skip empty messages
-    if (message.empty()) {
-        log("[DEBUG] Empty message, skipping");
-        return;
+    JsonSpan mentions[1];
+    if (MENTIONS_FIELD.extract(frame, mentions)) {
+        size_t hit = frame.find(needle, mentions[0].start);
+        if (hit != std::string::npos && hit < mentions[0].end) return true;
     }
     
-    // Extract opcode directly from JSON string (more reliable than our simple parser)
-    int op = -1;
-    size_t opPos = message.find("\"op\":");
-    if (opPos != std::string::npos) {
-        size_t numStart = opPos + 5;
-        while (numStart < message.length() && !isdigit(message[numStart]) && message[numStart] != '-') numStart++;
-        if (numStart < message.length()) {
-            size_t numEnd = numStart;
-            while (numEnd < message.length() && (isdigit(message[numEnd]) || message[numEnd] == '-')) numEnd++;
-            if (numEnd > numStart) {
-                try {
-                    op = std::stoi(message.substr(numStart, numEnd - numStart));
-                } catch (...) {
-                    log("[DEBUG] Failed to parse opcode");
-                }
-            }
-        }
+    // A typed "@alias" is plain text to Discord and never lands in d.mentions;
+    // a hit anywhere in the frame is enough to hand it to the full parser
+    return aliases && matcher && matcher->matches(frame);
+}
+
+// Mentioned (or a trigger rule matched) and no ignore rule; content comes back with
+// the mention(s) removed, and false if nothing is left to answer
+bool DiscordBot::isAddressed(std::string& content, const std::string& channelId, bool startCooldown) {
+    std::shared_ptr<const MentionMatcher> matcher;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        matcher = mentionMatcher;
     }
     
-    if (op == -1) {
+    // Check for a mention of this bot (<@id>, <@!id> or an @alias), not just any user or role;
+    // trigger rules can stand in for one, ignore rules veto both
+    bool mentioned = matcher && matcher->matches(content);
+    TriggerRules::Result rule = triggers.evaluate(content, channelId, !mentioned, startCooldown);
+    if (rule == TriggerRules::IGNORED || (!mentioned && rule != TriggerRules::TRIGGERED)) return false;
+    
+    // Remove mention(s) and trim
+    if (matcher) content = matcher->strip(content);
+    return !content.empty();
+}
+
+void DiscordBot::handleGatewayMessage(const std::string& message, DiscordShard* shard, SchannelContext* ssl) {
+    GatewayFrameHead head;
+    if (!peekGatewayFrame(message, head)) {
         // Log first part of message to help debug
         int previewLen = (message.length() < 100) ? (int)message.length() : 100;
         log("[DEBUG] No opcode found in message: " + message.substr(0, previewLen));
         return;
     }
     
-    log("[DEBUG] Gateway opcode: " + std::to_string(op));
+    // Track sequence even for events we skip, so heartbeats and RESUME stay correct
+    if (head.seq > 0) {
+        shard->sequenceNumber = head.seq;
+    }
     
-    // Extract sequence number
-    size_t seqPos = message.find("\"s\":");
-    if (seqPos != std::string::npos) {
-        size_t numStart = seqPos + 4;
-        while (numStart < message.length() && !isdigit(message[numStart]) && message[numStart] != 'n') numStart++;
-        if (numStart < message.length() && message[numStart] != 'n') { // not "null"
-            size_t numEnd = numStart;
-            while (numEnd < message.length() && isdigit(message[numEnd])) numEnd++;
-            if (numEnd > numStart) {
-                sequenceNumber = std::stoi(message.substr(numStart, numEnd - numStart));
+    if (head.op == 0) {
+        if (!isHandledEvent(message, head)) {
+            skippedEvents++;
+            return;
+        }
+        // Only messages that actually mention the bot reach the full parser
+        if (head.typeLen == 14 && message.compare(head.typeStart, 14, "MESSAGE_CREATE") == 0 &&
+            !mentionsBot(message)) {
+            skippedEvents++;
+            return;
+        }
+        // Edits and deletes only matter while a reply to that message is queued or running
+        if (head.typeLen == 14 && (message.compare(head.typeStart, 14, "MESSAGE_UPDATE") == 0 ||
+                                   message.compare(head.typeStart, 14, "MESSAGE_DELETE") == 0)) {
+            JsonSpan ref[MESSAGE_REF_FIELD_COUNT];
+            MESSAGE_REF_FIELDS.extract(message, ref);
+            if (!replies.hasMessage(ref[REF_CHANNEL_ID].text(message), ref[REF_ID].text(message))) {
+                skippedEvents++;
+                return;
             }
         }
     }
+    handledEvents++;
+    
+    int op = head.op;
+    log("[DEBUG] Gateway opcode: " + std::to_string(op) + " (length: " + std::to_string(message.length()) + ")");
     
     switch (op) {
         case 0: { // Dispatch - need braces for variable declarations
-            log("[INFO] Dispatch event received");
-            
-            // Extract event type
-            std::string eventType;
-            size_t tPos = message.find("\"t\":");
-            if (tPos != std::string::npos) {
-                size_t strStart = message.find('"', tPos + 4) + 1;
-                size_t strEnd = message.find('"', strStart);
-                eventType = message.substr(strStart, strEnd - strStart);
-            }
-            
-            log("[INFO] Event type: " + eventType);
+            std::string eventType = message.substr(head.typeStart, head.typeLen);
+            log("[DEBUG] Event type: " + eventType);
             
             if (eventType == "READY") {
                 log("[INFO] Bot is READY!");
+                shard->reconnect.connected();
                 // Extract session_id
                 size_t sessPos = message.find("\"session_id\":");
                 if (sessPos != std::string::npos) {
                     size_t start = message.find('"', sessPos + 13) + 1;
                     size_t end = message.find('"', start);
-                    sessionId = message.substr(start, end - start);
-                    log("[INFO] Session ID: " + sessionId);
+                    shard->sessionId = message.substr(start, end - start);
+                    log("[INFO] Shard " + std::to_string(shard->id) + " session ID: " + shard->sessionId);
                 }
-            } else if (eventType == "MESSAGE_CREATE") {
-                log("[INFO] MESSAGE_CREATE event received");
                 
-                // Extract content
-                std::string content;
-                size_t contentPos = message.find("\"content\":\"");
-                if (contentPos != std::string::npos) {
-                    size_t start = contentPos + 11;
-                    size_t end = message.find('"', start);
-                    // Handle escaped quotes in content
-                    while (end != std::string::npos && end > 0 && message[end - 1] == '\\') {
-                        end = message.find('"', end + 1);
-                    }
-                    std::string rawContent = message.substr(start, end - start);
-                    // Unescape the JSON string
-                    content = SimpleJSON::unescape(rawContent);
+                // Resume later on the host Discord gives us for this session
+                std::string resumeUrl = SimpleJSON::getMemberString(SimpleJSON::getMember(message, "d"), "resume_gateway_url");
+                size_t schemeEnd = resumeUrl.find("://");
+                if (schemeEnd != std::string::npos) {
+                    std::string resumeHost = resumeUrl.substr(schemeEnd + 3);
+                    shard->resumeHost = resumeHost.substr(0, resumeHost.find('/'));
                 }
                 
-                // Extract author username
-                std::string username = "unknown";
-                size_t userPos = message.find("\"author\":");
-                if (userPos != std::string::npos) {
-                    size_t unamePos = message.find("\"username\":\"", userPos);
-                    if (unamePos != std::string::npos) {
-                        size_t start = unamePos + 12;
-                        size_t end = message.find('"', start);
-                        username = message.substr(start, end - start);
-                    }
+                // Remember our own user ID for the mention pre-filter
+                std::string user = SimpleJSON::getMember(SimpleJSON::getMember(message, "d"), "user");
+                std::string userId = SimpleJSON::getMemberString(user, "id");
+                if (!userId.empty()) {
+                    auto matcher = std::make_shared<MentionMatcher>();
+                    matcher->addUserId(userId);
+                    
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    matcher->addNames(mentionAliases);
+                    botUserId = userId;
+                    mentionNeedle = "\"id\":\"" + userId + "\"";
+                    mentionMatcher = matcher;
                 }
+            } else if (eventType == "RESUMED") {
+                log("[INFO] Shard " + std::to_string(shard->id) + " resumed session");
+                shard->reconnect.connected();
+            } else if (eventType == "GUILD_CREATE" || eventType == "GUILD_UPDATE") {
+                guildCache.onGuild(SimpleJSON::getMember(message, "d"));
+            } else if (eventType == "GUILD_DELETE") {
+                guildCache.onGuildDelete(SimpleJSON::getMember(message, "d"));
+            } else if (eventType == "CHANNEL_CREATE" || eventType == "CHANNEL_UPDATE" ||
+                       eventType == "THREAD_CREATE" || eventType == "THREAD_UPDATE") {
+                guildCache.onChannel(SimpleJSON::getMember(message, "d"));
+            } else if (eventType == "CHANNEL_DELETE" || eventType == "THREAD_DELETE") {
+                guildCache.onChannelDelete(SimpleJSON::getMember(message, "d"));
+            } else if (eventType == "MESSAGE_CREATE") {
+                log("[INFO] MESSAGE_CREATE event received");
                 
-                // Extract channel ID
-                std::string channelId;
-                size_t chanPos = message.find("\"channel_id\":\"");
-                if (chanPos != std::string::npos) {
-                    size_t start = chanPos + 14;
-                    size_t end = message.find('"', start);
-                    channelId = message.substr(start, end - start);
-                }
+                JsonSpan fields[MESSAGE_FIELD_COUNT];
+                MESSAGE_FIELDS.extract(message, fields);
+                
+                std::string content = fields[MSG_CONTENT].text(message);
+                std::string username = fields[MSG_USERNAME].text(message);
+                if (username.empty()) username = "unknown";
+                std::string channelId = fields[MSG_CHANNEL_ID].text(message);
+                std::string authorId = fields[MSG_AUTHOR_ID].text(message);
+                std::string messageId = fields[MSG_ID].text(message);
                 
                 log("[DEBUG] Content length: " + std::to_string(content.length()) + " bytes");
                 log("[DEBUG] Username: " + username);
-                log("[DEBUG] Channel: " + channelId);
+                log("[DEBUG] Channel: " + channelId + " (guild " + fields[MSG_GUILD_ID].text(message) + ")");
                 
-                // Check for bot mention
-                if (content.find("<@") != std::string::npos) {
-                    // Remove mention
-                    size_t mentionEnd = content.find('>', content.find("<@"));
-                    if (mentionEnd != std::string::npos) {
-                        content = content.substr(mentionEnd + 1);
-                    }
+                // Never answer our own posts (a reply that quotes the mention would loop)
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    if (!botUserId.empty() && authorId == botUserId) break;
                     
-                    // Trim
-                    size_t start = content.find_first_not_of(" \t\n\r");
-                    if (start != std::string::npos) {
-                        content = content.substr(start);
-                    }
-                    
-                    if (!content.empty()) {
-                        log("[DISCORD] " + username + ": " + content);
-                        
-                        // Fetch actual channel and server names
-                        auto [channelName, serverName] = getChannelInfo(channelId);
-                        std::string contextName = serverName + " / #" + channelName;
-                        
-                        std::string response = kindroid->sendMessage(username, contextName, content);
-                        
-                        log("[KINDROID] " + response);
-                        
-                        if (!response.empty() && response.find("[ERROR]") == std::string::npos) {
-                            sendDiscordMessage(channelId, response);
-                        }
+                    // Track last active channel for announcements (messages past the pre-filter)
+                    lastChannelId = channelId;
+                }
+                
+                if (!isAddressed(content, channelId, true)) break;
+                
+                // A full lane would drop the reply, so check before the cooldown is spent
+                if (!replies.hasRoom(channelId)) {
+                    log("[WARNING] Reply queue for channel " + channelId + " is full, ignoring " + username);
+                    break;
+                }
+                
+                // Cooldowns before anything is scheduled: every reply is a Kindroid call
+                if (!cooldowns.tryAcquire(CooldownTable::makeKey("discord", channelId, authorId), userCooldownMs,
+                                          CooldownTable::makeKey("discord", channelId, ""), channelCooldownMs)) {
+                    log("[DEBUG] " + username + " in " + channelId + " is on cooldown, ignoring");
+                    break;
+                }
+                
+                log("[DISCORD] " + username + ": " + content);
+                
+                // Ask Kindroid off the gateway thread, in order per channel; the reply goes
+                // through the outbox. Indexed by message ID so edits and deletes can reach it.
+                if (!replies.enqueue(channelId, authorId, messageId, replyWork(username, channelId, content))) {
+                    log("[WARNING] Reply queue for channel " + channelId + " is full, ignoring " + username);
+                }
+            } else if (eventType == "MESSAGE_DELETE") {
+                JsonSpan ref[MESSAGE_REF_FIELD_COUNT];
+                MESSAGE_REF_FIELDS.extract(message, ref);
+                std::string messageId = ref[REF_ID].text(message);
+                if (replies.cancelMessage(ref[REF_CHANNEL_ID].text(message), messageId) > 0) {
+                    log("[INFO] Message " + messageId + " was deleted, reply cancelled");
+                }
+            } else if (eventType == "MESSAGE_UPDATE") {
+                JsonSpan fields[MESSAGE_FIELD_COUNT];
+                MESSAGE_FIELDS.extract(message, fields);
+                
+                // Embed unfurls arrive as updates without content; only a text edit matters
+                if (!fields[MSG_CONTENT].found()) break;
+                
+                std::string content = fields[MSG_CONTENT].text(message);
+                std::string username = fields[MSG_USERNAME].text(message);
+                if (username.empty()) username = "unknown";
+                std::string channelId = fields[MSG_CHANNEL_ID].text(message);
+                std::string messageId = fields[MSG_ID].text(message);
+                
+                // The original already paid its cooldowns; the edit only decides whether to answer
+                if (!isAddressed(content, channelId, false)) {
+                    if (replies.cancelMessage(channelId, messageId) > 0) {
+                        log("[INFO] Message " + messageId + " was edited to no longer ask, reply cancelled");
                     }
+                    break;
+                }
+                if (replies.replaceMessage(channelId, messageId, replyWork(username, channelId, content))) {
+                    log("[DISCORD] " + username + " (edited): " + content);
                 }
             }
             break;
@@ -577,315 +871,257 @@ void DiscordBot::handleGatewayMessage(const std::string& message, SchannelContex
             
         case 1: // Heartbeat
             log("[DEBUG] Heartbeat requested by server");
-            sendHeartbeat(ssl, 41250);
+            sendHeartbeat(ssl, shard);
             break;
             
         case 7: // Reconnect
             log("[INFO] Discord requested reconnect");
-            shouldReconnect = true;
+            shard->resumeNow = true;
+            dropConnection(shard);
             break;
             
-        case 9: // Invalid session
-            log("[WARNING] Invalid session");
-            sessionId.clear();
-            Sleep(1000);
+        case 9: { // Invalid session - "d" says whether it can be resumed
+            bool resumable = SimpleJSON::getMember(message, "d") == "true";
+            log(std::string("[WARNING] Invalid session (") + (resumable ? "resumable" : "not resumable") + ")");
+            
+            // Discord asks for a random 1-5 second wait before trying again
+            if (WaitForSingleObject(stopEvent, 1000 + randomDelay(4000)) != WAIT_TIMEOUT) break;
+            if (resumable && !shard->sessionId.empty()) {
+                sendResume(ssl, shard);
+            } else {
+                shard->sessionId.clear();
+                if (waitForIdentifySlot(shard)) sendIdentify(ssl, shard);
+            }
             break;
+        }
             
         case 10: // Hello
             log("[DEBUG] Hello opcode received");
             break;
             
-        case 11: // Heartbeat ACK
-            log("[DEBUG] Heartbeat ACK received");
+        case 11: { // Heartbeat ACK
+            int rtt = (int)(GetTickCount64() - shard->heartbeatSentAt);
+            shard->rttMs = rtt;
+            shard->awaitingAck = false;
+            log("[DEBUG] Heartbeat ACK received (rtt: " + std::to_string(rtt) + "ms)");
             break;
+        }
             
         default:
             log("[WARNING] Unknown opcode: " + std::to_string(op));
     }
 }
 
-void DiscordBot::handleDispatch(const std::map<std::string, std::string>& data) {
-    std::string eventType = SimpleJSON::getString(data, "t");
-    
-    log("[INFO] Dispatch event type: " + eventType);
+std::pair<std::string, std::string> DiscordBot::getChannelInfo(const std::string& channelId) {
+    // Names come from the gateway-fed cache; never block the reply path on REST
+    std::string channelName, serverName;
+    if (guildCache.lookup(channelId, channelName, serverName)) {
+        if (channelName.empty()) channelName = "unknown-channel";
+        if (serverName.empty()) serverName = "unknown-server";
+        return {channelName, serverName};
+    }
     
-    if (eventType == "READY") {
-        log("[INFO] Bot is READY!");
-        std::string dField = SimpleJSON::getString(data, "d");
-        size_t sessPos = dField.find("session_id");
-        if (sessPos != std::string::npos) {
-            size_t start = dField.find('"', sessPos + 12) + 1;
-            size_t end = dField.find('"', start);
-            sessionId = dField.substr(start, end - start);
-            log("[INFO] Session ID: " + sessionId);
+    // Not seen in a dispatch yet (e.g. DMs or threads): backfill in the background,
+    // once per channel, on the single backfill worker
+    bool queue;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queue = pendingLookups.insert(channelId).second;
+    }
+    if (queue) {
+        auto lookup = [this, channelId](const std::atomic<bool>&) { backfillChannelInfo(channelId); };
+        if (!backfills.enqueue("backfill", "", "", lookup)) {
+            // Backlog full: forget it so a later miss can try again
+            std::lock_guard<std::mutex> lock(stateMutex);
+            pendingLookups.erase(channelId);
         }
-    } else if (eventType == "MESSAGE_CREATE") {
-        log("[INFO] MESSAGE_CREATE event received");
-        std::string dField = SimpleJSON::getString(data, "d");
-        auto messageData = SimpleJSON::parseObject(dField);
-        processMessage(messageData);
-    } else {
-        log("[DEBUG] Unhandled event: " + eventType);
     }
+    
+    return {"unknown-channel", "unknown-server"};
 }
 
-void DiscordBot::processMessage(const std::map<std::string, std::string>& messageData) {
-    std::string content = SimpleJSON::getString(messageData, "content");
-    std::string authorField = SimpleJSON::getString(messageData, "author");
-    std::string channelId = SimpleJSON::getString(messageData, "channel_id");
-    
-    // Track last active channel for announcements
-    lastChannelId = channelId;
+void DiscordBot::backfillChannelInfo(const std::string& channelId) {
+    auto startTime = std::chrono::steady_clock::now();
     
-    // Extract username
-    std::string username = "unknown";
-    size_t unPos = authorField.find("\"username\"");
-    if (unPos != std::string::npos) {
-        size_t start = authorField.find('"', unPos + 11) + 1;
-        size_t end = authorField.find('"', start);
-        username = authorField.substr(start, end - start);
-    }
-    
-    log("[DEBUG] Message from " + username + " in channel " + channelId);
-    
-    // Check for bot mention
-    if (content.find("<@") == std::string::npos) {
-        log("[DEBUG] Message doesn't mention bot, ignoring");
-        return;
-    }
-    
-    log("[DEBUG] Bot was mentioned!");
+    std::string response = httpRequest("discord.com", "/api/v10/channels/" + channelId);
+    std::string channelName = SimpleJSON::getMemberString(response, "name");
+    std::string guildId = SimpleJSON::getMemberString(response, "guild_id");
     
-    // Remove mention
-    size_t mentionEnd = content.find('>', content.find("<@"));
-    if (mentionEnd != std::string::npos) {
-        content = content.substr(mentionEnd + 1);
+    std::string serverName;
+    if (!guildId.empty()) {
+        std::string guildResponse = httpRequest("discord.com", "/api/v10/guilds/" + guildId);
+        serverName = SimpleJSON::getMemberString(guildResponse, "name");
     }
     
-    // Trim
-    size_t start = content.find_first_not_of(" \t\n\r");
-    if (start != std::string::npos) {
-        content = content.substr(start);
-    }
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    guildCache.recordRestLookup((ULONGLONG)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
     
-    if (content.empty()) {
-        log("[DEBUG] Message empty after removing mention");
-        return;
+    if (!response.empty()) {
+        guildCache.setChannel(channelId, channelName, guildId, serverName);
+        log("[DEBUG] Backfilled channel " + channelId + " (#" + channelName + ")");
     }
     
-    log("[DISCORD] " + username + ": " + content);
-    
+    std::lock_guard<std::mutex> lock(stateMutex);
+    pendingLookups.erase(channelId);
+}
+
+ReplyQueue::Work DiscordBot::replyWork(const std::string& username, const std::string& channelId,
+                                       const std::string& content) {
+    return [this, username, channelId, content](const std::atomic<bool>& cancelled) {
+        replyToMessage(username, channelId, content, cancelled);
+    };
+}
+
+void DiscordBot::replyToMessage(const std::string& username, const std::string& channelId, const std::string& content,
+                                const std::atomic<bool>& cancelled) {
     // Fetch actual channel and server names
     auto [channelName, serverName] = getChannelInfo(channelId);
     std::string contextName = serverName + " / #" + channelName;
-    log("[DEBUG] Context: " + contextName);
     
-    log("[DEBUG] Sending to Kindroid API...");
+    // Kindroid can take several seconds; show that an answer is coming
+    typing.begin(channelId);
     std::string response = kindroid->sendMessage(username, contextName, content);
     
+    // Deleted or edited while Kindroid was answering; an edit has queued its own job
+    if (cancelled) {
+        typing.end(channelId);
+        log("[DEBUG] Reply to " + username + " in " + channelId + " cancelled, not sent");
+        return;
+    }
+    
     log("[KINDROID] " + response);
     
-    if (!response.empty() && response.find("[ERROR]") == std::string::npos) {
-        log("[DEBUG] Sending response to Discord...");
-        sendDiscordMessage(channelId, response);
-        log("[DEBUG] Response sent successfully");
+    if (response.empty() || response.find("[ERROR]") != std::string::npos) {
+        typing.end(channelId);
+        return;
     }
+    // Keep typing up while the reply waits in the outbox; posting it clears the
+    // indicator on Discord's side
+    sendDiscordMessage(channelId, response, [this, channelId]() { typing.end(channelId); });
 }
 
-std::pair<std::string, std::string> DiscordBot::getChannelInfo(const std::string& channelId) {
-    // Check cache first
-    std::string channelName = "unknown-channel";
-    std::string serverName = guildName.empty() ? "unknown-server" : guildName;
-    
-    auto it = channelNames.find(channelId);
-    if (it != channelNames.end()) {
-        channelName = it->second;
-        return {channelName, serverName};
+void DiscordBot::sendDiscordMessage(const std::string& channelId, const std::string& content,
+                                    DiscordOutbox::Done done) {
+    // Discord rejects anything over 2000 characters, so long replies go out in parts
+    std::vector<std::string> parts = splitMessage(content, 2000, true);
+    log("[DEBUG] Queueing " + std::to_string(content.length()) + " bytes in " +
+        std::to_string(parts.size()) + " part(s) for channel: " + channelId);
+    
+    if (parts.empty()) {
+        if (done) done();
+        return;
     }
-    
-    // Fetch from Discord API
-    std::string path = "/api/v10/channels/" + channelId;
-    std::string response = httpRequest("discord.com", path);
-    
-    if (!response.empty()) {
-        // Parse channel name
-        size_t namePos = response.find("\"name\":\"");
-        if (namePos != std::string::npos) {
-            size_t start = namePos + 8;
-            size_t end = response.find('"', start);
-            if (end != std::string::npos) {
-                channelName = response.substr(start, end - start);
-                // Cache it
-                channelNames[channelId] = channelName;
-            }
-        }
-        
-        // Parse guild_id to fetch server name if we don't have it
-        if (guildName.empty()) {
-            size_t guildPos = response.find("\"guild_id\":\"");
-            if (guildPos != std::string::npos) {
-                size_t start = guildPos + 12;
-                size_t end = response.find('"', start);
-                if (end != std::string::npos) {
-                    std::string guildId = response.substr(start, end - start);
-                    
-                    // Fetch guild info
-                    std::string guildPath = "/api/v10/guilds/" + guildId;
-                    std::string guildResponse = httpRequest("discord.com", guildPath);
-                    
-                    if (!guildResponse.empty()) {
-                        size_t gNamePos = guildResponse.find("\"name\":\"");
-                        if (gNamePos != std::string::npos) {
-                            size_t gStart = gNamePos + 8;
-                            size_t gEnd = guildResponse.find('"', gStart);
-                            if (gEnd != std::string::npos) {
-                                guildName = guildResponse.substr(gStart, gEnd - gStart);
-                                serverName = guildName;
-                            }
-                        }
-                    }
-                }
-            }
-        } else {
-            serverName = guildName;
-        }
+    for (size_t i = 0; i + 1 < parts.size(); i++) {
+        outbox.enqueue(channelId, parts[i]);
     }
-    
-    return {channelName, serverName};
+    outbox.enqueue(channelId, parts.back(), std::move(done));
+}
+
+// Discord's 429 body carries retry_after in (fractional) seconds
+static DWORD retryAfterMs(const std::string& response) {
+    double retryAfter = atof(SimpleJSON::getMember(response, "retry_after").c_str());
+    return (DWORD)(retryAfter * 1000.0) + 50;
 }
 
-void DiscordBot::sendDiscordMessage(const std::string& channelId, const std::string& content) {
-    log("[DEBUG] sendDiscordMessage called for channel: " + channelId);
+DWORD DiscordBot::postDiscordMessage(const std::string& channelId, const std::string& content) {
+    log("[DEBUG] postDiscordMessage called for channel: " + channelId);
     log("[DEBUG] Response length: " + std::to_string(content.length()) + " bytes");
     
-    std::map<std::string, std::string> payload;
-    payload["content"] = content;
-    std::string jsonPayload = SimpleJSON::buildObject(payload);
+    // Outbox workers post back to back, so the payload buffer is reused per thread
+    static thread_local std::string jsonPayload;
+    jsonPayload.clear();
+    JsonWriter(jsonPayload).beginObject().key("content").string(content).endObject();
     
     std::string path = "/api/v10/channels/" + channelId + "/messages";
+    std::string headers = "Authorization: Bot " + token + "\r\n"
+                          "Content-Type: application/json; charset=utf-8";
     
-    HINTERNET hSession = WinHttpOpen(L"KindroidBot/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME,
-        WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) {
-        log("[ERROR] WinHttpOpen failed");
-        return;
-    }
+    DWORD statusCode = 0;
+    std::string response = HttpClient::request("POST", "discord.com", path, headers, jsonPayload, &statusCode);
     
-    HINTERNET hConnect = WinHttpConnect(hSession, L"discord.com",
-        INTERNET_DEFAULT_HTTPS_PORT, 0);
-    if (!hConnect) {
-        log("[ERROR] WinHttpConnect failed");
-        WinHttpCloseHandle(hSession);
-        return;
+    if (statusCode == 0) {
+        log("[ERROR] Discord API request failed");
+        return DiscordOutbox::POST_FAILED;
     }
     
-    std::wstring wpath = stringToWstring(path);
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST", wpath.c_str(),
-        NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
-        WINHTTP_FLAG_SECURE);
-    if (!hRequest) {
-        log("[ERROR] WinHttpOpenRequest failed");
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return;
-    }
-    
-    std::string authHeader = "Authorization: Bot " + token;
-    std::string contentType = "Content-Type: application/json; charset=utf-8";
-    std::wstring headers = stringToWstring(authHeader + "\r\n" + contentType);
-    
-    BOOL sendResult = WinHttpSendRequest(hRequest, headers.c_str(), -1,
-        (LPVOID)jsonPayload.c_str(), (DWORD)jsonPayload.length(),
-        (DWORD)jsonPayload.length(), 0);
+    log("[DEBUG] Discord API response code: " + std::to_string(statusCode));
     
-    if (!sendResult) {
-        log("[ERROR] WinHttpSendRequest failed");
-        WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return;
+    if (statusCode == 429) {
+        DWORD delayMs = retryAfterMs(response);
+        log("[WARNING] Discord rate limited channel " + channelId + ", retrying in " +
+            std::to_string(delayMs) + "ms");
+        return delayMs;
     }
     
-    BOOL recvResult = WinHttpReceiveResponse(hRequest, NULL);
-    if (!recvResult) {
-        log("[ERROR] WinHttpReceiveResponse failed");
-    } else {
-        DWORD statusCode = 0;
-        DWORD statusCodeSize = sizeof(statusCode);
-        WinHttpQueryHeaders(hRequest, 
-            WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-            NULL, &statusCode, &statusCodeSize, NULL);
-        log("[DEBUG] Discord API response code: " + std::to_string(statusCode));
-        
-        if (statusCode != 200 && statusCode != 201) {
-            log("[ERROR] Discord API error: " + std::to_string(statusCode));
-        }
+    if (statusCode != 200 && statusCode != 201) {
+        log("[ERROR] Discord API error: " + std::to_string(statusCode));
+        return DiscordOutbox::POST_FAILED;
+    }
+    return 0;
+}
+
+DWORD DiscordBot::postTyping(const std::string& channelId) {
+    std::string path = "/api/v10/channels/" + channelId + "/typing";
+    
+    DWORD statusCode = 0;
+    std::string response = HttpClient::request("POST", "discord.com", path, "Authorization: Bot " + token, "",
+                                               &statusCode);
+    
+    // The delay goes to the outbox, which holds this channel's posts and typing alike
+    if (statusCode == 429) {
+        DWORD delayMs = retryAfterMs(response);
+        log("[DEBUG] Typing rate limited in channel " + channelId + ", next in " + std::to_string(delayMs) + "ms");
+        return delayMs;
     }
     
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
-    log("[DEBUG] sendDiscordMessage completed");
+    // Best effort: a missing indicator is not worth a retry
+    if (statusCode != 204 && statusCode != 200) {
+        log("[DEBUG] Typing indicator failed for channel " + channelId + " (" + std::to_string(statusCode) + ")");
+    }
+    return 0;
 }
 
 std::string DiscordBot::httpRequest(const std::string& host, const std::string& path) {
-    HINTERNET hSession = WinHttpOpen(L"KindroidBot/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME,
-        WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) return "";
-    
-    std::wstring whost = stringToWstring(host);
-    HINTERNET hConnect = WinHttpConnect(hSession, whost.c_str(),
-        INTERNET_DEFAULT_HTTPS_PORT, 0);
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
-        return "";
+    return HttpClient::request("GET", host, path, "Authorization: Bot " + token);
+}
+
+int DiscordBot::getGatewayRtt() {
+    int worst = -1;
+    std::lock_guard<std::mutex> lock(socketMutex);
+    for (auto& shard : shards) {
+        int rtt = shard->rttMs;
+        if (rtt > worst) worst = rtt;
     }
-    
-    std::wstring wpath = stringToWstring(path);
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET", wpath.c_str(),
-        NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
-        WINHTTP_FLAG_SECURE);
-    if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return "";
+    return worst;
+}
+
+void DiscordBot::setTriggerRules(const std::string& rulesText) {
+    for (const auto& problem : triggers.load(rulesText)) {
+        log("[WARNING] Trigger rules, " + problem);
     }
-    
-    std::string authHeader = "Authorization: Bot " + token;
-    std::wstring headers = stringToWstring(authHeader) + L"\r\n";
-    
-    WinHttpSendRequest(hRequest, headers.c_str(), -1,
-        WINHTTP_NO_REQUEST_DATA, 0, 0, 0);
-    WinHttpReceiveResponse(hRequest, NULL);
-    
-    std::string response;
-    DWORD dwSize, dwDownloaded;
-    do {
-        dwSize = 0;
-        WinHttpQueryDataAvailable(hRequest, &dwSize);
-        if (dwSize == 0) break;
-        
-        char* buf = new char[dwSize + 1];
-        ZeroMemory(buf, dwSize + 1);
-        
-        if (WinHttpReadData(hRequest, buf, dwSize, &dwDownloaded)) {
-            response.append(buf, dwDownloaded);
-        }
-        delete[] buf;
-    } while (dwSize > 0);
-    
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
-    
-    return response;
+    if (triggers.ruleCount() > 0) {
+        log("[INFO] Loaded " + std::to_string(triggers.ruleCount()) + " trigger rule(s)");
+    }
+}
+
+void DiscordBot::setMentionAliases(const std::string& aliasList) {
+    // Applied on READY, when the matcher is built around the bot's user ID
+    std::lock_guard<std::mutex> lock(stateMutex);
+    mentionAliases = aliasList;
+}
+
+void DiscordBot::setCooldowns(int userSecs, int channelSecs) {
+    userCooldownMs = userSecs > 0 ? (DWORD)userSecs * 1000 : 0;
+    channelCooldownMs = channelSecs > 0 ? (DWORD)channelSecs * 1000 : 0;
 }
 
 void DiscordBot::sendAnnouncement(const std::string& message, const std::string& channelId) {
     // Use provided channel ID, or fall back to last active channel
-    std::string targetChannel = channelId.empty() ? lastChannelId : channelId;
+    std::string targetChannel = channelId;
+    if (targetChannel.empty()) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        targetChannel = lastChannelId;
+    }
     
     if (targetChannel.empty()) {
         log("[ANNOUNCE] No channel available for announcement (configure Channel ID or wait for activity)");
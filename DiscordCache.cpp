@@ -0,0 +1,201 @@
+#include "KindroidBot.h"
+
+// ============================================
+// GuildCache - gateway-fed guild/channel names
+// ============================================
+
+GuildCache::GuildCache(size_t maxChannels, size_t maxGuilds)
+    : maxChannels(maxChannels), maxGuilds(maxGuilds),
+      hits(0), misses(0), restLookups(0), restMicros(0) {
+}
+
+void GuildCache::setLimits(size_t channelLimit, size_t guildLimit) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    maxChannels = channelLimit;
+    maxGuilds = guildLimit;
+}
+
+// Both maps evict in insertion order. Deletes unlink their entry from the order
+// list in the same step, so the list never holds ids that are gone.
+void GuildCache::insertGuildLocked(const std::string& guildId, const std::string& name) {
+    auto it = guilds.find(guildId);
+    if (it != guilds.end()) {
+        it->second.name = name;
+        return;
+    }
+    
+    while (guilds.size() >= maxGuilds && !guildOrder.empty()) {
+        guilds.erase(guildOrder.front());
+        guildOrder.pop_front();
+    }
+    guildOrder.push_back(guildId);
+    guilds[guildId] = GuildEntry{name, std::prev(guildOrder.end())};
+}
+
+void GuildCache::insertChannelLocked(const std::string& channelId, const std::string& name, const std::string& guildId) {
+    auto it = channels.find(channelId);
+    if (it != channels.end()) {
+        it->second.name = name;
+        if (!guildId.empty() && guildId != it->second.guildId) {
+            if (!it->second.guildId.empty()) {
+                auto owner = guildChannels.find(it->second.guildId);
+                if (owner != guildChannels.end()) {
+                    owner->second.erase(channelId);
+                    if (owner->second.empty()) guildChannels.erase(owner);
+                }
+            }
+            it->second.guildId = guildId;
+            guildChannels[guildId].insert(channelId);
+        }
+        return;
+    }
+    
+    while (channels.size() >= maxChannels && !channelOrder.empty()) {
+        eraseChannelLocked(channels.find(channelOrder.front()));
+    }
+    channelOrder.push_back(channelId);
+    channels[channelId] = ChannelEntry{name, guildId, std::prev(channelOrder.end())};
+    if (!guildId.empty()) guildChannels[guildId].insert(channelId);
+}
+
+void GuildCache::eraseChannelLocked(std::unordered_map<std::string, ChannelEntry>::iterator it) {
+    if (!it->second.guildId.empty()) {
+        auto owner = guildChannels.find(it->second.guildId);
+        if (owner != guildChannels.end()) {
+            owner->second.erase(it->first);
+            if (owner->second.empty()) guildChannels.erase(owner);
+        }
+    }
+    channelOrder.erase(it->second.order);
+    channels.erase(it);
+}
+
+void GuildCache::onGuild(const std::string& guildJson) {
+    std::string guildId = SimpleJSON::getMemberString(guildJson, "id");
+    if (guildId.empty()) return;
+    
+    std::string name = SimpleJSON::getMemberString(guildJson, "name");
+    std::vector<std::string> channelList = SimpleJSON::splitArray(SimpleJSON::getMember(guildJson, "channels"));
+    std::vector<std::string> threadList = SimpleJSON::splitArray(SimpleJSON::getMember(guildJson, "threads"));
+    
+    // Parse outside the lock, then publish
+    std::vector<std::pair<std::string, std::string>> parsed;
+    parsed.reserve(channelList.size() + threadList.size());
+    for (const auto* list : { &channelList, &threadList }) {
+        for (const auto& ch : *list) {
+            std::string id = SimpleJSON::getMemberString(ch, "id");
+            if (!id.empty()) {
+                parsed.emplace_back(id, SimpleJSON::getMemberString(ch, "name"));
+            }
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!name.empty()) {
+        insertGuildLocked(guildId, name);
+    }
+    for (const auto& ch : parsed) {
+        insertChannelLocked(ch.first, ch.second, guildId);
+    }
+}
+
+void GuildCache::onGuildDelete(const std::string& guildJson) {
+    // "unavailable": true means an outage, not a removal - keep the names
+    if (SimpleJSON::getMember(guildJson, "unavailable") == "true") return;
+    
+    std::string guildId = SimpleJSON::getMemberString(guildJson, "id");
+    if (guildId.empty()) return;
+    
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto guild = guilds.find(guildId);
+    if (guild != guilds.end()) {
+        guildOrder.erase(guild->second.order);
+        guilds.erase(guild);
+    }
+    
+    // Straight to the guild's channels through the index, not a scan of every channel
+    auto owned = guildChannels.find(guildId);
+    if (owned == guildChannels.end()) return;
+    std::unordered_set<std::string> channelIds;
+    channelIds.swap(owned->second);
+    guildChannels.erase(owned);
+    for (const auto& channelId : channelIds) {
+        auto it = channels.find(channelId);
+        if (it == channels.end()) continue;
+        channelOrder.erase(it->second.order);
+        channels.erase(it);
+    }
+}
+
+void GuildCache::onChannel(const std::string& channelJson, const std::string& guildId) {
+    std::string channelId = SimpleJSON::getMemberString(channelJson, "id");
+    if (channelId.empty()) return;
+    
+    std::string name = SimpleJSON::getMemberString(channelJson, "name");
+    std::string owner = guildId.empty() ? SimpleJSON::getMemberString(channelJson, "guild_id") : guildId;
+    
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    insertChannelLocked(channelId, name, owner);
+}
+
+void GuildCache::onChannelDelete(const std::string& channelJson) {
+    std::string channelId = SimpleJSON::getMemberString(channelJson, "id");
+    if (channelId.empty()) return;
+    
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = channels.find(channelId);
+    if (it != channels.end()) eraseChannelLocked(it);
+}
+
+void GuildCache::setChannel(const std::string& channelId, const std::string& channelName,
+                            const std::string& guildId, const std::string& guildName) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!guildId.empty() && !guildName.empty()) {
+        insertGuildLocked(guildId, guildName);
+    }
+    insertChannelLocked(channelId, channelName, guildId);
+}
+
+bool GuildCache::lookup(const std::string& channelId, std::string& channelName, std::string& guildName) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    
+    auto it = channels.find(channelId);
+    if (it == channels.end()) {
+        misses++;
+        return false;
+    }
+    
+    channelName = it->second.name;
+    auto git = guilds.find(it->second.guildId);
+    if (git != guilds.end()) {
+        guildName = git->second.name;
+    }
+    hits++;
+    return true;
+}
+
+void GuildCache::recordRestLookup(ULONGLONG micros) {
+    restLookups++;
+    restMicros += micros;
+}
+
+std::string GuildCache::statsString() const {
+    uint64_t h = hits, m = misses, rl = restLookups, rm = restMicros;
+    size_t channelCount, guildCount;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        channelCount = channels.size();
+        guildCount = guilds.size();
+    }
+    
+    uint64_t total = h + m;
+    int hitRate = total ? (int)(h * 100 / total) : 0;
+    
+    // Every hit would otherwise have cost one REST round trip (measured on misses)
+    uint64_t avgRestMs = rl ? rm / rl / 1000 : 0;
+    
+    return "guilds: " + std::to_string(guildCount) + ", channels: " + std::to_string(channelCount) +
+           ", hits: " + std::to_string(h) + ", misses: " + std::to_string(m) +
+           " (" + std::to_string(hitRate) + "% hit rate), avg REST lookup: " + std::to_string(avgRestMs) +
+           "ms, est. saved: " + std::to_string(h * avgRestMs) + "ms";
+}
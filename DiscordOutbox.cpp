@@ -0,0 +1,314 @@
+#include "KindroidBot.h"
+
+// ============================================
+// DiscordOutbox - per-channel ordered REST queue
+// ============================================
+
+DiscordOutbox::DiscordOutbox(PostFn post, int workers, size_t maxPostLength)
+    : post(post), workerCount(workers), maxPostLength(maxPostLength), stopping(false), runningCallbacks(0),
+      posted(0), failed(0), merged(0), rateLimited(0) {
+}
+
+DiscordOutbox::~DiscordOutbox() {
+    stop();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void DiscordOutbox::start() {
+    // Workers from a previous run exit on their own once they see stopping
+    std::vector<std::thread> previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        previous.swap(workers);
+    }
+    wake.notify_all();
+    for (auto& worker : previous) {
+        if (worker.joinable()) worker.join();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = false;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&DiscordOutbox::workerLoop, this);
+    }
+}
+
+void DiscordOutbox::stop() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+        lanes.clear();
+        readyLanes.clear();
+        limitedUntil.clear();
+        
+        // Callbacks reach into their owners (typing); none may run once stop() returns
+        callbacksDone.wait(lock, [this]() { return runningCallbacks == 0; });
+    }
+    wake.notify_all();
+}
+
+void DiscordOutbox::enqueue(const std::string& channelId, const std::string& content, Done done) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        
+        Lane& lane = lanes[channelId];
+        lane.messages.push_back({ content, utf8Length(content), std::move(done) });
+        
+        // A busy lane is rescheduled by its worker once the current post finishes
+        if (lane.busy || lane.scheduled) return;
+        lane.scheduled = true;
+        readyLanes.push_back(channelId);
+    }
+    wake.notify_one();
+}
+
+void DiscordOutbox::rateLimit(const std::string& channelId, DWORD delayMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) return;
+    rateLimitLocked(channelId, delayMs);
+}
+
+DWORD DiscordOutbox::rateLimitDelay(const std::string& channelId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rateLimitDelayLocked(channelId);
+}
+
+void DiscordOutbox::rateLimitLocked(const std::string& channelId, DWORD delayMs) {
+    rateLimited++;
+    ULONGLONG now = GetTickCount64();
+    
+    // 429s are rare, so expired channels are swept here rather than on every post
+    for (auto it = limitedUntil.begin(); it != limitedUntil.end();) {
+        if (it->second <= now) it = limitedUntil.erase(it);
+        else ++it;
+    }
+    ULONGLONG& until = limitedUntil[channelId];
+    if (now + delayMs > until) until = now + delayMs;
+}
+
+DWORD DiscordOutbox::rateLimitDelayLocked(const std::string& channelId) {
+    auto it = limitedUntil.find(channelId);
+    if (it == limitedUntil.end()) return 0;
+    
+    ULONGLONG now = GetTickCount64();
+    if (it->second <= now) {
+        limitedUntil.erase(it);
+        return 0;
+    }
+    return (DWORD)(it->second - now);
+}
+
+std::string DiscordOutbox::takeBatchLocked(Lane& lane, std::vector<Done>& dones) {
+    std::string batch = std::move(lane.messages.front().content);
+    size_t batchLength = lane.messages.front().length;
+    if (lane.messages.front().done) dones.push_back(std::move(lane.messages.front().done));
+    lane.messages.pop_front();
+    
+    // Fold following short messages into this post while they fit, in order
+    while (!lane.messages.empty() && batchLength + 1 + lane.messages.front().length <= maxPostLength) {
+        batchLength += 1 + lane.messages.front().length;
+        batch += '\n';
+        batch += lane.messages.front().content;
+        if (lane.messages.front().done) dones.push_back(std::move(lane.messages.front().done));
+        lane.messages.pop_front();
+        merged++;
+    }
+    return batch;
+}
+
+void DiscordOutbox::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<Done> dones;
+    
+    while (!stopping) {
+        wake.wait(lock, [this]() { return stopping || !readyLanes.empty(); });
+        if (stopping) break;
+        
+        std::string channelId = std::move(readyLanes.front());
+        readyLanes.pop_front();
+        
+        auto it = lanes.find(channelId);
+        if (it == lanes.end() || it->second.messages.empty()) {
+            if (it != lanes.end()) lanes.erase(it);
+            continue;
+        }
+        
+        // Own the lane until this post is done so the channel stays strictly ordered
+        it->second.scheduled = false;
+        it->second.busy = true;
+        dones.clear();
+        std::string batch = takeBatchLocked(it->second, dones);
+        
+        // Rate limited, by an earlier post or a typing trigger: hold the lane (other
+        // channels keep flowing) until the limit clears, then retry the same post
+        DWORD retryAfter = 0;
+        while (!stopping) {
+            DWORD wait = rateLimitDelayLocked(channelId);
+            if (wait > 0) {
+                wake.wait_for(lock, std::chrono::milliseconds(wait), [this]() { return stopping; });
+                continue;
+            }
+            
+            lock.unlock();
+            retryAfter = post(channelId, batch);
+            lock.lock();
+            
+            if (retryAfter == 0 || retryAfter == POST_FAILED) break;
+            if (!stopping) rateLimitLocked(channelId, retryAfter);
+        }
+        if (stopping) break;
+        if (retryAfter == POST_FAILED) failed++;
+        else posted++;
+        
+        // Unlocked, so a callback never holds up the other lanes; stop() waits for it
+        if (!dones.empty()) {
+            runningCallbacks++;
+            lock.unlock();
+            for (auto& done : dones) done();
+            dones.clear();
+            lock.lock();
+            if (--runningCallbacks == 0) callbacksDone.notify_all();
+            if (stopping) break;
+        }
+        
+        // stop() may have cleared the lanes while the post was in flight
+        it = lanes.find(channelId);
+        if (it == lanes.end()) continue;
+        
+        it->second.busy = false;
+        if (it->second.messages.empty()) {
+            lanes.erase(it);
+        } else if (!it->second.scheduled) {
+            it->second.scheduled = true;
+            readyLanes.push_back(channelId);
+            wake.notify_one();
+        }
+    }
+}
+
+std::string DiscordOutbox::statsString() const {
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : lanes) queued += entry.second.messages.size();
+    }
+    return std::to_string(posted) + " posts, " + std::to_string(failed) + " failed, " +
+           std::to_string(merged) + " merged, " + std::to_string(rateLimited) + " rate limited, " +
+           std::to_string(queued) + " queued";
+}
+
+// ============================================
+// DiscordTyping - typing indicator refresher
+// ============================================
+
+DiscordTyping::DiscordTyping(DiscordOutbox& outbox, TriggerFn trigger, DWORD refreshMs)
+    : outbox(outbox), trigger(trigger), refreshMs(refreshMs), stopping(false), triggered(0), deferred(0) {
+}
+
+DiscordTyping::~DiscordTyping() {
+    stop();
+    if (worker.joinable()) worker.join();
+}
+
+void DiscordTyping::start() {
+    // A thread from a previous run exits on its own once it sees stopping
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = false;
+    worker = std::thread(&DiscordTyping::workerLoop, this);
+}
+
+void DiscordTyping::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        channels.clear();
+    }
+    wake.notify_all();
+}
+
+void DiscordTyping::begin(const std::string& channelId) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        
+        // Already showing for another pending reply in this channel
+        Channel& channel = channels[channelId];
+        if (channel.holders++ > 0) return;
+        channel.nextAt = 0;
+    }
+    wake.notify_one();
+}
+
+void DiscordTyping::end(const std::string& channelId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = channels.find(channelId);
+    if (it == channels.end()) return;
+    if (--it->second.holders <= 0) channels.erase(it);
+}
+
+void DiscordTyping::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<std::string> due;
+    
+    while (!stopping) {
+        // Sleep until the earliest channel is due, or begin() adds one
+        ULONGLONG now = GetTickCount64();
+        ULONGLONG earliest = 0;
+        due.clear();
+        for (auto& entry : channels) {
+            if (entry.second.nextAt <= now) {
+                due.push_back(entry.first);
+                entry.second.nextAt = now + refreshMs;
+            } else if (earliest == 0 || entry.second.nextAt < earliest) {
+                earliest = entry.second.nextAt;
+            }
+        }
+        
+        if (due.empty()) {
+            if (earliest == 0) {
+                wake.wait(lock);
+            } else {
+                wake.wait_for(lock, std::chrono::milliseconds(earliest - now));
+            }
+            continue;
+        }
+        
+        // Posts go out unlocked so begin()/end() never wait on the network, and so the
+        // outbox (whose workers call end()) is never entered with this mutex held
+        for (const auto& channelId : due) {
+            lock.unlock();
+            DWORD retryAfter = outbox.rateLimitDelay(channelId);
+            bool skipped = retryAfter > 0;
+            if (!skipped) {
+                retryAfter = trigger(channelId);
+                if (retryAfter > 0) outbox.rateLimit(channelId, retryAfter);
+            }
+            lock.lock();
+            if (stopping) break;
+            
+            if (skipped) deferred++;
+            else triggered++;
+            
+            // Rate limited: the channel's next refresh waits out the limit instead
+            auto it = channels.find(channelId);
+            if (retryAfter > 0 && it != channels.end()) {
+                it->second.nextAt = GetTickCount64() + retryAfter;
+            }
+        }
+    }
+}
+
+std::string DiscordTyping::statsString() const {
+    return std::to_string(triggered) + " triggers, " + std::to_string(deferred) + " deferred by rate limits";
+}
@@ -0,0 +1,130 @@
+#include "KindroidBot.h"
+
+// ============================================
+// HttpClient - shared WinHTTP session
+// ============================================
+
+static HINTERNET g_httpSession = NULL;
+static std::mutex g_httpSessionMutex;
+
+// Pre-warm requests run on their own threads, joined before the session is closed
+struct PrewarmTask {
+    std::thread thread;
+    std::shared_ptr<std::atomic<bool>> done;
+};
+static std::vector<PrewarmTask> g_prewarmTasks;
+static std::mutex g_prewarmMutex;
+
+HINTERNET HttpClient::session() {
+    std::lock_guard<std::mutex> lock(g_httpSessionMutex);
+    if (!g_httpSession) {
+        g_httpSession = WinHttpOpen(L"KindroidBot/1.0",
+            WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+            WINHTTP_NO_PROXY_NAME,
+            WINHTTP_NO_PROXY_BYPASS, 0);
+    }
+    return g_httpSession;
+}
+
+void HttpClient::shutdown() {
+    // A HEAD still in flight uses the session, so it has to finish first
+    std::vector<PrewarmTask> tasks;
+    {
+        std::lock_guard<std::mutex> lock(g_prewarmMutex);
+        tasks.swap(g_prewarmTasks);
+    }
+    for (auto& task : tasks) {
+        if (task.thread.joinable()) task.thread.join();
+    }
+    
+    std::lock_guard<std::mutex> lock(g_httpSessionMutex);
+    if (g_httpSession) {
+        WinHttpCloseHandle(g_httpSession);
+        g_httpSession = NULL;
+    }
+}
+
+void HttpClient::prewarm(const std::string& host) {
+    // Any response will do - the point is the DNS lookup, TCP connect and TLS
+    // handshake, which leave a keep-alive connection in the session pool
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    std::thread thread([host, done]() {
+        HttpClient::request("HEAD", host, "/", "");
+        *done = true;
+    });
+    
+    std::lock_guard<std::mutex> lock(g_prewarmMutex);
+    // Reap earlier pre-warms that have finished, so every start does not add a thread
+    for (auto it = g_prewarmTasks.begin(); it != g_prewarmTasks.end();) {
+        if (*it->done) {
+            it->thread.join();
+            it = g_prewarmTasks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    g_prewarmTasks.push_back({ std::move(thread), done });
+}
+
+std::string HttpClient::request(const std::string& method, const std::string& host, const std::string& path,
+                                const std::string& headers, const std::string& body, DWORD* statusCode) {
+    if (statusCode) *statusCode = 0;
+    
+    HINTERNET hSession = session();
+    if (!hSession) return "";
+    
+    // Connection handles are cheap; WinHTTP pools the sockets per session and host
+    std::wstring whost = stringToWstring(host);
+    HINTERNET hConnect = WinHttpConnect(hSession, whost.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
+    if (!hConnect) return "";
+    
+    std::wstring wmethod = stringToWstring(method);
+    std::wstring wpath = stringToWstring(path);
+    HINTERNET hRequest = WinHttpOpenRequest(hConnect, wmethod.c_str(), wpath.c_str(),
+        NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
+        WINHTTP_FLAG_SECURE);
+    if (!hRequest) {
+        WinHttpCloseHandle(hConnect);
+        return "";
+    }
+    
+    std::wstring wheaders = stringToWstring(headers);
+    BOOL bResults = WinHttpSendRequest(hRequest,
+        wheaders.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : wheaders.c_str(), (DWORD)-1,
+        body.empty() ? WINHTTP_NO_REQUEST_DATA : (LPVOID)body.c_str(), (DWORD)body.length(),
+        (DWORD)body.length(), 0);
+    
+    if (bResults) {
+        bResults = WinHttpReceiveResponse(hRequest, NULL);
+    }
+    
+    std::string response;
+    if (bResults) {
+        if (statusCode) {
+            DWORD size = sizeof(DWORD);
+            WinHttpQueryHeaders(hRequest,
+                WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                WINHTTP_HEADER_NAME_BY_INDEX, statusCode, &size, WINHTTP_NO_HEADER_INDEX);
+        }
+        
+        DWORD dwSize = 0;
+        DWORD dwDownloaded = 0;
+        do {
+            dwSize = 0;
+            if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) break;
+            if (dwSize == 0) break;
+            
+            size_t offset = response.size();
+            response.resize(offset + dwSize);
+            if (!WinHttpReadData(hRequest, &response[offset], dwSize, &dwDownloaded)) {
+                response.resize(offset);
+                break;
+            }
+            response.resize(offset + dwDownloaded);
+        } while (dwSize > 0);
+    }
+    
+    WinHttpCloseHandle(hRequest);
+    WinHttpCloseHandle(hConnect);
+    return response;
+}
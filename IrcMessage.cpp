@@ -0,0 +1,137 @@
+#include "KindroidBot.h"
+
+// ============================================
+// IrcMessage - single pass IRCv3 line parser
+// ============================================
+
+bool IrcMessage::parse(std::string_view line) {
+    tags = prefix = command = std::string_view();
+    paramCount = 0;
+    
+    size_t pos = 0;
+    const size_t n = line.size();
+    
+    // Each leading part runs up to the next space; runs of spaces separate parts
+    auto word = [&]() {
+        size_t start = pos;
+        size_t end = line.find(' ', pos);
+        if (end == std::string_view::npos) end = n;
+        pos = end;
+        while (pos < n && line[pos] == ' ') pos++;
+        return line.substr(start, end - start);
+    };
+    
+    if (pos < n && line[pos] == '@') {
+        pos++;
+        tags = word();
+    }
+    if (pos < n && line[pos] == ':') {
+        pos++;
+        prefix = word();
+    }
+    command = word();
+    if (command.empty()) return false;
+    
+    while (pos < n && paramCount < MAX_PARAMS) {
+        // ":trailing" (or the last slot) takes the rest of the line, spaces included
+        if (line[pos] == ':' || paramCount == MAX_PARAMS - 1) {
+            if (line[pos] == ':') pos++;
+            params[paramCount++] = line.substr(pos);
+            break;
+        }
+        params[paramCount++] = word();
+    }
+    return true;
+}
+
+std::string_view IrcMessage::nick() const {
+    size_t bang = prefix.find('!');
+    return bang == std::string_view::npos ? prefix : prefix.substr(0, bang);
+}
+
+bool IrcMessage::findTag(std::string_view key, std::string_view& value) const {
+    size_t pos = 0;
+    while (pos < tags.size()) {
+        size_t end = tags.find(';', pos);
+        if (end == std::string_view::npos) end = tags.size();
+        
+        // "key=value", or a bare "key" meaning an empty value
+        std::string_view item = tags.substr(pos, end - pos);
+        if (item.size() >= key.size() && item.compare(0, key.size(), key) == 0) {
+            if (item.size() == key.size()) {
+                value = std::string_view();
+                return true;
+            }
+            if (item[key.size()] == '=') {
+                value = item.substr(key.size() + 1);
+                return true;
+            }
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+std::string_view IrcMessage::rawTag(std::string_view key) const {
+    std::string_view value;
+    return findTag(key, value) ? value : std::string_view();
+}
+
+std::string IrcMessage::tag(std::string_view key) const {
+    std::string_view raw = rawTag(key);
+    if (raw.find('\\') == std::string_view::npos) return std::string(raw);
+    
+    // IRCv3 escapes: \: ; \s space \\ backslash \r \n; any other \x is x
+    std::string value;
+    value.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+        if (raw[i] != '\\') {
+            value += raw[i];
+            continue;
+        }
+        if (++i == raw.size()) break; // A trailing lone backslash is dropped
+        switch (raw[i]) {
+            case ':': value += ';'; break;
+            case 's': value += ' '; break;
+            case 'r': value += '\r'; break;
+            case 'n': value += '\n'; break;
+            default: value += raw[i]; break;
+        }
+    }
+    return value;
+}
+
+// ============================================
+// LineBuffer - offset-based line splitting
+// ============================================
+
+void LineBuffer::append(const char* data, size_t len) {
+    // Drop consumed bytes once they make up most of the buffer; until then the
+    // next() views stay cheap offsets and nothing is moved
+    if (readPos > 0 && readPos >= buffer.size() / 2) {
+        buffer.erase(0, readPos);
+        scanPos -= readPos;
+        readPos = 0;
+    }
+    buffer.append(data, len);
+}
+
+bool LineBuffer::next(std::string_view& line) {
+    const char* base = buffer.data();
+    const void* nl = memchr(base + scanPos, '\n', buffer.size() - scanPos);
+    if (!nl) {
+        scanPos = buffer.size();
+        return false;
+    }
+    
+    size_t end = (const char*)nl - base;
+    size_t lineEnd = (end > readPos && base[end - 1] == '\r') ? end - 1 : end;
+    line = std::string_view(base + readPos, lineEnd - readPos);
+    readPos = scanPos = end + 1;
+    return true;
+}
+
+void LineBuffer::clear() {
+    buffer.clear();
+    readPos = scanPos = 0;
+}
@@ -9,107 +9,52 @@ std::string KindroidAPI::sendMessage(const std::string& username, const std::str
     std::string fullMessage = "<Message to you from " + username + " in channel " + channelName + "> " + message;
     
     // Build JSON body
-    std::map<std::string, std::string> body;
-    body["ai_id"] = aiId;
-    body["message"] = fullMessage;
-    
-    std::string jsonBody = SimpleJSON::buildObject(body);
+    std::string jsonBody;
+    jsonBody.reserve(64 + aiId.size() + fullMessage.size() + fullMessage.size() / 8);
+    JsonWriter(jsonBody).beginObject()
+        .key("ai_id").string(aiId)
+        .key("message").string(fullMessage)
+        .endObject();
     
     // Parse baseUrl to get host and path
     std::string host, path;
-    size_t protocolEnd = baseUrl.find("://");
-    if (protocolEnd != std::string::npos) {
-        size_t hostStart = protocolEnd + 3;
-        size_t pathStart = baseUrl.find('/', hostStart);
-        if (pathStart != std::string::npos) {
-            host = baseUrl.substr(hostStart, pathStart - hostStart);
-            path = baseUrl.substr(pathStart) + "/send-message";
-        } else {
-            host = baseUrl.substr(hostStart);
-            path = "/v1/send-message";
-        }
-    } else {
+    if (!parseBaseUrl(host, path)) {
         return "[ERROR] Invalid base URL format";
     }
     
     return httpsRequest(host, path, jsonBody);
 }
 
-std::string KindroidAPI::httpsRequest(const std::string& host, const std::string& path, const std::string& body) {
-    HINTERNET hSession = NULL;
-    HINTERNET hConnect = NULL;
-    HINTERNET hRequest = NULL;
-    std::string response;
-    
-    // Initialize WinHTTP
-    hSession = WinHttpOpen(L"KindroidBot/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-        WINHTTP_NO_PROXY_NAME,
-        WINHTTP_NO_PROXY_BYPASS, 0);
-    
-    if (!hSession) return "[ERROR] WinHTTP session failed";
-    
-    // Connect to server
-    std::wstring whost = stringToWstring(host);
-    hConnect = WinHttpConnect(hSession, whost.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
-    
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
-        return "[ERROR] Connection failed";
-    }
-    
-    // Create request
-    std::wstring wpath = stringToWstring(path);
-    hRequest = WinHttpOpenRequest(hConnect, L"POST", wpath.c_str(),
-        NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
-        WINHTTP_FLAG_SECURE);
-    
-    if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return "[ERROR] Request creation failed";
+void KindroidAPI::prewarm() {
+    std::string host, path;
+    if (parseBaseUrl(host, path)) {
+        HttpClient::prewarm(host);
     }
+}
+
+bool KindroidAPI::parseBaseUrl(std::string& host, std::string& path) const {
+    size_t protocolEnd = baseUrl.find("://");
+    if (protocolEnd == std::string::npos) return false;
     
-    // Set headers
-    std::string authHeader = "Authorization: Bearer " + apiKey;
-    std::wstring wAuthHeader = stringToWstring(authHeader);
-    std::wstring headers = wAuthHeader + L"\r\nContent-Type: application/json\r\n";
-    
-    // Send request
-    BOOL bResults = WinHttpSendRequest(hRequest,
-        headers.c_str(), -1,
-        (LPVOID)body.c_str(), (DWORD)body.length(),
-        (DWORD)body.length(), 0);
-    
-    if (bResults) {
-        bResults = WinHttpReceiveResponse(hRequest, NULL);
+    size_t hostStart = protocolEnd + 3;
+    size_t pathStart = baseUrl.find('/', hostStart);
+    if (pathStart != std::string::npos) {
+        host = baseUrl.substr(hostStart, pathStart - hostStart);
+        path = baseUrl.substr(pathStart) + "/send-message";
+    } else {
+        host = baseUrl.substr(hostStart);
+        path = "/v1/send-message";
     }
+    return true;
+}
+
+std::string KindroidAPI::httpsRequest(const std::string& host, const std::string& path, const std::string& body) {
+    std::string headers = "Authorization: Bearer " + apiKey + "\r\nContent-Type: application/json";
     
-    if (bResults) {
-        DWORD dwSize = 0;
-        DWORD dwDownloaded = 0;
-        
-        do {
-            dwSize = 0;
-            if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) break;
-            
-            if (dwSize == 0) break;
-            
-            char* pszOutBuffer = new char[dwSize + 1];
-            ZeroMemory(pszOutBuffer, dwSize + 1);
-            
-            if (WinHttpReadData(hRequest, (LPVOID)pszOutBuffer, dwSize, &dwDownloaded)) {
-                response.append(pszOutBuffer, dwDownloaded);
-            }
-            
-            delete[] pszOutBuffer;
-        } while (dwSize > 0);
-    }
+    DWORD statusCode = 0;
+    std::string response = HttpClient::request("POST", host, path, headers, body, &statusCode);
     
-    // Cleanup
-    if (hRequest) WinHttpCloseHandle(hRequest);
-    if (hConnect) WinHttpCloseHandle(hConnect);
-    if (hSession) WinHttpCloseHandle(hSession);
+    if (statusCode == 0) return "[ERROR] Connection failed";
     
     if (response.empty()) return "[ERROR] No response from API";
     
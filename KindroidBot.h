@@ -11,10 +11,21 @@
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <list>
+#include <deque>
+#include <queue>
 #include <atomic>
 #include <fstream>
 #include <sstream>
@@ -39,10 +50,26 @@ class SchannelConnection;
 struct SchannelContext;
 SchannelContext* SchannelCreate(SOCKET sock);
 bool SchannelHandshake(SchannelContext* ctx, const char* hostname);
+bool SchannelSessionResumed(SchannelContext* ctx); // Last handshake reused a cached session
 int SchannelSend(SchannelContext* ctx, const void* data, int len);
+BYTE* SchannelSendBuffer(SchannelContext* ctx, int* capacity); // Write plaintext here (one record)...
+int SchannelSendInPlace(SchannelContext* ctx, int len);        // ...then encrypt and send it without copying
 int SchannelRecv(SchannelContext* ctx, void* buffer, int len);
+int SchannelRecvView(SchannelContext* ctx, const char** data, int maxLen); // Plaintext view, valid until next recv
+int SchannelRecvAll(SchannelContext* ctx, void* buffer, int len); // Exactly len bytes, across TLS records
 void SchannelDestroy(SchannelContext* ctx);
 
+// TCP connect with a cached resolver. Races IPv6/IPv4 addresses (Happy Eyeballs)
+// and returns a blocking socket; WSAHOST_NOT_FOUND is set when resolution fails.
+SOCKET NetConnect(const std::string& host, const std::string& port, DWORD timeoutMs = 10000);
+bool NetResolve(const std::string& host, const std::string& port); // Warm the cache
+void NetInvalidate(const std::string& host, const std::string& port);
+
+// WebSocket client frames, masked straight into the TLS send buffer.
+// Not thread safe per connection - callers serialize sends.
+bool WebSocketSend(SchannelContext* ssl, int opcode, const char* data, size_t len,
+                   const char* suffix = nullptr, size_t suffixLen = 0);
+
 // GUI Controls IDs
 #define IDC_DISCORD_TOKEN       1001
 #define IDC_API_KEY             1002
@@ -83,6 +110,7 @@ void SchannelDestroy(SchannelContext* ctx);
 #define IDC_ANNOUNCE_CHANNEL    1037
 #define IDC_TAB_CONTROL         1038
 #define IDC_OPEN_LOG            1039
+#define IDC_TRIGGER_RULES       1040
 
 // Configuration structure
 struct BotConfig {
@@ -98,8 +126,14 @@ struct BotConfig {
     // Twitch settings
     std::string twitchUsername;     // Bot's Twitch username
     std::string twitchOAuth;        // OAuth token (oauth:xxxxx)
-    std::string twitchChannel;      // Channel to join (without #)
+    std::string twitchChannel;      // Channel(s) to join (without #), comma separated
     bool twitchEnabled;             // Enable Twitch bot
+    int twitchChannelsPerConnection; // More channels than this open another IRC connection
+    bool twitchRawIrc;              // Raw IRC over TLS (port 6697) instead of WebSocket
+    std::string triggerRules;       // Keyword trigger/ignore rules, one per line (see TriggerRules)
+    std::string mentionAliases;     // Extra @names the bot answers to, comma separated
+    int userCooldownSecs;           // Min seconds between replies to one user in a channel
+    int channelCooldownSecs;        // Min seconds between replies in one channel (0 = off)
     
     // Announcement settings
     std::string announceMessage;    // Message to announce
@@ -111,6 +145,8 @@ struct BotConfig {
     
     BotConfig() : profileName(""), baseUrl("https://api.kindroid.ai/v1"), personaName("User"), 
                   debugMode(false), discordEnabled(true), twitchEnabled(false),
+                  twitchChannelsPerConnection(50), twitchRawIrc(false),
+                  userCooldownSecs(10), channelCooldownSecs(0),
                   announceHours(0), announceMins(30), announceDiscord(false), announceTwitch(false) {}
 };
 
@@ -118,12 +154,182 @@ struct BotConfig {
 class SimpleJSON {
 public:
     static std::string escape(const std::string& str);
+    static void escapeAppend(std::string& out, const char* data, size_t len); // No temporaries
     static std::string unescape(const std::string& str);
     static std::string buildObject(const std::map<std::string, std::string>& obj);
     static std::map<std::string, std::string> parseObject(const std::string& json);
     static std::string getString(const std::map<std::string, std::string>& obj, const std::string& key);
     static std::vector<std::map<std::string, std::string>> parseArray(const std::string& json);
     static std::string buildConversationArray(const std::vector<std::map<std::string, std::string>>& conversation);
+    
+    // Nesting-aware access to raw JSON text (objects, arrays, numbers are returned verbatim)
+    static size_t skipValue(const std::string& json, size_t pos);
+    static bool findMember(const std::string& json, size_t objStart, const std::string& key,
+                           size_t& valueStart, size_t& valueEnd);
+    static std::string getMember(const std::string& json, const std::string& key);
+    static std::string getMemberString(const std::string& json, const std::string& key);
+    static std::vector<std::string> splitArray(const std::string& json);
+};
+
+// Raw value location inside a JSON document (end == 0 when the path was absent)
+struct JsonSpan {
+    size_t start = 0;
+    size_t end = 0;
+    
+    bool found() const { return end > start; }
+    std::string raw(const std::string& json) const { return json.substr(start, end - start); }
+    // Unescaped contents of a string value, "" for anything else
+    std::string text(const std::string& json) const {
+        if (end - start < 2 || json[start] != '"') return "";
+        return SimpleJSON::unescape(json.substr(start + 1, end - start - 2));
+    }
+};
+
+// Pulls a fixed set of dotted member paths ("d.author.username") out of a JSON
+// object in one pass. Paths are split at compile time and matched at their exact
+// depth, so "d.referenced_message.author.username" never satisfies "d.author.username".
+// Objects that hold no requested path are skipped without being scanned key by key.
+template <size_t N>
+class JsonPathSet {
+public:
+    static_assert(N > 0 && N <= 32, "JsonPathSet tracks paths in a 32-bit mask");
+    
+    constexpr JsonPathSet(const char* const (&list)[N]) : paths{} {
+        for (size_t i = 0; i < N; i++) {
+            const char* p = list[i];
+            size_t segStart = 0;
+            for (size_t k = 0; ; k++) {
+                if (p[k] == '.' || p[k] == '\0') {
+                    Path& path = paths[i];
+                    if (path.count < MAX_SEGMENTS) {
+                        path.segment[path.count] = p + segStart;
+                        path.length[path.count] = k - segStart;
+                        path.count++;
+                    }
+                    segStart = k + 1;
+                    if (p[k] == '\0') break;
+                }
+            }
+        }
+    }
+    
+    // Fills out[i] for every paths[i] present; returns how many were found
+    size_t extract(const std::string& json, JsonSpan (&out)[N]) const {
+        for (auto& span : out) span = JsonSpan();
+        size_t pos = json.find('{');
+        if (pos == std::string::npos) return 0;
+        
+        uint32_t remaining = (N == 32) ? 0xFFFFFFFFu : ((1u << (N % 32)) - 1);
+        walk(json, pos, 0, remaining, out, remaining);
+        
+        size_t found = 0;
+        for (const auto& span : out) found += span.found() ? 1 : 0;
+        return found;
+    }
+    
+private:
+    static const int MAX_SEGMENTS = 6;
+    struct Path {
+        const char* segment[MAX_SEGMENTS];
+        size_t length[MAX_SEGMENTS];
+        int count;
+    };
+    Path paths[N];
+    
+    static size_t skipSpace(const std::string& json, size_t pos) {
+        while (pos < json.length() && (json[pos] == ' ' || json[pos] == '\n' || json[pos] == '\r' || json[pos] == '\t')) pos++;
+        return pos;
+    }
+    
+    // Walks the object at pos; returns the offset after it, or npos once every path is found
+    size_t walk(const std::string& json, size_t pos, int depth, uint32_t active,
+                JsonSpan (&out)[N], uint32_t& remaining) const {
+        size_t len = json.length();
+        pos++; // '{'
+        while (true) {
+            pos = skipSpace(json, pos);
+            if (pos >= len) return len;
+            if (json[pos] == '}') return pos + 1;
+            if (json[pos] == ',') { pos++; continue; }
+            if (json[pos] != '"') return len; // Malformed
+            
+            size_t keyStart = pos + 1;
+            size_t keyEnd = SimpleJSON::skipValue(json, pos) - 1;
+            if (keyEnd >= len) return len;
+            pos = skipSpace(json, keyEnd + 1);
+            if (pos >= len || json[pos] != ':') return len;
+            pos = skipSpace(json, pos + 1);
+            
+            // Which still-active paths continue through (or end at) this key
+            uint32_t leaf = 0, deeper = 0;
+            size_t keyLen = keyEnd - keyStart;
+            for (size_t i = 0; i < N; i++) {
+                if (!(active & (1u << i))) continue;
+                const Path& path = paths[i];
+                if (depth >= path.count || path.length[depth] != keyLen) continue;
+                if (json.compare(keyStart, keyLen, path.segment[depth], keyLen) != 0) continue;
+                if (path.count == depth + 1) leaf |= 1u << i;
+                else deeper |= 1u << i;
+            }
+            
+            size_t end;
+            if (deeper && pos < len && json[pos] == '{') {
+                end = walk(json, pos, depth + 1, deeper, out, remaining);
+                if (end == std::string::npos) return end;
+            } else {
+                end = SimpleJSON::skipValue(json, pos);
+            }
+            
+            if (leaf) {
+                size_t valueEnd = end;
+                while (valueEnd > pos && (json[valueEnd - 1] == ' ' || json[valueEnd - 1] == '\n' ||
+                                          json[valueEnd - 1] == '\r' || json[valueEnd - 1] == '\t')) valueEnd--;
+                for (size_t i = 0; i < N; i++) {
+                    if (leaf & (1u << i)) {
+                        out[i].start = pos;
+                        out[i].end = valueEnd;
+                    }
+                }
+                remaining &= ~leaf;
+                if (!remaining) return std::string::npos;
+            }
+            pos = end;
+        }
+    }
+};
+
+// Streaming JSON writer. Appends to a caller-owned buffer so its capacity can be
+// reused across payloads; keys and strings are escaped and commas are inserted
+// automatically. indent > 0 produces the pretty layout used by profiles.json.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out, int indent = 0);
+    
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(const std::string& name);
+    JsonWriter& key(const char* name); // Literals, without a temporary std::string
+    JsonWriter& key(const char* name, size_t len);
+    JsonWriter& string(const std::string& value);
+    JsonWriter& string(const char* value);
+    JsonWriter& string(const char* value, size_t len);
+    JsonWriter& number(long long value);
+    JsonWriter& boolean(bool value);
+    JsonWriter& null();
+    JsonWriter& raw(const std::string& json); // Already-serialized value
+    
+private:
+    static const int MAX_DEPTH = 32;
+    std::string& out;
+    int indent;
+    int depth;
+    bool hasItems[MAX_DEPTH];
+    bool afterKey;
+    
+    void beforeValue();
+    void newline(int level);
 };
 
 // Profile Manager - handles multiple bot profiles
@@ -145,6 +351,39 @@ public:
     static bool loadConfig(BotConfig& config, const std::string& filename = "config.json");
 };
 
+// Delay between reconnect attempts: the first retry is immediate, later ones back
+// off exponentially with jitter up to capMs. A connection that stayed up for
+// stableMs before dropping starts the sequence over. Not thread safe.
+class ReconnectPolicy {
+public:
+    ReconnectPolicy(DWORD baseMs = 1000, DWORD capMs = 60000, DWORD stableMs = 60000);
+    
+    void connected();       // Session established (READY, RESUMED, IRC welcome)
+    DWORD nextDelay();      // Call after a failure or disconnect
+    int attempts() const { return failures; }
+    
+private:
+    DWORD baseMs;
+    DWORD capMs;
+    DWORD stableMs;
+    int failures;
+    ULONGLONG connectedAt;
+};
+
+// Shared WinHTTP client. One session for the whole process, so keep-alive
+// connections and TLS sessions are reused by Discord REST and Kindroid calls.
+class HttpClient {
+public:
+    static std::string request(const std::string& method, const std::string& host, const std::string& path,
+                               const std::string& headers, const std::string& body = "",
+                               DWORD* statusCode = nullptr);
+    static void prewarm(const std::string& host); // Open a pooled connection in the background
+    static void shutdown();
+    
+private:
+    static HINTERNET session();
+};
+
 // Kindroid API Client
 class KindroidAPI {
 private:
@@ -155,11 +394,406 @@ private:
 public:
     KindroidAPI(const std::string& key, const std::string& id, const std::string& url);
     std::string sendMessage(const std::string& username, const std::string& channelName, const std::string& message);
+    void prewarm(); // Connect to the API host ahead of the first message
     
 private:
+    bool parseBaseUrl(std::string& host, std::string& path) const;
     std::string httpsRequest(const std::string& host, const std::string& path, const std::string& body);
 };
 
+// Guild and channel names, filled from gateway dispatches (GUILD_CREATE, CHANNEL_*)
+// so the reply path never has to block on a REST lookup. Bounded by maxChannels.
+class GuildCache {
+public:
+    GuildCache(size_t maxChannels = 20000, size_t maxGuilds = 5000);
+    void setLimits(size_t maxChannels, size_t maxGuilds); // Oldest entries go on the next inserts
+    
+    void onGuild(const std::string& guildJson);        // GUILD_CREATE / GUILD_UPDATE "d"
+    void onGuildDelete(const std::string& guildJson);  // GUILD_DELETE "d"
+    void onChannel(const std::string& channelJson, const std::string& guildId = ""); // CHANNEL_CREATE / UPDATE, THREAD_*
+    void onChannelDelete(const std::string& channelJson);
+    void setChannel(const std::string& channelId, const std::string& channelName,
+                    const std::string& guildId, const std::string& guildName);
+    
+    bool lookup(const std::string& channelId, std::string& channelName, std::string& guildName);
+    void recordRestLookup(ULONGLONG micros);
+    std::string statsString() const;
+    
+private:
+    // Entries keep their place in the insertion order, so a delete unlinks them directly
+    struct GuildEntry {
+        std::string name;
+        std::list<std::string>::iterator order;
+    };
+    struct ChannelEntry {
+        std::string name;
+        std::string guildId;
+        std::list<std::string>::iterator order;
+    };
+    
+    size_t maxChannels;
+    size_t maxGuilds;
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, GuildEntry> guilds;      // guildId -> entry
+    std::unordered_map<std::string, ChannelEntry> channels;  // channelId -> entry
+    std::unordered_map<std::string, std::unordered_set<std::string>> guildChannels; // guildId -> cached channel ids
+    std::list<std::string> guildOrder;                       // Insertion order, for eviction
+    std::list<std::string> channelOrder;                     // Insertion order, for eviction
+    
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> restLookups;
+    std::atomic<uint64_t> restMicros;
+    
+    void insertGuildLocked(const std::string& guildId, const std::string& name);
+    void insertChannelLocked(const std::string& channelId, const std::string& name, const std::string& guildId);
+    void eraseChannelLocked(std::unordered_map<std::string, ChannelEntry>::iterator it);
+};
+
+// Sliding-window rate limit shared between threads: at most maxEvents per windowMs
+class RateLimiter {
+public:
+    RateLimiter(size_t maxEvents, DWORD windowMs);
+    bool acquire(HANDLE cancelEvent); // Blocks for a slot; false if cancelEvent was signaled
+    void setLimit(size_t maxEvents, DWORD windowMs);
+    
+private:
+    size_t maxEvents;
+    DWORD windowMs;
+    std::mutex mutex;
+    std::deque<ULONGLONG> events;
+};
+
+// Reply jobs (ask Kindroid, send the answer) grouped into lanes, one per chat
+// channel. A lane runs one job at a time, in order, starting at least
+// minIntervalMs apart and holding at most maxPending; lanes run in parallel.
+// A lane waiting out its pacing is parked on a timer, not on a worker, so a few
+// lanes in slow mode never hold up the rest.
+// Jobs can be cancelled by lane, user or message: pending ones are dropped, and
+// the running one sees its cancelled flag set (it should check it before sending).
+class ReplyQueue {
+public:
+    typedef std::function<void(const std::atomic<bool>& cancelled)> Work;
+    
+    ReplyQueue(int workers = 4, DWORD minIntervalMs = 1500, size_t maxPending = 5);
+    ~ReplyQueue();
+    
+    void start();
+    void stop();   // Drops pending jobs; workers are joined in the destructor
+    // false if the lane is full. Jobs without a user (announcements) go only with their whole lane.
+    bool enqueue(const std::string& lane, const std::string& user, const std::string& messageId, Work work);
+    
+    // Each returns the number of jobs dropped or flagged
+    size_t cancelLane(const std::string& lane);
+    size_t cancelUser(const std::string& lane, const std::string& user);
+    size_t cancelMessage(const std::string& lane, const std::string& messageId);
+    // A pending job keeps its place and gets the new work; a running one is cancelled
+    // and the new work runs next, unless the lane is full. Either way the lane waits a
+    // moment for further edits. false if no job has that message id or no room.
+    bool replaceMessage(const std::string& lane, const std::string& messageId, Work work);
+    bool hasMessage(const std::string& lane, const std::string& messageId) const; // Pending or running
+    bool hasRoom(const std::string& lane) const; // Whether enqueue would take a job now
+    void setLaneInterval(const std::string& lane, DWORD intervalMs); // 0 = minIntervalMs
+    
+    std::string statsString() const;
+    
+private:
+    struct Job {
+        std::string user;
+        std::string messageId;
+        Work work;
+    };
+    struct Lane {
+        std::deque<Job> jobs;
+        bool busy = false;
+        bool scheduled = false;
+        ULONGLONG nextStart = 0;
+        // The job a worker is running, if any
+        std::string activeUser;
+        std::string activeMessageId;
+        std::shared_ptr<std::atomic<bool>> activeCancelled;
+    };
+    
+    int workerCount;
+    DWORD minIntervalMs;
+    size_t maxPending;
+    std::vector<std::thread> workers;
+    bool stopping;
+    
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::unordered_map<std::string, Lane> lanes; // Only while queued, running or pacing
+    std::deque<std::string> readyLanes;          // Scheduled and due now
+    std::priority_queue<std::pair<ULONGLONG, std::string>, std::vector<std::pair<ULONGLONG, std::string>>,
+                        std::greater<std::pair<ULONGLONG, std::string>>> pacedLanes; // (nextStart, lane), scheduled
+    std::deque<std::pair<ULONGLONG, std::string>> idleLanes; // (nextStart, lane) to erase once due
+    std::unordered_map<std::string, DWORD> laneIntervals;    // From setLaneInterval, outlives the lane
+    
+    std::atomic<uint64_t> completed;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> cancelled;
+    
+    void workerLoop();
+    void scheduleLane(const std::string& laneKey, Lane& lane);            // Mutex held
+    void releaseLane(std::unordered_map<std::string, Lane>::iterator it); // Mutex held
+    void sweepIdleLanes();                                                // Mutex held
+    size_t cancelWhere(const std::string& lane, const std::function<bool(const std::string& user,
+                                                                        const std::string& messageId)>& match);
+};
+
+// Outbound Discord REST queue. One FIFO lane per channel keeps replies to a channel
+// in order while a small worker pool posts to different channels in parallel.
+// Short messages that back up in a lane are merged into one post while the result
+// stays within maxPostLength characters (codepoints, as Discord counts them).
+class DiscordOutbox {
+public:
+    // Posts one message; returns 0 when sent, POST_FAILED when it failed for good, or
+    // a delay in ms after which the same content should be retried (HTTP 429)
+    typedef std::function<DWORD(const std::string& channelId, const std::string& content)> PostFn;
+    // Runs on a worker after the post, outside the outbox lock; it must not call stop()
+    typedef std::function<void()> Done;
+    static const DWORD POST_FAILED = 0xFFFFFFFF;
+    
+    DiscordOutbox(PostFn post, int workers = 4, size_t maxPostLength = 2000);
+    ~DiscordOutbox();
+    
+    void start();
+    void stop();   // Drops whatever is still queued and waits out running callbacks; workers are joined in the destructor
+    // done runs once the post has gone out or failed for good, but not after stop()
+    void enqueue(const std::string& channelId, const std::string& content, Done done = nullptr);
+    
+    // Per-channel 429 state. Other calls on the channel's route (typing) report
+    // their limits here and wait out the same delay as the queued posts.
+    void rateLimit(const std::string& channelId, DWORD delayMs);
+    DWORD rateLimitDelay(const std::string& channelId); // ms left, 0 = free
+    
+    std::string statsString() const;
+    
+private:
+    struct Message {
+        std::string content;
+        size_t length; // Codepoints
+        Done done;
+    };
+    struct Lane {
+        std::deque<Message> messages;
+        bool busy = false;      // A worker owns the lane
+        bool scheduled = false; // Listed in readyLanes
+    };
+    
+    PostFn post;
+    int workerCount;
+    size_t maxPostLength;
+    std::vector<std::thread> workers;
+    bool stopping;
+    
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable callbacksDone;
+    int runningCallbacks;
+    std::unordered_map<std::string, Lane> lanes;
+    std::deque<std::string> readyLanes;
+    std::unordered_map<std::string, ULONGLONG> limitedUntil; // Channel -> tick its 429 clears
+    
+    std::atomic<uint64_t> posted;
+    std::atomic<uint64_t> failed;
+    std::atomic<uint64_t> merged;
+    std::atomic<uint64_t> rateLimited;
+    
+    void workerLoop();
+    std::string takeBatchLocked(Lane& lane, std::vector<Done>& dones);
+    void rateLimitLocked(const std::string& channelId, DWORD delayMs);
+    DWORD rateLimitDelayLocked(const std::string& channelId);
+};
+
+// Keeps Discord's "is typing..." up in channels with a reply pending. Discord shows
+// it for about 10 s per trigger, so one thread re-triggers every held channel each
+// refreshMs until the last holder lets go. Rate limits are shared with the outbox.
+class DiscordTyping {
+public:
+    // Triggers typing once; returns 0, or a delay in ms before trying again (HTTP 429)
+    typedef std::function<DWORD(const std::string& channelId)> TriggerFn;
+    
+    DiscordTyping(DiscordOutbox& outbox, TriggerFn trigger, DWORD refreshMs = 8000);
+    ~DiscordTyping();
+    
+    void start();
+    void stop();
+    void begin(const std::string& channelId); // Typing shows right away...
+    void end(const std::string& channelId);   // ...and is refreshed until every begin() has ended
+    std::string statsString() const;
+    
+private:
+    struct Channel {
+        int holders = 0;
+        ULONGLONG nextAt = 0; // Next trigger due
+    };
+    
+    DiscordOutbox& outbox;
+    TriggerFn trigger;
+    DWORD refreshMs;
+    std::thread worker;
+    bool stopping;
+    
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::unordered_map<std::string, Channel> channels;
+    
+    std::atomic<uint64_t> triggered;
+    std::atomic<uint64_t> deferred; // Skipped while the channel was rate limited
+    
+    void workerLoop();
+};
+
+// Fixed-size open-addressing table of running cooldowns, keyed by a 64-bit hash of
+// (platform, channel, user). Expired entries are reused in place; when a probe window
+// is full of live entries the one closest to expiry is evicted, so memory never grows
+// past the capacity chosen up front and every check touches at most MAX_PROBE slots.
+class CooldownTable {
+public:
+    static const size_t MAX_PROBE = 16;
+    
+    explicit CooldownTable(size_t capacity = 65536); // Rounded up to a power of two
+    
+    static uint64_t makeKey(std::string_view platform, std::string_view channel, std::string_view user);
+    
+    // True (and the cooldown starts) if the key is not cooling down; 0 ms always passes
+    bool tryAcquire(uint64_t key, DWORD cooldownMs);
+    // Both or neither: a user blocked by the channel cooldown keeps their own slot free
+    bool tryAcquire(uint64_t keyA, DWORD cooldownA, uint64_t keyB, DWORD cooldownB);
+    
+    void clear();
+    size_t capacity() const { return slots.size(); }
+    uint64_t evictions() const { return evicted; }
+    
+private:
+    struct Slot {
+        uint64_t key;          // 0 = never used
+        ULONGLONG expiresAt;
+    };
+    
+    std::mutex mutex;
+    std::vector<Slot> slots;
+    size_t mask;
+    uint64_t evicted;
+    
+    Slot* findLocked(uint64_t key, ULONGLONG now, bool insert);
+};
+
+// Keyword rules from the profile, one per line:
+//   trigger [#channel] <pattern> [cooldown=<seconds>]   reply even without a mention
+//   ignore  [#channel] <pattern>                        never reply to a matching message
+// Patterns are matched as whole words, ignoring ASCII case; '*' at an end allows a
+// partial word there, and '*' in the middle allows anything in between. [abc] and
+// [a-z] match one character from a set; '^' / '$' pin the pattern to the start / end
+// of the message. All patterns are compiled into one Aho-Corasick automaton (a class
+// adds one literal per spelling), so a message is scanned once no matter how many
+// rules there are.
+class TriggerRules {
+public:
+    enum Result { NO_MATCH, TRIGGERED, IGNORED };
+    
+    TriggerRules();
+    std::vector<std::string> load(const std::string& text); // Returns problems, one per bad line
+    size_t ruleCount() const { return rules.size(); }
+    bool hasTriggers() const { return triggerCount > 0; }
+    
+    // IGNORED beats everything; TRIGGERED (only when checkTriggers) starts that rule's
+    // cooldown, or ignores it when startCooldown is false (re-checking an edited message)
+    Result evaluate(std::string_view message, std::string_view channel, bool checkTriggers,
+                    bool startCooldown = true);
+    
+private:
+    struct Piece {
+        int rule;
+        int index;       // Position within its rule
+        int length;
+        bool wordStart;  // Must not continue a word on the left
+        bool wordEnd;    // ...or on the right
+        bool anchorStart; // Must open the message
+        bool anchorEnd;   // Must close the message
+    };
+    struct Rule {
+        bool ignore;
+        std::string channel;    // Empty for every channel
+        int pieceCount;
+        DWORD cooldownMs;
+    };
+    struct State {
+        int fail;
+        int output;      // First literal ending here (or -1)
+        int outputLink;  // Next state on the fail chain with an output (or -1)
+    };
+    
+    std::vector<Rule> rules;
+    std::vector<std::vector<Piece>> literalPieces; // literal id -> pieces using it
+    std::vector<State> states;
+    std::vector<int> next;                         // states x classCount transitions
+    unsigned char byteClass[256];
+    int classCount;
+    int triggerCount;
+    
+    CooldownTable cooldowns; // (rule, channel)
+    
+    void build(const std::vector<std::string>& literals);
+};
+
+// Finds the bot's mentions in chat text in place: "@name" for each name or alias
+// (ASCII case-insensitive, not followed by another name character) and Discord's
+// "<@id>" / "<@!id>". Candidates are located by their first byte, 16 bytes at a time.
+class MentionMatcher {
+public:
+    struct Span {
+        size_t start;
+        size_t length;
+    };
+    
+    MentionMatcher();
+    void addName(const std::string& name);  // With or without the leading '@'
+    void addNames(const std::string& list); // Comma or space separated
+    void addUserId(const std::string& id);
+    bool empty() const { return patterns.empty(); }
+    
+    bool find(std::string_view text, Span& span, size_t from = 0) const; // Leftmost, longest
+    bool matches(std::string_view text) const { Span span; return find(text, span); }
+    std::string strip(std::string_view text) const; // Every mention removed, whitespace trimmed
+    
+private:
+    struct Pattern {
+        std::string text;  // Lowercase
+        bool wordEnd;      // Must not run into a following name character
+    };
+    std::vector<Pattern> patterns;
+    unsigned char leads[4]; // Distinct first bytes, for the vector scan
+    int leadCount;          // > 4 falls back to the byte table
+    bool isLead[256];
+    
+    void addPattern(const std::string& text, bool wordEnd);
+    size_t nextCandidate(const char* data, size_t from, size_t len) const;
+    bool matchAt(std::string_view text, size_t pos, const Pattern& p) const;
+};
+
+// One Discord gateway connection (shard). All shards feed the same dispatcher.
+struct DiscordShard {
+    int id;
+    std::thread thread;
+    std::string sessionId;
+    std::string resumeHost;          // resume_gateway_url host from READY
+    std::atomic<int> sequenceNumber;
+    SOCKET socket;
+    std::mutex sendMutex;            // Serializes TLS writes (read loop vs heartbeat)
+    
+    // Heartbeat state
+    std::atomic<bool> awaitingAck;
+    std::atomic<ULONGLONG> heartbeatSentAt;
+    std::atomic<int> rttMs;          // Last heartbeat -> ACK round trip, -1 if unknown
+    std::atomic<bool> resumeNow;     // Dropped on purpose to resume (zombie connection / op 7)
+    ReconnectPolicy reconnect;
+    
+    DiscordShard(int shardId) : id(shardId), sequenceNumber(0), socket(INVALID_SOCKET),
+                                awaitingAck(false), heartbeatSentAt(0), rttMs(-1), resumeNow(false) {}
+};
+
 // Discord WebSocket Client
 class DiscordBot {
 private:
@@ -169,15 +803,36 @@ private:
     KindroidAPI* kindroid;
     HWND consoleHwnd;
     
-    std::string sessionId;
-    int sequenceNumber;
     std::atomic<bool> shouldReconnect;
+    HANDLE stopEvent; // Signaled by stop() to cancel heartbeat and reconnect waits
+    
+    // Sharding (from /gateway/bot)
+    std::string gatewayHost;
+    int shardCount;
+    int maxConcurrency;
+    std::vector<std::unique_ptr<DiscordShard>> shards;
+    std::mutex identifyMutex;
+    std::vector<ULONGLONG> identifyBuckets; // Next allowed IDENTIFY tick per rate_limit_key
     
-    SOCKET currentSocket;
-    std::mutex socketMutex;
-    std::map<std::string, std::string> channelNames; // channelId -> channelName
-    std::string guildName; // Server name
+    std::mutex socketMutex; // Guards shards and their sockets
+    GuildCache guildCache;
+    std::atomic<uint64_t> handledEvents;
+    std::atomic<uint64_t> skippedEvents; // Dropped by the pre-filter without parsing
+    TriggerRules triggers;     // Loaded before start(), read-only while running
+    CooldownTable cooldowns;   // (channel, user) and (channel) reply cooldowns
+    DWORD userCooldownMs;
+    DWORD channelCooldownMs;
+    std::mutex stateMutex;  // Guards the fields below (shared by all shards)
+    std::set<std::string> pendingLookups; // Channels being backfilled over REST
+    std::string botUserId;     // From READY
+    std::string mentionNeedle; // "id":"<botUserId>" as it appears in a mentions array
+    std::shared_ptr<const MentionMatcher> mentionMatcher; // <@botUserId> and aliases, swapped whole on READY
+    std::string mentionAliases; // Set before start()
     std::string lastChannelId; // Last channel that had activity (for announcements)
+    DiscordOutbox outbox;      // Its workers call back into the bot
+    DiscordTyping typing;      // Its thread calls back into the bot and the outbox
+    ReplyQueue backfills;      // Channel name lookups over REST, one at a time
+    ReplyQueue replies;        // Declared last: its workers call back into the bot, outbox and typing
 	
 public:
     DiscordBot(const std::string& token, KindroidAPI* api, HWND console);
@@ -187,56 +842,167 @@ public:
     void stop();
     bool isRunning() const { return running; }
     void sendAnnouncement(const std::string& message, const std::string& channelId = ""); // For announcements
+    void setTriggerRules(const std::string& rulesText); // Before start()
+    void setMentionAliases(const std::string& aliasList); // Before start()
+    void setCooldowns(int userSecs, int channelSecs);   // Before start()
+    int getGatewayRtt(); // Worst heartbeat ACK round trip across shards in ms, -1 if unknown
     
 private:
     void run();
-    void connectWebSocket();
-    void handleGatewayMessage(const std::string& message, struct SchannelContext* ssl);
-    void sendHeartbeat(struct SchannelContext* ssl, int interval);
-    void sendIdentify(struct SchannelContext* ssl);
-    void sendResume(struct SchannelContext* ssl);
-    void handleDispatch(const std::map<std::string, std::string>& data);
-    void processMessage(const std::map<std::string, std::string>& messageData);
+    bool fetchGatewayInfo();
+    void runShard(DiscordShard* shard);
+    void connectWebSocket(DiscordShard* shard);
+    bool waitForIdentifySlot(DiscordShard* shard); // false if stopped while waiting
+    void dropConnection(DiscordShard* shard);
+    void handleGatewayMessage(const std::string& message, DiscordShard* shard, struct SchannelContext* ssl);
+    bool mentionsBot(const std::string& frame);
+    bool isAddressed(std::string& content, const std::string& channelId, bool startCooldown);
+    void sendHeartbeat(struct SchannelContext* ssl, DiscordShard* shard);
+    void sendIdentify(struct SchannelContext* ssl, DiscordShard* shard);
+    void sendResume(struct SchannelContext* ssl, DiscordShard* shard);
     std::pair<std::string, std::string> getChannelInfo(const std::string& channelId);
+    void backfillChannelInfo(const std::string& channelId);
     
     std::string httpRequest(const std::string& host, const std::string& path);
-    void sendDiscordMessage(const std::string& channelId, const std::string& content);
+    void sendDiscordMessage(const std::string& channelId, const std::string& content,
+                            DiscordOutbox::Done done = nullptr); // Queued; done after the last part
+    DWORD postDiscordMessage(const std::string& channelId, const std::string& content); // Outbox worker
+    DWORD postTyping(const std::string& channelId); // Typing thread
+    ReplyQueue::Work replyWork(const std::string& username, const std::string& channelId, const std::string& content);
+    void replyToMessage(const std::string& username, const std::string& channelId, const std::string& content,
+                        const std::atomic<bool>& cancelled);
     
     void log(const std::string& message);
 };
 
-// Twitch IRC Bot
+// One IRC line split in place: "@tags :prefix COMMAND params :trailing" (IRCv3).
+// All views point into the parsed line, which must outlive the message.
+// Tag values stay escaped until asked for.
+struct IrcMessage {
+    static const int MAX_PARAMS = 15;
+    
+    std::string_view tags;    // "k=v;k2=v2" without the '@'
+    std::string_view prefix;  // "nick!user@host" without the ':'
+    std::string_view command; // "PRIVMSG", "001", ...
+    std::string_view params[MAX_PARAMS];
+    int paramCount = 0;
+    
+    bool parse(std::string_view line); // false if there is no command
+    
+    std::string_view param(int i) const { return i < paramCount ? params[i] : std::string_view(); }
+    std::string_view nick() const;                       // Prefix up to '!'
+    bool findTag(std::string_view key, std::string_view& value) const; // false if absent
+    std::string_view rawTag(std::string_view key) const; // Escaped value, empty if absent
+    std::string tag(std::string_view key) const;         // Unescaped value
+    
+    // Twitch tags (twitch.tv/tags)
+    std::string displayName() const { return tag("display-name"); }
+    std::string_view userId() const { return rawTag("user-id"); }
+    std::string_view roomId() const { return rawTag("room-id"); }
+    std::string_view badges() const { return rawTag("badges"); }   // "moderator/1,subscriber/12"
+    std::string_view emotes() const { return rawTag("emotes"); }   // "25:0-4,12-16/1902:6-10"
+};
+
+// Splits a byte stream into lines ("\r\n" or "\n"), handed out as views into the
+// buffer. Consumed lines are skipped by offset; the buffer is compacted only when
+// more than half of it is consumed, so a burst of N lines costs O(N), not O(N^2).
+class LineBuffer {
+public:
+    void append(const char* data, size_t len);
+    bool next(std::string_view& line); // Line without its terminator; valid until the next append
+    size_t pending() const { return buffer.size() - readPos; }
+    void clear();
+    
+private:
+    std::string buffer;
+    size_t readPos = 0; // Start of the first unconsumed line
+    size_t scanPos = 0; // Where the search for '\n' resumes (bytes before it have none)
+};
+
+// One Twitch IRC connection serving a slice of the channel list
+struct TwitchConnection {
+    int id;
+    std::vector<std::string> channels; // Lowercase, without '#'
+    std::thread thread;
+    SOCKET socket;
+    struct SchannelContext* ssl;       // Set while connected (swapped under socketMutex and sendMutex)
+    std::mutex sendMutex;              // Serializes writes to the TLS context; held while sending
+    std::atomic<bool> connected;
+    ReconnectPolicy reconnect;
+    
+    TwitchConnection(int connId) : id(connId), socket(INVALID_SOCKET), ssl(nullptr), connected(false) {}
+};
+
+// Twitch IRC Bot (IRC over WebSocket, or raw IRC over TLS). Joins any number of
+// channels, spreading them over as many connections as channelsPerConnection requires.
 class TwitchBot {
 private:
     std::string username;
     std::string oauthToken;
-    std::string channel;
+    std::vector<std::string> channels;
+    size_t channelsPerConnection;
+    bool rawIrc;            // irc.chat.twitch.tv:6697 instead of IRC over WebSocket
+    std::string serverHost; // setServer() override, empty for Twitch's own
+    std::string serverPort;
     std::atomic<bool> running;
     std::thread botThread;
     KindroidAPI* kindroid;
     HWND consoleHwnd;
     
-    SOCKET currentSocket;
-    struct SchannelContext* currentSSL; // For sending announcements
-    std::mutex socketMutex;
+    std::vector<std::unique_ptr<TwitchConnection>> connections;
+    std::unordered_map<std::string, TwitchConnection*> channelOwner; // channel -> its connection
+    std::mutex socketMutex; // Guards each connection's socket and ssl swaps (never held while sending)
+    HANDLE stopEvent;       // Signaled by stop() to cut reconnect and rate-limit waits short
+    MentionMatcher mentions; // @username
+    TriggerRules triggers;
+    CooldownTable cooldowns; // (channel, user) and (channel) reply cooldowns
+    DWORD userCooldownMs;
+    DWORD channelCooldownMs;
+    
+    // Chat modes from ROOMSTATE (twitch.tv/commands), per channel
+    struct RoomState {
+        bool emoteOnly = false; // Text replies would be rejected
+        int slowSecs = 0;       // Minimum gap between our messages in the channel
+    };
+    std::mutex roomMutex;
+    std::unordered_map<std::string, RoomState> rooms;
+    
+    RateLimiter joinLimiter;    // Twitch: 20 JOINs per 10 s per account
+    RateLimiter messageLimiter; // Twitch: 20 PRIVMSGs per 30 s per account
+    ReplyQueue replies;         // Declared last: its workers call back into the bot
     
 public:
-    TwitchBot(const std::string& user, const std::string& oauth, const std::string& chan, 
-              KindroidAPI* api, HWND console);
+    TwitchBot(const std::string& user, const std::string& oauth, const std::string& channelList,
+              KindroidAPI* api, HWND console, int channelsPerConnection = 50, bool rawIrc = false);
     ~TwitchBot();
     
     void start();
     void stop();
     bool isRunning() const { return running; }
-    void sendAnnouncement(const std::string& message); // For announcements
+    void sendAnnouncement(const std::string& message); // For announcements, to every channel
+    void setTriggerRules(const std::string& rulesText); // Before start()
+    void setMentionAliases(const std::string& aliasList); // Before start()
+    void setCooldowns(int userSecs, int channelSecs);   // Before start()
+    void setServer(const std::string& host, const std::string& port); // Before start(); mock servers
+    void setRateLimits(size_t joins, DWORD joinWindowMs, size_t messages, DWORD messageWindowMs); // Likewise
+    size_t channelCount() const { return channels.size(); }
+    
+    static std::vector<std::string> parseChannelList(const std::string& channelList);
     
 private:
     void run();
-    void connectIRC();
-    void handleMessage(const std::string& line, struct SchannelContext* ssl);
-    void sendIRCMessage(struct SchannelContext* ssl, const std::string& message);
-    void sendChatMessage(struct SchannelContext* ssl, const std::string& message);
-    void processChatMessage(struct SchannelContext* ssl, const std::string& user, const std::string& message);
+    void runConnection(TwitchConnection* conn);
+    void connectIRC(TwitchConnection* conn);
+    bool upgradeWebSocket(SchannelContext* ssl);
+    void joinChannels(TwitchConnection* conn);
+    void handleMessage(std::string_view line, TwitchConnection* conn);
+    void handleModeration(const IrcMessage& msg); // CLEARCHAT, CLEARMSG, ROOMSTATE
+    bool isEmoteOnly(const std::string& channel);
+    void sendIRCMessage(TwitchConnection* conn, const std::string& message);
+    void sendChatMessage(const std::string& channel, const std::string& message);
+    // userKey and messageId let moderation cancel the reply (see handleModeration)
+    void processChatMessage(const std::string& channel, const std::string& user, const std::string& userKey,
+                            const std::string& messageId, const std::string& message);
     
     void log(const std::string& message);
 };
@@ -247,6 +1013,12 @@ std::wstring stringToWstring(const std::string& str);
 std::string censorString(const std::string& str);
 std::string getCurrentTimestamp();
 std::string base64Encode(const std::string& input);
+DWORD randomDelay(DWORD maxMs);
+size_t utf8Length(const std::string& text); // Codepoints; malformed bytes count as one each
+// Split text into chunks of at most maxChars codepoints, preferring paragraph, line,
+// sentence and then word boundaries. With markdown set, code fences left open at a
+// cut are closed and reopened in the next chunk.
+std::vector<std::string> splitMessage(const std::string& text, size_t maxChars, bool markdown);
 
 // Global variables
 extern HINSTANCE g_hInstance;
@@ -114,11 +114,15 @@ HWND g_hwndAnnounceTwitch = NULL;
 HWND g_hwndHoursSpin = NULL;
 HWND g_hwndMinsSpin = NULL;
 
+// Trigger rules
+HWND g_hwndTriggerRules = NULL;
+
 // Section control arrays for show/hide
 std::vector<HWND> g_kindroidControls;
 std::vector<HWND> g_discordControls;
 std::vector<HWND> g_twitchControls;
 std::vector<HWND> g_announceControls;
+std::vector<HWND> g_triggerControls;
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
     g_hInstance = hInstance;
@@ -403,6 +407,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                 delete g_kindroid;
                 g_kindroid = nullptr;
             }
+            HttpClient::shutdown();
             // Cleanup dark mode brushes
             if (g_hBrushDarkBg) DeleteObject(g_hBrushDarkBg);
             if (g_hBrushDarkEdit) DeleteObject(g_hBrushDarkEdit);
@@ -506,6 +511,8 @@ void CreateGUI(HWND hwnd) {
     TabCtrl_InsertItem(g_hwndTabControl, 2, &tie);
     tie.pszText = (LPWSTR)L"Announcements";
     TabCtrl_InsertItem(g_hwndTabControl, 3, &tie);
+    tie.pszText = (LPWSTR)L"Triggers";
+    TabCtrl_InsertItem(g_hwndTabControl, 4, &tie);
     
     // Tab content area starts below tab headers
     int tabY = y + 28;
@@ -656,6 +663,18 @@ void CreateGUI(HWND hwnd) {
     SendMessage(hCtrl, WM_SETFONT, (WPARAM)hFont, TRUE);
     g_announceControls.push_back(hCtrl);
     
+    // ========== Trigger Rules (Tab 4) ==========
+    hCtrl = CreateWindowW(L"STATIC", L"One rule per line: trigger|ignore [#channel] <pattern> [cooldown=<seconds>]",
+        WS_CHILD | SS_LEFT, tabX, tabY, 540, 20, hwnd, NULL, g_hInstance, NULL);
+    SendMessage(hCtrl, WM_SETFONT, (WPARAM)hFont, TRUE);
+    g_triggerControls.push_back(hCtrl);
+    
+    g_hwndTriggerRules = CreateWindowW(L"EDIT", L"",
+        WS_CHILD | WS_BORDER | WS_VSCROLL | ES_LEFT | ES_MULTILINE | ES_AUTOVSCROLL | ES_WANTRETURN,
+        tabX, tabY + 22, 540, 112, hwnd, (HMENU)IDC_TRIGGER_RULES, g_hInstance, NULL);
+    SendMessage(g_hwndTriggerRules, WM_SETFONT, (WPARAM)hFont, TRUE);
+    g_triggerControls.push_back(g_hwndTriggerRules);
+    
     // Move y past the tab control (tab height 175 + enable checkboxes 28)
     y += 185;
     
@@ -728,6 +747,7 @@ void UpdateTabVisibility() {
     for (HWND ctrl : g_discordControls) ShowWindow(ctrl, SW_HIDE);
     for (HWND ctrl : g_twitchControls) ShowWindow(ctrl, SW_HIDE);
     for (HWND ctrl : g_announceControls) ShowWindow(ctrl, SW_HIDE);
+    for (HWND ctrl : g_triggerControls) ShowWindow(ctrl, SW_HIDE);
     
     // Show current tab contents
     switch (g_currentTab) {
@@ -743,6 +763,9 @@ void UpdateTabVisibility() {
         case 3: // Announcements
             for (HWND ctrl : g_announceControls) ShowWindow(ctrl, SW_SHOW);
             break;
+        case 4: // Triggers
+            for (HWND ctrl : g_triggerControls) ShowWindow(ctrl, SW_SHOW);
+            break;
     }
 }
 
@@ -823,6 +846,24 @@ void RefreshProfileCombo(HWND hwnd) {
     EnableWindow(g_hwndDeleteProfileBtn, !g_profiles.empty());
 }
 
+// Multi-line edit controls want "\r\n"; the profile keeps plain '\n'
+std::string GetMultilineText(HWND edit) {
+    int length = GetWindowTextLengthA(edit);
+    std::string text(length + 1, '\0');
+    text.resize(GetWindowTextA(edit, &text[0], length + 1));
+    text.erase(std::remove(text.begin(), text.end(), '\r'), text.end());
+    return text;
+}
+
+void SetMultilineText(HWND edit, const std::string& text) {
+    std::string windowsText;
+    for (char c : text) {
+        if (c == '\n') windowsText += '\r';
+        if (c != '\r') windowsText += c;
+    }
+    SetWindowTextA(edit, windowsText.c_str());
+}
+
 void LoadProfileToGUI(HWND hwnd, const BotConfig& profile) {
     SetWindowTextA(g_hwndProfileName, profile.profileName.c_str());
     SetWindowTextA(g_hwndDiscordToken, censorString(profile.discordToken).c_str());
@@ -846,6 +887,8 @@ void LoadProfileToGUI(HWND hwnd, const BotConfig& profile) {
     SendMessage(g_hwndAnnounceDiscord, BM_SETCHECK, profile.announceDiscord ? BST_CHECKED : BST_UNCHECKED, 0);
     SendMessage(g_hwndAnnounceTwitch, BM_SETCHECK, profile.announceTwitch ? BST_CHECKED : BST_UNCHECKED, 0);
     
+    SetMultilineText(g_hwndTriggerRules, profile.triggerRules);
+    
     // Store the actual values in g_config
     g_config = profile;
     g_currentProfileName = profile.profileName;
@@ -954,6 +997,21 @@ void OnSaveProfile(HWND hwnd) {
     
     profile.twitchEnabled = (SendMessage(g_hwndTwitchEnable, BM_GETCHECK, 0, 0) == BST_CHECKED);
     
+    // Not on the form - keep the values the profile already has
+    if (g_currentProfileName == profileName) {
+        profile.twitchChannelsPerConnection = g_config.twitchChannelsPerConnection;
+        profile.twitchRawIrc = g_config.twitchRawIrc;
+        profile.mentionAliases = g_config.mentionAliases;
+        profile.userCooldownSecs = g_config.userCooldownSecs;
+        profile.channelCooldownSecs = g_config.channelCooldownSecs;
+    } else if (BotConfig* existing = ProfileManager::findProfile(g_profiles, profileName)) {
+        profile.twitchChannelsPerConnection = existing->twitchChannelsPerConnection;
+        profile.twitchRawIrc = existing->twitchRawIrc;
+        profile.mentionAliases = existing->mentionAliases;
+        profile.userCooldownSecs = existing->userCooldownSecs;
+        profile.channelCooldownSecs = existing->channelCooldownSecs;
+    }
+    
     // Get Announcement settings
     GetWindowTextA(g_hwndAnnounceMsg, buffer, 512);
     profile.announceMessage = buffer;
@@ -964,6 +1022,8 @@ void OnSaveProfile(HWND hwnd) {
     profile.announceDiscord = (SendMessage(g_hwndAnnounceDiscord, BM_GETCHECK, 0, 0) == BST_CHECKED);
     profile.announceTwitch = (SendMessage(g_hwndAnnounceTwitch, BM_GETCHECK, 0, 0) == BST_CHECKED);
     
+    profile.triggerRules = GetMultilineText(g_hwndTriggerRules);
+    
     // Validate
     if (profile.discordToken.empty() || profile.discordToken.find('*') != std::string::npos) {
         MessageBoxA(hwnd, "Please enter a valid Discord token!", "Error", MB_OK | MB_ICONERROR);
@@ -1061,6 +1121,8 @@ void OnNewProfile(HWND hwnd) {
     SendMessage(g_hwndAnnounceDiscord, BM_SETCHECK, BST_UNCHECKED, 0);
     SendMessage(g_hwndAnnounceTwitch, BM_SETCHECK, BST_UNCHECKED, 0);
     
+    SetWindowTextA(g_hwndTriggerRules, "");
+    
     // Deselect combo
     SendMessage(g_hwndProfileCombo, CB_SETCURSEL, (WPARAM)-1, 0);
     
@@ -1214,6 +1276,8 @@ void OnStartBot(HWND hwnd) {
     g_config.announceDiscord = (SendMessage(g_hwndAnnounceDiscord, BM_GETCHECK, 0, 0) == BST_CHECKED);
     g_config.announceTwitch = (SendMessage(g_hwndAnnounceTwitch, BM_GETCHECK, 0, 0) == BST_CHECKED);
     
+    g_config.triggerRules = GetMultilineText(g_hwndTriggerRules);
+    
     // Validation - need at least one bot enabled
     if (!g_config.discordEnabled && !g_config.twitchEnabled) {
         MessageBoxA(hwnd, "Please enable at least one bot (Discord or Twitch)!", "Error", MB_OK | MB_ICONERROR);
@@ -1254,11 +1318,15 @@ void OnStartBot(HWND hwnd) {
     // Create Kindroid API client
     if (g_kindroid) delete g_kindroid;
     g_kindroid = new KindroidAPI(g_config.apiKey, g_config.aiId, g_config.baseUrl);
+    g_kindroid->prewarm();
     
     // Create and start Discord bot if enabled
     if (g_config.discordEnabled) {
         if (g_bot) delete g_bot;
         g_bot = new DiscordBot(g_config.discordToken, g_kindroid, g_hwndMain);
+        g_bot->setTriggerRules(g_config.triggerRules);
+        g_bot->setMentionAliases(g_config.mentionAliases);
+        g_bot->setCooldowns(g_config.userCooldownSecs, g_config.channelCooldownSecs);
         g_bot->start();
         AppendConsoleText(hwnd, "[INFO] Discord bot enabled\n");
     }
@@ -1267,9 +1335,14 @@ void OnStartBot(HWND hwnd) {
     if (g_config.twitchEnabled) {
         if (g_twitchBot) delete g_twitchBot;
         g_twitchBot = new TwitchBot(g_config.twitchUsername, g_config.twitchOAuth, 
-                                     g_config.twitchChannel, g_kindroid, g_hwndMain);
+                                     g_config.twitchChannel, g_kindroid, g_hwndMain,
+                                     g_config.twitchChannelsPerConnection, g_config.twitchRawIrc);
+        g_twitchBot->setTriggerRules(g_config.triggerRules);
+        g_twitchBot->setMentionAliases(g_config.mentionAliases);
+        g_twitchBot->setCooldowns(g_config.userCooldownSecs, g_config.channelCooldownSecs);
         g_twitchBot->start();
-        AppendConsoleText(hwnd, "[INFO] Twitch bot enabled for #" + g_config.twitchChannel + "\n");
+        AppendConsoleText(hwnd, "[INFO] Twitch bot enabled for " + std::to_string(g_twitchBot->channelCount()) +
+                          " channel(s): " + g_config.twitchChannel + "\n");
     }
     
     // Update UI - disable editing while running
@@ -1294,6 +1367,7 @@ void OnStartBot(HWND hwnd) {
     EnableWindow(g_hwndAnnounceMins, FALSE);
     EnableWindow(g_hwndAnnounceDiscord, FALSE);
     EnableWindow(g_hwndAnnounceTwitch, FALSE);
+    EnableWindow(g_hwndTriggerRules, FALSE);
     
     // Start announcement timer if configured
     if (!g_config.announceMessage.empty() && (g_config.announceDiscord || g_config.announceTwitch)) {
@@ -1352,6 +1426,7 @@ void OnStopBot(HWND hwnd) {
     EnableWindow(g_hwndAnnounceMins, TRUE);
     EnableWindow(g_hwndAnnounceDiscord, TRUE);
     EnableWindow(g_hwndAnnounceTwitch, TRUE);
+    EnableWindow(g_hwndTriggerRules, TRUE);
 }
 
 void OnSaveConfig(HWND hwnd) {
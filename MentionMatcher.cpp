@@ -0,0 +1,149 @@
+#include "KindroidBot.h"
+
+// ============================================
+// MentionMatcher - in-place mention search
+// ============================================
+
+// Candidate bytes are found 16 at a time with SSE2 (x64 baseline), the same way
+// the JSON escaping scans work; other targets use the byte table.
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define MENTION_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static inline unsigned lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+#endif
+
+static inline bool isNameChar(unsigned char c) {
+    return isalnum(c) || c == '_';
+}
+
+MentionMatcher::MentionMatcher() : leadCount(0) {
+    memset(isLead, 0, sizeof(isLead));
+}
+
+void MentionMatcher::addPattern(const std::string& text, bool wordEnd) {
+    if (text.empty()) return;
+    
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (const auto& p : patterns) {
+        if (p.text == lower && p.wordEnd == wordEnd) return;
+    }
+    patterns.push_back({ lower, wordEnd });
+    
+    // Both cases of a letter can start a case-insensitive match
+    unsigned char first = (unsigned char)lower[0];
+    unsigned char variants[2] = { first, (unsigned char)toupper(first) };
+    for (unsigned char c : variants) {
+        if (isLead[c]) continue;
+        isLead[c] = true;
+        if (leadCount < 4) leads[leadCount] = c;
+        leadCount++;
+    }
+}
+
+void MentionMatcher::addName(const std::string& name) {
+    std::string bare = (!name.empty() && name[0] == '@') ? name.substr(1) : name;
+    if (bare.empty()) return;
+    addPattern("@" + bare, true);
+}
+
+void MentionMatcher::addNames(const std::string& list) {
+    size_t pos = 0;
+    while (pos < list.length()) {
+        size_t start = list.find_first_not_of(", \t\r\n", pos);
+        if (start == std::string::npos) break;
+        size_t end = list.find_first_of(", \t\r\n", start);
+        if (end == std::string::npos) end = list.length();
+        addName(list.substr(start, end - start));
+        pos = end;
+    }
+}
+
+void MentionMatcher::addUserId(const std::string& id) {
+    if (id.empty()) return;
+    addPattern("<@" + id + ">", false);
+    addPattern("<@!" + id + ">", false);
+}
+
+size_t MentionMatcher::nextCandidate(const char* data, size_t from, size_t len) const {
+    size_t i = from;
+#ifdef MENTION_SSE2
+    if (leadCount <= 4) {
+        __m128i lead[4];
+        for (int k = 0; k < 4; k++) {
+            lead[k] = _mm_set1_epi8((char)leads[k < leadCount ? k : 0]);
+        }
+        for (; i + 16 <= len; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lead[0]), _mm_cmpeq_epi8(v, lead[1])),
+                                       _mm_or_si128(_mm_cmpeq_epi8(v, lead[2]), _mm_cmpeq_epi8(v, lead[3])));
+            unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+            if (mask) return i + lowestBit(mask);
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        if (isLead[(unsigned char)data[i]]) return i;
+    }
+    return len;
+}
+
+bool MentionMatcher::matchAt(std::string_view text, size_t pos, const Pattern& p) const {
+    if (text.size() - pos < p.text.size()) return false;
+    for (size_t k = 0; k < p.text.size(); k++) {
+        if (tolower((unsigned char)text[pos + k]) != (unsigned char)p.text[k]) return false;
+    }
+    size_t end = pos + p.text.size();
+    return !p.wordEnd || end == text.size() || !isNameChar((unsigned char)text[end]);
+}
+
+bool MentionMatcher::find(std::string_view text, Span& span, size_t from) const {
+    if (patterns.empty()) return false;
+    
+    size_t pos = from;
+    while ((pos = nextCandidate(text.data(), pos, text.size())) < text.size()) {
+        size_t best = 0;
+        for (const auto& p : patterns) {
+            if (p.text.size() > best && matchAt(text, pos, p)) best = p.text.size();
+        }
+        if (best > 0) {
+            span.start = pos;
+            span.length = best;
+            return true;
+        }
+        pos++;
+    }
+    return false;
+}
+
+std::string MentionMatcher::strip(std::string_view text) const {
+    std::string result;
+    result.reserve(text.size());
+    
+    size_t pos = 0;
+    Span span;
+    while (find(text, span, pos)) {
+        result.append(text.substr(pos, span.start - pos));
+        pos = span.start + span.length;
+        // "hey @bot how" -> "hey how", not "hey  how"
+        if (!result.empty() && result.back() == ' ' && pos < text.size() && text[pos] == ' ') pos++;
+    }
+    result.append(text.substr(pos));
+    
+    size_t start = result.find_first_not_of(" \t\n\r");
+    if (start == std::string::npos) return std::string();
+    size_t end = result.find_last_not_of(" \t\n\r");
+    return result.substr(start, end - start + 1);
+}
@@ -0,0 +1,179 @@
+#include "KindroidBot.h"
+
+// ============================================
+// splitMessage - UTF-8 aware chunking for chat limits
+// ============================================
+
+// Byte length of the UTF-8 sequence starting at p. Malformed or truncated
+// sequences count as a single byte so a bad byte can never swallow good text.
+static size_t utf8SequenceLength(const unsigned char* p, const unsigned char* end) {
+    unsigned char c = p[0];
+    size_t len;
+    if (c < 0x80) return 1;
+    else if (c >= 0xC2 && c <= 0xDF) len = 2;
+    else if (c >= 0xE0 && c <= 0xEF) len = 3;
+    else if (c >= 0xF0 && c <= 0xF4) len = 4;
+    else return 1;
+    
+    if ((size_t)(end - p) < len) return 1;
+    for (size_t i = 1; i < len; i++) {
+        if ((p[i] & 0xC0) != 0x80) return 1;
+    }
+    return len;
+}
+
+size_t utf8Length(const std::string& text) {
+    const unsigned char* p = (const unsigned char*)text.data();
+    const unsigned char* end = p + text.size();
+    size_t count = 0;
+    while (p < end) {
+        p += utf8SequenceLength(p, end);
+        count++;
+    }
+    return count;
+}
+
+namespace {
+
+// Where a chunk may end, best kind first
+enum BreakKind { BREAK_PARAGRAPH, BREAK_LINE, BREAK_SENTENCE, BREAK_WORD, BREAK_KINDS };
+
+struct FenceState {
+    bool open = false;
+    size_t langStart = 0; // Info string after the opening ``` (e.g. "cpp")
+    size_t langLen = 0;
+    size_t bodyStart = 0; // First byte after the opening fence line
+};
+
+struct BreakPoint {
+    size_t pos = 0;       // Byte offset where the chunk ends
+    FenceState fence;     // Fence state at that offset
+    bool valid = false;
+};
+
+// Length of a language tag like "cpp" or "c++" running up to the end of the
+// line, or 0 when the rest of the line is anything else (inline fences etc.)
+size_t infoStringLength(const std::string& text, size_t start) {
+    size_t i = start;
+    while (i < text.size() && i - start <= 20) {
+        char c = text[i];
+        if (c == '\n' || c == '\r') return i - start;
+        if (!isalnum((unsigned char)c) && c != '+' && c != '#' && c != '-' && c != '_' && c != '.') break;
+        i++;
+    }
+    return i == text.size() ? i - start : 0;
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+}
+
+std::vector<std::string> splitMessage(const std::string& text, size_t maxChars, bool markdown) {
+    std::vector<std::string> chunks;
+    const char* data = text.data();
+    const size_t n = text.size();
+    const unsigned char* bytes = (const unsigned char*)data;
+    
+    static const char FENCE[] = "```";
+    static const size_t CLOSE_LEN = 4; // "\n```"
+    bool hasFences = markdown && text.find(FENCE) != std::string::npos;
+    
+    FenceState fence;
+    size_t pos = 0;
+    while (pos < n && isSpace(data[pos])) pos++;
+    
+    while (pos < n) {
+        // A chunk that starts inside a code block reopens it with the same language
+        FenceState startFence = fence;
+        if (startFence.open && maxChars < 4 + startFence.langLen + CLOSE_LEN + 16) {
+            startFence.langLen = 0; // Tiny limit - reopen without the language tag
+        }
+        size_t prefixChars = startFence.open ? 4 + startFence.langLen : 0; // "```lang\n"
+        size_t budget = maxChars;
+        if (hasFences) {
+            // Leave room to close a block that is still open where we cut
+            budget = maxChars > prefixChars + CLOSE_LEN + 1 ? maxChars - prefixChars - CLOSE_LEN : 1;
+        }
+        
+        // Walk forward one codepoint at a time, remembering the last break of each kind
+        BreakPoint breaks[BREAK_KINDS];
+        size_t chars = 0;
+        size_t i = pos;
+        while (i < n && chars < budget) {
+            if (hasFences && data[i] == '`' && text.compare(i, 3, FENCE) == 0) {
+                if (chars > 0 && chars + 3 > budget) break; // Never split a fence marker
+                if (fence.open) {
+                    fence.open = false;
+                } else {
+                    fence.open = true;
+                    fence.langStart = i + 3;
+                    fence.langLen = infoStringLength(text, i + 3);
+                    fence.bodyStart = i + 3 + fence.langLen + 1;
+                }
+                i += 3;
+                chars += 3;
+                continue;
+            }
+            
+            char c = data[i];
+            i += utf8SequenceLength(bytes + i, bytes + n);
+            chars++;
+            
+            // Break *after* this character; in a code block only line breaks are considered
+            int kind = -1;
+            if (c == '\n') {
+                kind = (i < n && data[i] == '\n') ? BREAK_PARAGRAPH : BREAK_LINE;
+            } else if (!fence.open) {
+                if ((c == '.' || c == '!' || c == '?') && i < n && isSpace(data[i])) kind = BREAK_SENTENCE;
+                else if (c == ' ' || c == '\t') kind = BREAK_WORD;
+            }
+            // A cut right after an opening fence line would leave an empty block behind
+            if (kind >= 0 && !(fence.open && i == fence.bodyStart)) {
+                breaks[kind].pos = i;
+                breaks[kind].fence = fence;
+                breaks[kind].valid = true;
+            }
+        }
+        
+        size_t cut = i;
+        FenceState cutFence = fence;
+        if (i < n) {
+            // Prefer the best kind of break that keeps the chunk at least half full
+            size_t minPos = pos + (i - pos) / 2;
+            for (int kind = 0; kind < BREAK_KINDS; kind++) {
+                if (breaks[kind].valid && breaks[kind].pos > minPos) {
+                    cut = breaks[kind].pos;
+                    cutFence = breaks[kind].fence;
+                    break;
+                }
+            }
+        }
+        
+        // Drop whitespace at the seam; the trimmed bytes are never inside a codepoint
+        size_t end = cut;
+        while (end > pos && isSpace(data[end - 1])) end--;
+        
+        std::string chunk;
+        chunk.reserve(end - pos + 16 + startFence.langLen);
+        if (startFence.open) {
+            chunk.append(FENCE, 3);
+            chunk.append(data + startFence.langStart, startFence.langLen);
+            chunk += '\n';
+        }
+        chunk.append(data + pos, end - pos);
+        if (cut < n && cutFence.open) {
+            chunk += "\n```";
+        }
+        if (end > pos) {
+            chunks.push_back(std::move(chunk));
+        }
+        
+        fence = cutFence;
+        pos = cut;
+        while (pos < n && isSpace(data[pos]) && !(fence.open && data[pos] != '\n' && data[pos] != '\r')) pos++;
+    }
+    
+    return chunks;
+}
@@ -0,0 +1,227 @@
+#include "KindroidBot.h"
+
+// ============================================
+// DNS cache
+// ============================================
+
+struct NetAddress {
+    sockaddr_storage addr;
+    int len;
+};
+
+struct DnsEntry {
+    std::vector<NetAddress> addresses;
+    ULONGLONG expiresAt;
+};
+
+// getaddrinfo does not expose record TTLs, so entries live for a fixed window
+// and are dropped early whenever every address in them fails to connect.
+static const ULONGLONG DNS_CACHE_TTL_MS = 5 * 60 * 1000;
+static std::map<std::string, DnsEntry> g_dnsCache;
+static std::mutex g_dnsMutex;
+
+// RFC 8305 ordering: alternate address families, starting with IPv6
+static std::vector<NetAddress> interleaveFamilies(const std::vector<NetAddress>& addresses) {
+    std::vector<NetAddress> v6, v4, ordered;
+    for (const auto& a : addresses) {
+        (a.addr.ss_family == AF_INET6 ? v6 : v4).push_back(a);
+    }
+    for (size_t i = 0; i < v6.size() || i < v4.size(); i++) {
+        if (i < v6.size()) ordered.push_back(v6[i]);
+        if (i < v4.size()) ordered.push_back(v4[i]);
+    }
+    return ordered;
+}
+
+static bool resolveCached(const std::string& host, const std::string& port, std::vector<NetAddress>& out) {
+    std::string key = host + ":" + port;
+    ULONGLONG now = GetTickCount64();
+    {
+        std::lock_guard<std::mutex> lock(g_dnsMutex);
+        auto it = g_dnsCache.find(key);
+        if (it != g_dnsCache.end() && it->second.expiresAt > now) {
+            out = it->second.addresses;
+            return true;
+        }
+    }
+    
+    struct addrinfo hints = {0}, *result = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+        return false;
+    }
+    
+    std::vector<NetAddress> addresses;
+    for (struct addrinfo* ai = result; ai; ai = ai->ai_next) {
+        if (ai->ai_family != AF_INET && ai->ai_family != AF_INET6) continue;
+        if (ai->ai_addrlen > sizeof(sockaddr_storage)) continue;
+        NetAddress a = {};
+        memcpy(&a.addr, ai->ai_addr, ai->ai_addrlen);
+        a.len = (int)ai->ai_addrlen;
+        addresses.push_back(a);
+    }
+    freeaddrinfo(result);
+    
+    if (addresses.empty()) return false;
+    out = interleaveFamilies(addresses);
+    
+    std::lock_guard<std::mutex> lock(g_dnsMutex);
+    g_dnsCache[key] = { out, now + DNS_CACHE_TTL_MS };
+    return true;
+}
+
+bool NetResolve(const std::string& host, const std::string& port) {
+    std::vector<NetAddress> addresses;
+    return resolveCached(host, port, addresses);
+}
+
+void NetInvalidate(const std::string& host, const std::string& port) {
+    std::lock_guard<std::mutex> lock(g_dnsMutex);
+    g_dnsCache.erase(host + ":" + port);
+}
+
+// ============================================
+// Happy Eyeballs connect
+// ============================================
+
+// Delay before racing the next address while earlier attempts are still pending
+static const ULONGLONG CONNECT_ATTEMPT_DELAY_MS = 250;
+
+static void setBlocking(SOCKET sock, bool blocking) {
+    u_long mode = blocking ? 0 : 1;
+    ioctlsocket(sock, FIONBIO, &mode);
+}
+
+static SOCKET raceConnect(const std::vector<NetAddress>& addresses, DWORD timeoutMs) {
+    std::vector<SOCKET> pending;
+    SOCKET winner = INVALID_SOCKET;
+    size_t next = 0;
+    ULONGLONG deadline = GetTickCount64() + timeoutMs;
+    ULONGLONG nextLaunch = 0;
+    
+    while (winner == INVALID_SOCKET && (next < addresses.size() || !pending.empty())) {
+        ULONGLONG now = GetTickCount64();
+        if (now >= deadline) break;
+        
+        // Start the next attempt when nothing is in flight or the stagger delay has passed
+        if (next < addresses.size() && (pending.empty() || now >= nextLaunch)) {
+            const NetAddress& a = addresses[next++];
+            nextLaunch = now + CONNECT_ATTEMPT_DELAY_MS;
+            
+            SOCKET sock = socket(a.addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+            if (sock == INVALID_SOCKET) continue;
+            setBlocking(sock, false);
+            
+            if (connect(sock, (const sockaddr*)&a.addr, a.len) == 0) {
+                winner = sock;
+            } else if (WSAGetLastError() == WSAEWOULDBLOCK) {
+                pending.push_back(sock);
+            } else {
+                closesocket(sock);
+            }
+            continue;
+        }
+        
+        ULONGLONG wakeAt = (next < addresses.size() && nextLaunch < deadline) ? nextLaunch : deadline;
+        ULONGLONG waitMs = wakeAt > now ? wakeAt - now : 0;
+        struct timeval tv;
+        tv.tv_sec = (long)(waitMs / 1000);
+        tv.tv_usec = (long)((waitMs % 1000) * 1000);
+        
+        // Winsock flags a finished connect as writable (success) or in the except set (failure);
+        // SO_ERROR settles which
+        fd_set writeSet, exceptSet;
+        FD_ZERO(&writeSet);
+        FD_ZERO(&exceptSet);
+        for (SOCKET s : pending) {
+            FD_SET(s, &writeSet);
+            FD_SET(s, &exceptSet);
+        }
+        
+        int ready = select(0, NULL, &writeSet, &exceptSet, &tv);
+        if (ready == 0) continue;
+        if (ready == SOCKET_ERROR) {
+            // The pending sockets are unusable, and retrying select would only spin until
+            // the deadline; drop them and race the remaining addresses instead
+            for (SOCKET s : pending) closesocket(s);
+            pending.clear();
+            nextLaunch = 0;
+            continue;
+        }
+        
+        for (size_t i = 0; i < pending.size(); ) {
+            SOCKET s = pending[i];
+            int err = 0;
+            int errLen = sizeof(err);
+            bool done = FD_ISSET(s, &writeSet) || FD_ISSET(s, &exceptSet);
+            if (done) getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&err, &errLen);
+            
+            if (done && err == 0 && winner == INVALID_SOCKET) {
+                winner = s;
+                pending.erase(pending.begin() + i);
+            } else if (done) {
+                closesocket(s);
+                pending.erase(pending.begin() + i);
+                nextLaunch = 0; // A failure frees the slot; race the next address right away
+            } else {
+                i++;
+            }
+        }
+    }
+    
+    for (SOCKET s : pending) closesocket(s);
+    
+    if (winner != INVALID_SOCKET) setBlocking(winner, true);
+    return winner;
+}
+
+SOCKET NetConnect(const std::string& host, const std::string& port, DWORD timeoutMs) {
+    std::vector<NetAddress> addresses;
+    if (!resolveCached(host, port, addresses)) {
+        WSASetLastError(WSAHOST_NOT_FOUND);
+        return INVALID_SOCKET;
+    }
+    
+    SOCKET sock = raceConnect(addresses, timeoutMs);
+    if (sock == INVALID_SOCKET) {
+        // Addresses may be stale - resolve again next time
+        NetInvalidate(host, port);
+        WSASetLastError(WSAECONNREFUSED);
+    }
+    return sock;
+}
+
+// ============================================
+// Reconnect policy
+// ============================================
+
+ReconnectPolicy::ReconnectPolicy(DWORD baseMs, DWORD capMs, DWORD stableMs)
+    : baseMs(baseMs), capMs(capMs), stableMs(stableMs), failures(0), connectedAt(0) {
+}
+
+void ReconnectPolicy::connected() {
+    connectedAt = GetTickCount64();
+}
+
+DWORD ReconnectPolicy::nextDelay() {
+    // Only a connection that outlived the stable window counts as recovered;
+    // one that flaps right after the handshake keeps backing off
+    if (connectedAt != 0 && GetTickCount64() - connectedAt >= stableMs) {
+        failures = 0;
+    }
+    connectedAt = 0;
+    
+    int attempt = failures++;
+    if (attempt == 0) return 0;
+    
+    // base * 2^(attempt-1), capped; "equal jitter" keeps at least half of it
+    DWORD delay = capMs;
+    if (attempt <= 16) {
+        ULONGLONG exp = (ULONGLONG)baseMs << (attempt - 1);
+        if (exp < capMs) delay = (DWORD)exp;
+    }
+    return delay / 2 + randomDelay(delay / 2);
+}
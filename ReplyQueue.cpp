@@ -0,0 +1,347 @@
+#include "KindroidBot.h"
+
+// ============================================
+// RateLimiter - sliding window shared by threads
+// ============================================
+
+RateLimiter::RateLimiter(size_t maxEvents, DWORD windowMs)
+    : maxEvents(maxEvents), windowMs(windowMs) {
+}
+
+bool RateLimiter::acquire(HANDLE cancelEvent) {
+    while (true) {
+        DWORD waitMs;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ULONGLONG now = GetTickCount64();
+            while (!events.empty() && now - events.front() >= windowMs) {
+                events.pop_front();
+            }
+            if (events.size() < maxEvents) {
+                events.push_back(now);
+                return true;
+            }
+            // Full window: the oldest event frees its slot first
+            waitMs = (DWORD)(events.front() + windowMs - now);
+        }
+        
+        if (WaitForSingleObject(cancelEvent, waitMs) == WAIT_OBJECT_0) return false;
+    }
+}
+
+void RateLimiter::setLimit(size_t maxEvents, DWORD windowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->maxEvents = maxEvents;
+    this->windowMs = windowMs;
+}
+
+// ============================================
+// ReplyQueue - per-channel ordered reply jobs
+// ============================================
+
+// How long a lane holds still after an edit in case more edits follow
+static const ULONGLONG REPLACE_SETTLE_MS = 1500;
+
+ReplyQueue::ReplyQueue(int workers, DWORD minIntervalMs, size_t maxPending)
+    : workerCount(workers), minIntervalMs(minIntervalMs), maxPending(maxPending), stopping(false),
+      completed(0), dropped(0), cancelled(0) {
+}
+
+ReplyQueue::~ReplyQueue() {
+    stop();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ReplyQueue::start() {
+    // Workers from a previous run exit on their own once they see stopping
+    std::vector<std::thread> previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        previous.swap(workers);
+    }
+    wake.notify_all();
+    for (auto& worker : previous) {
+        if (worker.joinable()) worker.join();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = false;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&ReplyQueue::workerLoop, this);
+    }
+}
+
+void ReplyQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (auto& entry : lanes) {
+            if (entry.second.activeCancelled) *entry.second.activeCancelled = true;
+        }
+        lanes.clear();
+        readyLanes.clear();
+        pacedLanes = decltype(pacedLanes)();
+        idleLanes.clear();
+        laneIntervals.clear();
+    }
+    wake.notify_all();
+}
+
+bool ReplyQueue::enqueue(const std::string& laneKey, const std::string& user, const std::string& messageId,
+                         Work work) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return false;
+        
+        sweepIdleLanes();
+        Lane& lane = lanes[laneKey];
+        if (lane.jobs.size() >= maxPending) {
+            dropped++;
+            return false;
+        }
+        lane.jobs.push_back({ user, messageId, std::move(work) });
+        
+        // A busy lane is rescheduled by its worker once the current job finishes
+        if (!lane.busy && !lane.scheduled) scheduleLane(laneKey, lane);
+    }
+    return true;
+}
+
+void ReplyQueue::scheduleLane(const std::string& laneKey, Lane& lane) {
+    // Due lanes go straight to the workers; a pacing lane waits on the timer heap.
+    // Either way a worker is woken: for a paced lane, to wait for the earlier deadline.
+    lane.scheduled = true;
+    if (lane.nextStart > GetTickCount64()) {
+        pacedLanes.push({ lane.nextStart, laneKey });
+    } else {
+        readyLanes.push_back(laneKey);
+    }
+    wake.notify_one();
+}
+
+void ReplyQueue::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    while (!stopping) {
+        // Lanes whose pacing has run out join the ready list
+        ULONGLONG now = GetTickCount64();
+        while (!pacedLanes.empty() && pacedLanes.top().first <= now) {
+            readyLanes.push_back(pacedLanes.top().second);
+            pacedLanes.pop();
+        }
+        if (readyLanes.empty()) {
+            if (pacedLanes.empty()) {
+                wake.wait(lock);
+            } else {
+                wake.wait_for(lock, std::chrono::milliseconds(pacedLanes.top().first - now));
+            }
+            continue;
+        }
+        
+        std::string laneKey = std::move(readyLanes.front());
+        readyLanes.pop_front();
+        
+        // Entries are hints: a lane that was erased, already taken or re-paced since is skipped
+        auto it = lanes.find(laneKey);
+        if (it == lanes.end() || !it->second.scheduled) continue;
+        if (it->second.nextStart > now) {
+            pacedLanes.push({ it->second.nextStart, laneKey });
+            continue;
+        }
+        it->second.scheduled = false;
+        if (it->second.jobs.empty()) {
+            // Everything was cancelled before a worker got to it
+            releaseLane(it);
+            continue;
+        }
+        
+        // Own the lane until the job is done so replies in a channel stay in order
+        it->second.busy = true;
+        Job job = std::move(it->second.jobs.front());
+        it->second.jobs.pop_front();
+        
+        // Published so a cancel can reach the job while the lock is released
+        auto jobCancelled = std::make_shared<std::atomic<bool>>(false);
+        it->second.activeUser = job.user;
+        it->second.activeMessageId = job.messageId;
+        it->second.activeCancelled = jobCancelled;
+        
+        lock.unlock();
+        job.work(*jobCancelled);
+        lock.lock();
+        if (stopping) break;
+        if (*jobCancelled) cancelled++;
+        else completed++;
+        
+        // stop() may have cleared the lanes while the job was running
+        it = lanes.find(laneKey);
+        if (it == lanes.end()) continue;
+        
+        Lane& lane = it->second;
+        lane.activeUser.clear();
+        lane.activeMessageId.clear();
+        lane.activeCancelled.reset();
+        lane.busy = false;
+        
+        // Per-channel pacing; replaceMessage may already have pushed nextStart further out
+        auto interval = laneIntervals.find(laneKey);
+        DWORD intervalMs = interval != laneIntervals.end() ? interval->second : 0;
+        ULONGLONG paced = GetTickCount64() + (intervalMs > minIntervalMs ? intervalMs : minIntervalMs);
+        if (paced > lane.nextStart) lane.nextStart = paced;
+        if (!lane.jobs.empty()) {
+            scheduleLane(laneKey, lane);
+        } else {
+            releaseLane(it);
+            sweepIdleLanes();
+        }
+    }
+}
+
+void ReplyQueue::releaseLane(std::unordered_map<std::string, Lane>::iterator it) {
+    // A lane with nothing queued or running only matters until its pacing runs out
+    const Lane& lane = it->second;
+    if (!lane.jobs.empty() || lane.busy || lane.scheduled) return;
+    if (lane.nextStart <= GetTickCount64()) {
+        lanes.erase(it);
+    } else {
+        idleLanes.push_back({ lane.nextStart, it->first });
+    }
+}
+
+void ReplyQueue::sweepIdleLanes() {
+    ULONGLONG now = GetTickCount64();
+    while (!idleLanes.empty()) {
+        auto it = lanes.find(idleLanes.front().second);
+        
+        // Entries for lanes that were reused (or already erased) are stale
+        if (it != lanes.end() && it->second.nextStart == idleLanes.front().first) {
+            const Lane& lane = it->second;
+            bool idle = lane.jobs.empty() && !lane.busy && !lane.scheduled;
+            if (idle && lane.nextStart > now) break;
+            if (idle) lanes.erase(it);
+        }
+        idleLanes.pop_front();
+    }
+}
+
+size_t ReplyQueue::cancelWhere(const std::string& laneKey,
+                               const std::function<bool(const std::string&, const std::string&)>& match) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = lanes.find(laneKey);
+    if (it == lanes.end()) return 0;
+    Lane& lane = it->second;
+    
+    // Pending jobs never reach Kindroid; a lane left empty is let go when its
+    // scheduled turn comes up
+    size_t count = 0;
+    for (auto job = lane.jobs.begin(); job != lane.jobs.end();) {
+        if (match(job->user, job->messageId)) {
+            job = lane.jobs.erase(job);
+            count++;
+        } else {
+            ++job;
+        }
+    }
+    cancelled += count;
+    
+    // The running job's Kindroid call can't be taken back, but its answer can
+    if (lane.activeCancelled && !*lane.activeCancelled && match(lane.activeUser, lane.activeMessageId)) {
+        *lane.activeCancelled = true;
+        count++;
+    }
+    return count;
+}
+
+// Every job, announcements included; cancelUser and cancelMessage never match
+// the empty user and message id that announcements carry
+size_t ReplyQueue::cancelLane(const std::string& laneKey) {
+    return cancelWhere(laneKey, [](const std::string&, const std::string&) { return true; });
+}
+
+size_t ReplyQueue::cancelUser(const std::string& laneKey, const std::string& user) {
+    if (user.empty()) return 0;
+    return cancelWhere(laneKey, [&user](const std::string& jobUser, const std::string&) {
+        return jobUser == user;
+    });
+}
+
+size_t ReplyQueue::cancelMessage(const std::string& laneKey, const std::string& messageId) {
+    if (messageId.empty()) return 0;
+    return cancelWhere(laneKey, [&messageId](const std::string&, const std::string& jobMessageId) {
+        return jobMessageId == messageId;
+    });
+}
+
+bool ReplyQueue::replaceMessage(const std::string& laneKey, const std::string& messageId, Work work) {
+    if (messageId.empty()) return false;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = lanes.find(laneKey);
+    if (it == lanes.end()) return false;
+    Lane& lane = it->second;
+    
+    // Edits tend to come in bursts; holding the lane a moment lets the last one
+    // win instead of starting (and then cancelling) a Kindroid call for each
+    ULONGLONG settled = GetTickCount64() + REPLACE_SETTLE_MS;
+    
+    for (auto& job : lane.jobs) {
+        if (job.messageId == messageId) {
+            job.work = std::move(work);
+            if (settled > lane.nextStart) lane.nextStart = settled;
+            return true;
+        }
+    }
+    
+    // Running: its answer is for the old text. The worker reschedules the lane
+    // when it finishes, so the new work goes first in line. With the lane full
+    // the old answer is let through rather than pushing out someone else's turn.
+    if (!lane.activeCancelled || *lane.activeCancelled || lane.activeMessageId != messageId) return false;
+    if (lane.jobs.size() >= maxPending) return false;
+    *lane.activeCancelled = true;
+    lane.jobs.push_front({ lane.activeUser, messageId, std::move(work) });
+    if (settled > lane.nextStart) lane.nextStart = settled;
+    return true;
+}
+
+bool ReplyQueue::hasMessage(const std::string& laneKey, const std::string& messageId) const {
+    if (messageId.empty()) return false;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = lanes.find(laneKey);
+    if (it == lanes.end()) return false;
+    const Lane& lane = it->second;
+    
+    if (lane.activeCancelled && !*lane.activeCancelled && lane.activeMessageId == messageId) return true;
+    for (const auto& job : lane.jobs) {
+        if (job.messageId == messageId) return true;
+    }
+    return false;
+}
+
+bool ReplyQueue::hasRoom(const std::string& laneKey) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) return false;
+    auto it = lanes.find(laneKey);
+    return it == lanes.end() || it->second.jobs.size() < maxPending;
+}
+
+void ReplyQueue::setLaneInterval(const std::string& laneKey, DWORD intervalMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) return;
+    // Kept apart from the lane, which is erased whenever it goes idle
+    if (intervalMs > 0) laneIntervals[laneKey] = intervalMs;
+    else laneIntervals.erase(laneKey);
+}
+
+std::string ReplyQueue::statsString() const {
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : lanes) queued += entry.second.jobs.size();
+    }
+    return std::to_string(completed) + " replies, " + std::to_string(dropped) + " dropped, " +
+           std::to_string(cancelled) + " cancelled, " + std::to_string(queued) + " queued";
+}
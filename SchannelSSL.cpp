@@ -11,35 +11,53 @@
 // Schannel SSL/TLS wrapper
 struct SchannelContext {
     SOCKET sock;
-    CredHandle credentials;
+    CredHandle credentials;     // Copy of the shared process-wide handle (not owned)
     CtxtHandle context;
     SecPkgContext_StreamSizes sizes;
-    std::vector<BYTE> recvBuffer;
-    std::vector<BYTE> extraBuffer;
-    size_t extraData;
     bool connected;
+    bool resumed;               // Handshake reused a cached TLS session
     
-    // Per-connection receive buffers (NOT static - thread safe)
+    // Receive side: one growable buffer holds both ciphertext and plaintext.
+    // DecryptMessage works in place and plaintext is handed out as a view into it.
     std::vector<BYTE> ioBuffer;
-    DWORD ioLen;
-    std::vector<BYTE> decryptedBuffer;
-    DWORD decryptedLen;
-    DWORD decryptedOffset;
+    DWORD encStart;     // Undecrypted bytes at ioBuffer[encStart, encStart + encLen)
+    DWORD encLen;
+    BYTE* plainData;    // Undelivered plaintext of the last decrypted record
+    DWORD plainLen;
+    
+    // Reused outbound record storage: [TLS header][plaintext][TLS trailer] per record.
+    // Callers serialize sends, so one buffer per connection is enough.
+    std::vector<BYTE> sendBuffer;
 };
 
+// Schannel keeps its client session cache (session IDs and tickets, keyed by
+// target name) per credentials handle. Sharing one handle across all connections
+// lets reconnects to the same host resume instead of doing a full handshake.
+static CredHandle g_sharedCredentials;
+static bool g_sharedCredentialsValid = false;
+static std::mutex g_credentialsMutex;
+
 static bool InitializeSchannel(SchannelContext* ctx) {
-    SCHANNEL_CRED cred = {0};
-    cred.dwVersion = SCHANNEL_CRED_VERSION;
-    cred.dwFlags = SCH_CRED_NO_DEFAULT_CREDS | 
-                   SCH_CRED_MANUAL_CRED_VALIDATION | 
-                   SCH_USE_STRONG_CRYPTO;
-    cred.grbitEnabledProtocols = SP_PROT_TLS1_2_CLIENT;
+    std::lock_guard<std::mutex> lock(g_credentialsMutex);
     
-    SECURITY_STATUS status = AcquireCredentialsHandleA(
-        NULL, (LPSTR)UNISP_NAME_A, SECPKG_CRED_OUTBOUND,
-        NULL, &cred, NULL, NULL, &ctx->credentials, NULL);
+    if (!g_sharedCredentialsValid) {
+        SCHANNEL_CRED cred = {0};
+        cred.dwVersion = SCHANNEL_CRED_VERSION;
+        cred.dwFlags = SCH_CRED_NO_DEFAULT_CREDS | 
+                       SCH_CRED_MANUAL_CRED_VALIDATION | 
+                       SCH_USE_STRONG_CRYPTO;
+        cred.grbitEnabledProtocols = SP_PROT_TLS1_2_CLIENT;
+        cred.dwSessionLifespan = 10 * 60 * 60 * 1000; // Keep cached sessions for 10 hours
+        
+        SECURITY_STATUS status = AcquireCredentialsHandleA(
+            NULL, (LPSTR)UNISP_NAME_A, SECPKG_CRED_OUTBOUND,
+            NULL, &cred, NULL, NULL, &g_sharedCredentials, NULL);
+        if (status != SEC_E_OK) return false;
+        g_sharedCredentialsValid = true;
+    }
     
-    return status == SEC_E_OK;
+    ctx->credentials = g_sharedCredentials;
+    return true;
 }
 
 static bool PerformHandshake(SchannelContext* ctx, const char* hostname) {
@@ -69,12 +87,15 @@ static bool PerformHandshake(SchannelContext* ctx, const char* hostname) {
         FreeContextBuffer(outBuffer.pvBuffer);
     }
     
-    // Handshake loop
-    std::vector<BYTE> ioBuffer(0x10000);
+    // Handshake loop (uses the connection's receive buffer, grown on demand)
+    std::vector<BYTE>& ioBuffer = ctx->ioBuffer;
     DWORD ioLength = 0;
     
     while (true) {
         if (ioLength == 0 || status == SEC_E_INCOMPLETE_MESSAGE) {
+            if (ioLength == ioBuffer.size()) {
+                ioBuffer.resize(ioBuffer.size() * 2);
+            }
             int rcv = ::recv(ctx->sock, (char*)ioBuffer.data() + ioLength,
                            (int)(ioBuffer.size() - ioLength), 0);
             if (rcv <= 0) return false;
@@ -106,14 +127,24 @@ static bool PerformHandshake(SchannelContext* ctx, const char* hostname) {
         }
         
         if (status == SEC_E_OK) {
+            // Application data that arrived with the last handshake message stays at the front
+            ctx->encStart = 0;
+            ctx->encLen = 0;
             if (inBuffers[1].BufferType == SECBUFFER_EXTRA) {
-                ctx->extraData = inBuffers[1].cbBuffer;
-                ctx->extraBuffer.resize(ctx->extraData);
-                memcpy(ctx->extraBuffer.data(),
-                      ioBuffer.data() + (ioLength - ctx->extraData),
-                      ctx->extraData);
+                ctx->encLen = inBuffers[1].cbBuffer;
+                memmove(ioBuffer.data(), ioBuffer.data() + (ioLength - ctx->encLen), ctx->encLen);
             }
             QueryContextAttributes(&ctx->context, SECPKG_ATTR_STREAM_SIZES, &ctx->sizes);
+            
+            SecPkgContext_SessionInfo session = {0};
+            if (QueryContextAttributes(&ctx->context, SECPKG_ATTR_SESSION_INFO, &session) == SEC_E_OK) {
+                ctx->resumed = (session.dwFlags & SSL_SESSION_RECONNECT) != 0;
+            }
+            
+            // Right-size both directions for one full TLS record
+            size_t recordSize = ctx->sizes.cbHeader + ctx->sizes.cbMaximumMessage + ctx->sizes.cbTrailer;
+            if (ioBuffer.size() < recordSize) ioBuffer.resize(recordSize);
+            ctx->sendBuffer.resize(recordSize);
             ctx->connected = true;
             return true;
         }
@@ -133,21 +164,27 @@ static bool PerformHandshake(SchannelContext* ctx, const char* hostname) {
     }
 }
 
-static int SecureSend(SchannelContext* ctx, const void* data, int len) {
-    if (!ctx->connected) return -1;
-    
-    std::vector<BYTE> msg(ctx->sizes.cbHeader + len + ctx->sizes.cbTrailer);
-    memcpy(msg.data() + ctx->sizes.cbHeader, data, len);
-    
+static bool SendAll(SOCKET sock, const BYTE* data, int len) {
+    while (len > 0) {
+        int sent = ::send(sock, (const char*)data, len, 0);
+        if (sent <= 0) return false;
+        data += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+// Encrypt one record in place. The plaintext must already sit at record + cbHeader.
+static bool EncryptRecord(SchannelContext* ctx, BYTE* record, DWORD len, DWORD* recordLen) {
     SecBuffer bufs[4] = {0};
     bufs[0].BufferType = SECBUFFER_STREAM_HEADER;
-    bufs[0].pvBuffer = msg.data();
+    bufs[0].pvBuffer = record;
     bufs[0].cbBuffer = ctx->sizes.cbHeader;
     bufs[1].BufferType = SECBUFFER_DATA;
-    bufs[1].pvBuffer = msg.data() + ctx->sizes.cbHeader;
+    bufs[1].pvBuffer = record + ctx->sizes.cbHeader;
     bufs[1].cbBuffer = len;
     bufs[2].BufferType = SECBUFFER_STREAM_TRAILER;
-    bufs[2].pvBuffer = msg.data() + ctx->sizes.cbHeader + len;
+    bufs[2].pvBuffer = record + ctx->sizes.cbHeader + len;
     bufs[2].cbBuffer = ctx->sizes.cbTrailer;
     bufs[3].BufferType = SECBUFFER_EMPTY;
     
@@ -156,52 +193,90 @@ static int SecureSend(SchannelContext* ctx, const void* data, int len) {
     desc.cBuffers = 4;
     desc.pBuffers = bufs;
     
-    if (EncryptMessage(&ctx->context, 0, &desc, 0) != SEC_E_OK) return -1;
+    if (EncryptMessage(&ctx->context, 0, &desc, 0) != SEC_E_OK) return false;
     
-    int total = bufs[0].cbBuffer + bufs[1].cbBuffer + bufs[2].cbBuffer;
-    return (::send(ctx->sock, (char*)msg.data(), total, 0) == total) ? len : -1;
+    *recordLen = bufs[0].cbBuffer + bufs[1].cbBuffer + bufs[2].cbBuffer;
+    return true;
 }
 
-static int SecureRecv(SchannelContext* ctx, void* buffer, int len) {
+static int SecureSendInPlace(SchannelContext* ctx, int len) {
+    if (!ctx->connected || len < 0 || (DWORD)len > ctx->sizes.cbMaximumMessage) return -1;
+    
+    DWORD recordLen = 0;
+    if (!EncryptRecord(ctx, ctx->sendBuffer.data(), len, &recordLen)) return -1;
+    return SendAll(ctx->sock, ctx->sendBuffer.data(), (int)recordLen) ? len : -1;
+}
+
+static int SecureSend(SchannelContext* ctx, const void* data, int len) {
     if (!ctx->connected) return -1;
     
-    // Use per-context buffers (thread safe)
-    std::vector<BYTE>& ioBuffer = ctx->ioBuffer;
-    DWORD& ioLen = ctx->ioLen;
-    std::vector<BYTE>& decryptedBuffer = ctx->decryptedBuffer;
-    DWORD& decryptedLen = ctx->decryptedLen;
-    DWORD& decryptedOffset = ctx->decryptedOffset;
+    DWORD maxChunk = ctx->sizes.cbMaximumMessage;
+    if ((DWORD)len <= maxChunk) {
+        memcpy(ctx->sendBuffer.data() + ctx->sizes.cbHeader, data, len);
+        return SecureSendInPlace(ctx, len);
+    }
     
-    // Return buffered decrypted data first
-    if (decryptedLen > 0) {
-        int copy = (len < (int)decryptedLen) ? len : (int)decryptedLen;
-        memcpy(buffer, decryptedBuffer.data() + decryptedOffset, copy);
-        decryptedOffset += copy;
-        decryptedLen -= copy;
-        if (decryptedLen == 0) {
-            decryptedOffset = 0;
-        }
-        return copy;
+    // Larger than one record: encrypt each chunk into its own slot of the (grown,
+    // then reused) send buffer and hand all records to the socket in one gather write.
+    size_t slotSize = ctx->sizes.cbHeader + maxChunk + ctx->sizes.cbTrailer;
+    size_t records = (len + maxChunk - 1) / maxChunk;
+    if (ctx->sendBuffer.size() < records * slotSize) {
+        ctx->sendBuffer.resize(records * slotSize);
     }
     
-    // Use extra data first
-    if (ctx->extraData > 0) {
-        memcpy(ioBuffer.data(), ctx->extraBuffer.data(), ctx->extraData);
-        ioLen = (DWORD)ctx->extraData;
-        ctx->extraData = 0;
+    const int kMaxGather = 16;
+    WSABUF gather[kMaxGather];
+    DWORD gatherCount = 0;
+    DWORD gatherBytes = 0;
+    const BYTE* src = (const BYTE*)data;
+    
+    for (size_t i = 0; i < records; i++) {
+        DWORD chunk = (DWORD)((i + 1 < records) ? maxChunk : len - i * maxChunk);
+        BYTE* slot = ctx->sendBuffer.data() + i * slotSize;
+        memcpy(slot + ctx->sizes.cbHeader, src + i * maxChunk, chunk);
+        
+        DWORD recordLen = 0;
+        if (!EncryptRecord(ctx, slot, chunk, &recordLen)) return -1;
+        
+        gather[gatherCount].buf = (char*)slot;
+        gather[gatherCount].len = recordLen;
+        gatherCount++;
+        gatherBytes += recordLen;
+        
+        if (gatherCount == kMaxGather || i + 1 == records) {
+            DWORD sent = 0;
+            if (WSASend(ctx->sock, gather, gatherCount, &sent, 0, NULL, NULL) == SOCKET_ERROR) return -1;
+            if (sent != gatherBytes) return -1;
+            gatherCount = 0;
+            gatherBytes = 0;
+        }
     }
     
-    while (true) {
-        if (ioLen == 0) {
-            int rcv = ::recv(ctx->sock, (char*)ioBuffer.data(), (int)ioBuffer.size(), 0);
+    return len;
+}
+
+// Hand out up to maxLen bytes of plaintext as a view into ioBuffer. The view stays
+// valid until the next receive call on this context.
+static int SecureRecvView(SchannelContext* ctx, const BYTE** data, int maxLen) {
+    if (!ctx->connected) return -1;
+    
+    while (ctx->plainLen == 0) {
+        // Previous plaintext is fully consumed, so leftover ciphertext can move to the front
+        if (ctx->encStart > 0) {
+            memmove(ctx->ioBuffer.data(), ctx->ioBuffer.data() + ctx->encStart, ctx->encLen);
+            ctx->encStart = 0;
+        }
+        
+        if (ctx->encLen == 0) {
+            int rcv = ::recv(ctx->sock, (char*)ctx->ioBuffer.data(), (int)ctx->ioBuffer.size(), 0);
             if (rcv <= 0) return -1;
-            ioLen = rcv;
+            ctx->encLen = rcv;
         }
         
         SecBuffer bufs[4] = {0};
         bufs[0].BufferType = SECBUFFER_DATA;
-        bufs[0].pvBuffer = ioBuffer.data();
-        bufs[0].cbBuffer = ioLen;
+        bufs[0].pvBuffer = ctx->ioBuffer.data();
+        bufs[0].cbBuffer = ctx->encLen;
         bufs[1].BufferType = SECBUFFER_EMPTY;
         bufs[2].BufferType = SECBUFFER_EMPTY;
         bufs[3].BufferType = SECBUFFER_EMPTY;
@@ -214,60 +289,59 @@ static int SecureRecv(SchannelContext* ctx, void* buffer, int len) {
         SECURITY_STATUS status = DecryptMessage(&ctx->context, &desc, 0, NULL);
         
         if (status == SEC_E_OK) {
+            ctx->encLen = 0;
             for (int i = 1; i < 4; i++) {
                 if (bufs[i].BufferType == SECBUFFER_DATA) {
-                    // Found decrypted data
-                    int dataSize = bufs[i].cbBuffer;
-                    int copy = (len < dataSize) ? len : dataSize;
-                    memcpy(buffer, bufs[i].pvBuffer, copy);
-                    
-                    // Save any leftover decrypted data
-                    if (dataSize > copy) {
-                        decryptedLen = dataSize - copy;
-                        memcpy(decryptedBuffer.data(), (BYTE*)bufs[i].pvBuffer + copy, decryptedLen);
-                        decryptedOffset = 0;
-                    }
-                    
-                    // Save extra encrypted data
-                    for (int j = 1; j < 4; j++) {
-                        if (bufs[j].BufferType == SECBUFFER_EXTRA) {
-                            memmove(ioBuffer.data(), bufs[j].pvBuffer, bufs[j].cbBuffer);
-                            ioLen = bufs[j].cbBuffer;
-                            return copy;
-                        }
-                    }
-                    ioLen = 0;
-                    return copy;
+                    ctx->plainData = (BYTE*)bufs[i].pvBuffer;
+                    ctx->plainLen = bufs[i].cbBuffer;
+                } else if (bufs[i].BufferType == SECBUFFER_EXTRA) {
+                    // Next record(s) - left in place until this plaintext is consumed
+                    ctx->encStart = (DWORD)((BYTE*)bufs[i].pvBuffer - ctx->ioBuffer.data());
+                    ctx->encLen = bufs[i].cbBuffer;
                 }
             }
         }
         else if (status == SEC_E_INCOMPLETE_MESSAGE) {
-            int rcv = ::recv(ctx->sock, (char*)ioBuffer.data() + ioLen,
-                           (int)(ioBuffer.size() - ioLen), 0);
+            if (ctx->encLen == ctx->ioBuffer.size()) {
+                ctx->ioBuffer.resize(ctx->ioBuffer.size() * 2);
+            }
+            int rcv = ::recv(ctx->sock, (char*)ctx->ioBuffer.data() + ctx->encLen,
+                           (int)(ctx->ioBuffer.size() - ctx->encLen), 0);
             if (rcv <= 0) return -1;
-            ioLen += rcv;
+            ctx->encLen += rcv;
         }
         else {
             return -1;
         }
     }
+    
+    int take = (maxLen < (int)ctx->plainLen) ? maxLen : (int)ctx->plainLen;
+    *data = ctx->plainData;
+    ctx->plainData += take;
+    ctx->plainLen -= take;
+    return take;
+}
+
+static int SecureRecv(SchannelContext* ctx, void* buffer, int len) {
+    const BYTE* data = nullptr;
+    int got = SecureRecvView(ctx, &data, len);
+    if (got > 0) memcpy(buffer, data, got);
+    return got;
 }
 
 // Public C-style interface
 SchannelContext* SchannelCreate(SOCKET sock) {
     SchannelContext* ctx = new SchannelContext();
     ctx->sock = sock;
-    ctx->extraData = 0;
     ctx->connected = false;
-    ctx->recvBuffer.resize(0x10000);
-    ctx->extraBuffer.resize(0x10000);
+    ctx->resumed = false;
     
-    // Initialize per-context receive buffers
-    ctx->ioBuffer.resize(0x11000);
-    ctx->ioLen = 0;
-    ctx->decryptedBuffer.resize(0x11000);
-    ctx->decryptedLen = 0;
-    ctx->decryptedOffset = 0;
+    // Starts small for the handshake; grows to one full TLS record once connected
+    ctx->ioBuffer.resize(0x2000);
+    ctx->encStart = 0;
+    ctx->encLen = 0;
+    ctx->plainData = nullptr;
+    ctx->plainLen = 0;
     
     SecInvalidateHandle(&ctx->credentials);
     SecInvalidateHandle(&ctx->context);
@@ -278,14 +352,50 @@ bool SchannelHandshake(SchannelContext* ctx, const char* hostname) {
     return PerformHandshake(ctx, hostname);
 }
 
+bool SchannelSessionResumed(SchannelContext* ctx) {
+    return ctx->resumed;
+}
+
 int SchannelSend(SchannelContext* ctx, const void* data, int len) {
     return SecureSend(ctx, data, len);
 }
 
+BYTE* SchannelSendBuffer(SchannelContext* ctx, int* capacity) {
+    if (!ctx->connected) return nullptr;
+    *capacity = (int)ctx->sizes.cbMaximumMessage;
+    return ctx->sendBuffer.data() + ctx->sizes.cbHeader;
+}
+
+int SchannelSendInPlace(SchannelContext* ctx, int len) {
+    return SecureSendInPlace(ctx, len);
+}
+
 int SchannelRecv(SchannelContext* ctx, void* buffer, int len) {
     return SecureRecv(ctx, buffer, len);
 }
 
+int SchannelRecvView(SchannelContext* ctx, const char** data, int maxLen) {
+    return SecureRecvView(ctx, (const BYTE**)data, maxLen);
+}
+
+int SchannelRecvAll(SchannelContext* ctx, void* buffer, int len) {
+    // A record boundary can fall anywhere, even inside a 2-byte frame header
+    BYTE* out = (BYTE*)buffer;
+    int got = 0;
+    while (got < len) {
+        WSASetLastError(0); // A failed decrypt must not look like a stale timeout
+        int received = SecureRecv(ctx, out + got, len - got);
+        if (received <= 0) {
+            if (got == 0) return received; // Timeouts before any data are the caller's to handle
+            int err = WSAGetLastError();
+            if (err != WSAETIMEDOUT && err != WSAEWOULDBLOCK) return -1;
+            continue;
+        }
+        got += received;
+    }
+    return got;
+}
+
 void SchannelDestroy(SchannelContext* ctx) {
     if (ctx) {
         if (ctx->connected) {
@@ -301,7 +411,7 @@ void SchannelDestroy(SchannelContext* ctx) {
             ApplyControlToken(&ctx->context, &desc);
         }
         if (SecIsValidHandle(&ctx->context)) DeleteSecurityContext(&ctx->context);
-        if (SecIsValidHandle(&ctx->credentials)) FreeCredentialsHandle(&ctx->credentials);
+        // Credentials are shared and live for the whole process (they own the session cache)
         delete ctx;
     }
 }
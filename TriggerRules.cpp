@@ -0,0 +1,321 @@
+#include "KindroidBot.h"
+
+// ============================================
+// TriggerRules - keyword rules on one automaton
+// ============================================
+
+static const DWORD DEFAULT_TRIGGER_COOLDOWN_MS = 30000;
+// Each spelling a [...] class allows becomes its own literal in the automaton
+static const size_t MAX_PIECE_SPELLINGS = 256;
+
+static inline bool isWordChar(unsigned char c) {
+    return isalnum(c) || c == '_';
+}
+
+static std::string trimSpaces(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return std::string();
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+// "gr[ae]y" -> {"gray", "grey"}; "[0-9]" is a range. false on a malformed class
+// or too many spellings.
+static bool expandClasses(const std::string& piece, std::vector<std::string>& spellings) {
+    spellings.assign(1, std::string());
+    for (size_t i = 0; i < piece.length(); i++) {
+        std::string choices;
+        if (piece[i] != '[') {
+            choices = piece[i];
+        } else {
+            size_t close = piece.find(']', i + 1);
+            if (close == std::string::npos || close == i + 1) return false;
+            for (size_t k = i + 1; k < close; k++) {
+                unsigned char from = (unsigned char)piece[k];
+                unsigned char to = from;
+                if (k + 2 < close && piece[k + 1] == '-') {
+                    to = (unsigned char)piece[k + 2];
+                    k += 2;
+                }
+                if (to < from) return false;
+                for (unsigned c = from; c <= to; c++) {
+                    if (choices.find((char)c) == std::string::npos) choices += (char)c;
+                }
+            }
+            i = close;
+        }
+        
+        if (spellings.size() * choices.length() > MAX_PIECE_SPELLINGS) return false;
+        std::vector<std::string> longer;
+        longer.reserve(spellings.size() * choices.length());
+        for (const auto& prefix : spellings) {
+            for (char c : choices) longer.push_back(prefix + c);
+        }
+        spellings.swap(longer);
+    }
+    return true;
+}
+
+TriggerRules::TriggerRules() : classCount(1), triggerCount(0), cooldowns(4096) {
+    memset(byteClass, 0, sizeof(byteClass));
+}
+
+std::vector<std::string> TriggerRules::load(const std::string& text) {
+    std::vector<std::string> problems;
+    rules.clear();
+    literalPieces.clear();
+    triggerCount = 0;
+    cooldowns.clear();
+    
+    std::vector<std::string> literals;
+    std::map<std::string, int> literalIds;
+    
+    std::istringstream input(text);
+    std::string rawLine;
+    int lineNumber = 0;
+    while (std::getline(input, rawLine)) {
+        lineNumber++;
+        std::string line = trimSpaces(rawLine);
+        if (line.empty() || line[0] == '#' || line.compare(0, 2, "//") == 0) continue;
+        
+        std::string where = "line " + std::to_string(lineNumber) + ": ";
+        
+        // Verb
+        size_t space = line.find_first_of(" \t");
+        std::string verb = line.substr(0, space);
+        std::transform(verb.begin(), verb.end(), verb.begin(), ::tolower);
+        if (verb != "trigger" && verb != "ignore") {
+            problems.push_back(where + "expected 'trigger' or 'ignore'");
+            continue;
+        }
+        std::string rest = space == std::string::npos ? std::string() : trimSpaces(line.substr(space));
+        
+        Rule rule;
+        rule.ignore = verb == "ignore";
+        rule.cooldownMs = DEFAULT_TRIGGER_COOLDOWN_MS;
+        
+        // Optional channel scope
+        if (!rest.empty() && rest[0] == '#') {
+            space = rest.find_first_of(" \t");
+            rule.channel = rest.substr(1, space == std::string::npos ? std::string::npos : space - 1);
+            std::transform(rule.channel.begin(), rule.channel.end(), rule.channel.begin(), ::tolower);
+            rest = space == std::string::npos ? std::string() : trimSpaces(rest.substr(space));
+        }
+        
+        // Optional trailing cooldown=<seconds>
+        size_t lastSpace = rest.find_last_of(" \t");
+        std::string lastWord = lastSpace == std::string::npos ? rest : rest.substr(lastSpace + 1);
+        if (lastWord.compare(0, 9, "cooldown=") == 0) {
+            std::string seconds = lastWord.substr(9);
+            if (seconds.empty() || seconds.find_first_not_of("0123456789") != std::string::npos || seconds.length() > 6) {
+                problems.push_back(where + "bad cooldown '" + seconds + "'");
+                continue;
+            }
+            rule.cooldownMs = (DWORD)std::stoi(seconds) * 1000;
+            rest = lastSpace == std::string::npos ? std::string() : trimSpaces(rest.substr(0, lastSpace));
+        }
+        
+        std::transform(rest.begin(), rest.end(), rest.begin(), ::tolower);
+        
+        // Optional anchors: '^' pins the pattern to the start of the message, '$' to the end
+        bool anchorStart = !rest.empty() && rest[0] == '^';
+        bool anchorEnd = rest.length() > (anchorStart ? 1u : 0u) && rest.back() == '$';
+        if (anchorStart) rest.erase(0, 1);
+        if (anchorEnd) rest.pop_back();
+        
+        // Split the pattern on '*'. A star glued to a piece lets that end run into a word;
+        // a piece that meets the pattern's edge or a space must sit on a word boundary.
+        std::vector<Piece> pieces;
+        std::vector<std::pair<std::string, Piece>> uses; // Added once the whole line is good
+        std::vector<std::string> spellings;
+        bool badClass = false;
+        size_t pos = 0;
+        while (pos <= rest.length()) {
+            size_t star = rest.find('*', pos);
+            if (star == std::string::npos) star = rest.length();
+            std::string raw = rest.substr(pos, star - pos);
+            std::string literal = trimSpaces(raw);
+            if (!literal.empty()) {
+                if (!expandClasses(literal, spellings)) {
+                    badClass = true;
+                    break;
+                }
+                Piece piece;
+                piece.rule = (int)rules.size();
+                piece.index = (int)pieces.size();
+                piece.length = (int)spellings[0].length();
+                piece.wordStart = pos == 0 || raw[0] == ' ' || raw[0] == '\t';
+                piece.wordEnd = star == rest.length() || raw.back() == ' ' || raw.back() == '\t';
+                piece.anchorStart = anchorStart && pos == 0;
+                piece.anchorEnd = anchorEnd && star == rest.length();
+                for (const auto& spelling : spellings) uses.push_back({ spelling, piece });
+                pieces.push_back(piece);
+            }
+            pos = star + 1;
+        }
+        
+        if (badClass) {
+            problems.push_back(where + "bad [...] class or more than " + std::to_string(MAX_PIECE_SPELLINGS) +
+                               " spellings");
+            continue;
+        }
+        if (pieces.empty()) {
+            problems.push_back(where + "empty pattern");
+            continue;
+        }
+        
+        for (const auto& use : uses) {
+            auto it = literalIds.find(use.first);
+            int id;
+            if (it == literalIds.end()) {
+                id = (int)literals.size();
+                literalIds[use.first] = id;
+                literals.push_back(use.first);
+                literalPieces.emplace_back();
+            } else {
+                id = it->second;
+            }
+            literalPieces[id].push_back(use.second);
+        }
+        
+        rule.pieceCount = (int)pieces.size();
+        rules.push_back(rule);
+        if (!rule.ignore) triggerCount++;
+    }
+    
+    build(literals);
+    return problems;
+}
+
+void TriggerRules::build(const std::vector<std::string>& literals) {
+    // Only bytes that occur in some pattern get their own column; everything else
+    // shares class 0. Letters map both cases to one class (patterns are lowercase).
+    memset(byteClass, 0, sizeof(byteClass));
+    classCount = 1;
+    for (const auto& literal : literals) {
+        for (unsigned char c : literal) {
+            if (byteClass[c] == 0) {
+                byteClass[c] = (unsigned char)classCount;
+                if (isalpha(c)) byteClass[toupper(c)] = (unsigned char)classCount;
+                classCount++;
+            }
+        }
+    }
+    
+    states.assign(1, State{ 0, -1, -1 });
+    next.assign(classCount, -1);
+    
+    // Trie
+    for (size_t id = 0; id < literals.size(); id++) {
+        int s = 0;
+        for (unsigned char c : literals[id]) {
+            int& t = next[s * classCount + byteClass[c]];
+            if (t < 0) {
+                t = (int)states.size();
+                states.push_back(State{ 0, -1, -1 });
+                next.resize(next.size() + classCount, -1);
+            }
+            s = next[s * classCount + byteClass[c]]; // next may have been reallocated
+        }
+        states[s].output = (int)id;
+    }
+    
+    // Breadth-first: failure links, output links and a full transition table,
+    // so scanning is one table lookup per byte
+    std::deque<int> queue;
+    for (int k = 0; k < classCount; k++) {
+        int& t = next[k];
+        if (t < 0) {
+            t = 0;
+        } else {
+            states[t].fail = 0;
+            queue.push_back(t);
+        }
+    }
+    while (!queue.empty()) {
+        int s = queue.front();
+        queue.pop_front();
+        int f = states[s].fail;
+        states[s].outputLink = states[f].output >= 0 ? f : states[f].outputLink;
+        
+        for (int k = 0; k < classCount; k++) {
+            int t = next[s * classCount + k];
+            if (t < 0) {
+                next[s * classCount + k] = next[f * classCount + k];
+            } else {
+                states[t].fail = next[f * classCount + k];
+                queue.push_back(t);
+            }
+        }
+    }
+}
+
+TriggerRules::Result TriggerRules::evaluate(std::string_view message, std::string_view channel, bool checkTriggers,
+                                            bool startCooldown) {
+    if (rules.empty() || (!checkTriggers && triggerCount == (int)rules.size())) return NO_MATCH;
+    
+    // Per-rule progress through its pieces; only touched entries are reset afterwards
+    static thread_local std::vector<int> progress;
+    static thread_local std::vector<size_t> lastEnd;
+    static thread_local std::vector<int> touched;
+    static thread_local std::vector<int> matched;
+    if (progress.size() < rules.size()) {
+        progress.resize(rules.size(), 0);
+        lastEnd.resize(rules.size(), 0);
+    }
+    touched.clear();
+    matched.clear();
+    
+    bool ignored = false;
+    const size_t n = message.size();
+    // Anchored pieces may have surrounding whitespace between them and the message edge
+    size_t textStart = 0;
+    size_t textEnd = n;
+    while (textStart < n && isspace((unsigned char)message[textStart])) textStart++;
+    while (textEnd > textStart && isspace((unsigned char)message[textEnd - 1])) textEnd--;
+    int s = 0;
+    for (size_t i = 0; i < n && !ignored; i++) {
+        s = next[s * classCount + byteClass[(unsigned char)message[i]]];
+        
+        for (int o = states[s].output >= 0 ? s : states[s].outputLink; o >= 0; o = states[o].outputLink) {
+            size_t end = i + 1;
+            for (const Piece& piece : literalPieces[states[o].output]) {
+                const Rule& rule = rules[piece.rule];
+                if (!rule.ignore && !checkTriggers) continue;
+                if (!rule.channel.empty() && rule.channel != channel) continue;
+                
+                size_t start = end - piece.length;
+                if (piece.wordStart && start > 0 && isWordChar((unsigned char)message[start - 1])) continue;
+                if (piece.wordEnd && end < n && isWordChar((unsigned char)message[end])) continue;
+                if ((piece.anchorStart && start != textStart) || (piece.anchorEnd && end != textEnd)) continue;
+                
+                // Pieces must appear in order without overlapping
+                int& done = progress[piece.rule];
+                if (done != piece.index || (done > 0 && start < lastEnd[piece.rule])) continue;
+                if (done == 0) touched.push_back(piece.rule);
+                done++;
+                lastEnd[piece.rule] = end;
+                
+                if (done == rule.pieceCount) {
+                    if (rule.ignore) ignored = true;
+                    else matched.push_back(piece.rule);
+                }
+            }
+        }
+    }
+    
+    for (int r : touched) {
+        progress[r] = 0;
+        lastEnd[r] = 0;
+    }
+    
+    if (ignored) return IGNORED;
+    if (!startCooldown) return matched.empty() ? NO_MATCH : TRIGGERED;
+    
+    // First matching trigger that is not cooling down in this channel
+    for (int r : matched) {
+        uint64_t key = CooldownTable::makeKey("trigger", channel, std::to_string(r));
+        if (cooldowns.tryAcquire(key, rules[r].cooldownMs)) return TRIGGERED;
+    }
+    return NO_MATCH;
+}
@@ -4,19 +4,34 @@
 
 #pragma comment(lib, "ws2_32.lib")
 
-TwitchBot::TwitchBot(const std::string& user, const std::string& oauth, const std::string& chan,
-                     KindroidAPI* api, HWND console)
-    : username(user), oauthToken(oauth), channel(chan), kindroid(api), consoleHwnd(console),
-      running(false), currentSocket(INVALID_SOCKET), currentSSL(nullptr) {
-    
-    // Ensure channel is lowercase and without #
-    std::transform(channel.begin(), channel.end(), channel.begin(), ::tolower);
-    if (!channel.empty() && channel[0] == '#') {
-        channel = channel.substr(1);
+// Workers spend nearly all their time waiting on Kindroid, so one per channel up to 16;
+// messageLimiter (20 PRIVMSGs per 30 s) caps real throughput well below that
+static int replyWorkersFor(size_t channelCount) {
+    if (channelCount < 4) return 4;
+    if (channelCount > 16) return 16;
+    return (int)channelCount;
+}
+
+TwitchBot::TwitchBot(const std::string& user, const std::string& oauth, const std::string& channelList,
+                     KindroidAPI* api, HWND console, int perConnection, bool useRawIrc)
+    : username(user), oauthToken(oauth), channels(parseChannelList(channelList)),
+      channelsPerConnection(perConnection > 0 ? perConnection : 50), rawIrc(useRawIrc), running(false),
+      kindroid(api), consoleHwnd(console), userCooldownMs(10000), channelCooldownMs(0),
+      joinLimiter(20, 10000), messageLimiter(20, 30000), replies(replyWorkersFor(channels.size())) {
+    stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    
+    // Spread the channels over as many connections as the per-connection limit needs
+    for (size_t i = 0; i < channels.size(); i++) {
+        if (i % channelsPerConnection == 0) {
+            connections.push_back(std::make_unique<TwitchConnection>((int)connections.size()));
+        }
+        connections.back()->channels.push_back(channels[i]);
+        channelOwner[channels[i]] = connections.back().get();
     }
     
     // Ensure username is lowercase
     std::transform(username.begin(), username.end(), username.begin(), ::tolower);
+    mentions.addName(username);
     
     // Ensure OAuth token has oauth: prefix
     if (!oauthToken.empty() && oauthToken.substr(0, 6) != "oauth:") {
@@ -24,14 +39,43 @@ TwitchBot::TwitchBot(const std::string& user, const std::string& oauth, const st
     }
 }
 
+std::vector<std::string> TwitchBot::parseChannelList(const std::string& channelList) {
+    // "a, #B c" -> {"a", "b", "c"}: lowercase, without '#', duplicates dropped
+    std::vector<std::string> result;
+    std::set<std::string> seen;
+    size_t pos = 0;
+    while (pos < channelList.length()) {
+        size_t start = channelList.find_first_not_of(", \t\r\n#", pos);
+        if (start == std::string::npos) break;
+        size_t end = channelList.find_first_of(", \t\r\n", start);
+        if (end == std::string::npos) end = channelList.length();
+        
+        std::string name = channelList.substr(start, end - start);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (seen.insert(name).second) {
+            result.push_back(name);
+        }
+        pos = end;
+    }
+    return result;
+}
+
 TwitchBot::~TwitchBot() {
     stop();
+    // Connections are destroyed with the bot; their threads must be gone first
+    if (botThread.joinable()) botThread.join();
+    if (stopEvent) CloseHandle(stopEvent);
 }
 
 void TwitchBot::start() {
     if (running) return;
     
+    // A previous run that ended on its own (e.g. no channels) still needs joining
+    if (botThread.joinable()) botThread.join();
+    
     running = true;
+    ResetEvent(stopEvent);
+    replies.start();
     log("[INFO] Starting Twitch bot...");
     log("[INFO] (Get OAuth token from https://twitchtokengenerator.com/)");
     botThread = std::thread(&TwitchBot::run, this);
@@ -42,17 +86,24 @@ void TwitchBot::stop() {
     
     log("[INFO] Stopping Twitch bot...");
     running = false;
+    SetEvent(stopEvent);
+    replies.stop();
     
+    // Close every connection's socket to unblock any pending recv() calls
     {
         std::lock_guard<std::mutex> lock(socketMutex);
-        if (currentSocket != INVALID_SOCKET) {
-            closesocket(currentSocket);
-            currentSocket = INVALID_SOCKET;
+        for (auto& conn : connections) {
+            if (conn->socket != INVALID_SOCKET) {
+                closesocket(conn->socket);
+                conn->socket = INVALID_SOCKET;
+            }
         }
     }
     
+    // run() joins the connection threads, so once it returns nothing touches the bot.
+    // With the sockets closed and stopEvent set every wait ends promptly.
     if (botThread.joinable()) {
-        botThread.detach();
+        botThread.join();
     }
     
     log("[INFO] Twitch bot stopped");
@@ -77,8 +128,9 @@ void TwitchBot::log(const std::string& message) {
     }
     
     if (consoleHwnd && IsWindow(consoleHwnd)) {
+        // Posted, not sent: stop() joins the connection threads on the GUI thread
         char* msgCopy = _strdup(logMsg.c_str());
-        SendMessageA(consoleHwnd, WM_USER + 100, 0, (LPARAM)msgCopy);
+        if (!PostMessageA(consoleHwnd, WM_USER + 100, 0, (LPARAM)msgCopy)) free(msgCopy);
     }
 }
 
@@ -94,66 +146,84 @@ void TwitchBot::run() {
         return;
     }
     
+    if (channels.empty()) {
+        log("[ERROR] No Twitch channels configured");
+        WSACleanup();
+        running = false;
+        return;
+    }
+    
+    log("[INFO] Joining " + std::to_string(channels.size()) + " channel(s) over " +
+        std::to_string(connections.size()) + " connection(s), " +
+        (rawIrc ? "raw IRC over TLS" : "IRC over WebSocket"));
+    
+    for (auto& conn : connections) {
+        conn->thread = std::thread(&TwitchBot::runConnection, this, conn.get());
+    }
+    for (auto& conn : connections) {
+        if (conn->thread.joinable()) conn->thread.join();
+    }
+    
+    log("[INFO] Replies: " + replies.statsString());
+    WSACleanup();
+    log("[INFO] Twitch bot thread stopped");
+    running = false;
+}
+
+void TwitchBot::runConnection(TwitchConnection* conn) {
+    std::string tag = "Connection " + std::to_string(conn->id) + ": ";
+    
     while (running) {
         try {
-            connectIRC();
+            connectIRC(conn);
         } catch (const std::exception& e) {
-            log("[ERROR] Exception: " + std::string(e.what()));
+            log("[ERROR] " + tag + "Exception: " + std::string(e.what()));
         } catch (...) {
-            log("[ERROR] Unknown exception");
+            log("[ERROR] " + tag + "Unknown exception");
         }
         
-        if (running) {
-            log("[INFO] Reconnecting in 5 seconds...");
-            for (int i = 0; i < 50 && running; i++) {
-                Sleep(100);
-            }
+        if (!running) break;
+        
+        DWORD delay = conn->reconnect.nextDelay();
+        if (delay == 0) {
+            log("[INFO] " + tag + "Reconnecting immediately...");
+        } else {
+            log("[INFO] " + tag + "Reconnecting in " + std::to_string(delay) + "ms (attempt " +
+                std::to_string(conn->reconnect.attempts()) + ")...");
         }
+        
+        // stop() signals the event, so a pending backoff never delays shutdown
+        if (WaitForSingleObject(stopEvent, delay) == WAIT_OBJECT_0) break;
     }
-    
-    WSACleanup();
-    log("[INFO] Twitch bot thread stopped");
-    running = false;
 }
 
-void TwitchBot::connectIRC() {
-    log("[INFO] Connecting to Twitch IRC...");
+void TwitchBot::connectIRC(TwitchConnection* conn) {
+    log("[INFO] Connection " + std::to_string(conn->id) + ": connecting to Twitch IRC...");
+    
+    // Twitch IRC WebSocket server - resolve (cached) and race the IPv6/IPv4 addresses
+    // Raw IRC over TLS skips the WebSocket upgrade and per-message framing
+    const char* host = rawIrc ? "irc.chat.twitch.tv" : "irc-ws.chat.twitch.tv";
+    const char* port = rawIrc ? "6697" : "443";
+    if (!serverHost.empty()) {
+        host = serverHost.c_str();
+        port = serverPort.c_str();
+    }
     
-    // Create socket
-    SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ULONGLONG connectStart = GetTickCount64();
+    SOCKET sock = NetConnect(host, port);
     if (sock == INVALID_SOCKET) {
-        log("[ERROR] Failed to create socket");
+        log(WSAGetLastError() == WSAHOST_NOT_FOUND ? "[ERROR] Failed to resolve Twitch IRC host"
+                                                   : "[ERROR] Failed to connect to Twitch");
         return;
     }
     
     {
         std::lock_guard<std::mutex> lock(socketMutex);
-        currentSocket = sock;
+        conn->socket = sock;
     }
     
-    // Resolve host
-    struct addrinfo hints = {0}, *result = nullptr;
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
-    
-    // Twitch IRC WebSocket server
-    if (getaddrinfo("irc-ws.chat.twitch.tv", "443", &hints, &result) != 0) {
-        log("[ERROR] Failed to resolve Twitch IRC host");
-        closesocket(sock);
-        return;
-    }
-    
-    // Connect
-    if (connect(sock, result->ai_addr, (int)result->ai_addrlen) == SOCKET_ERROR) {
-        log("[ERROR] Failed to connect to Twitch");
-        freeaddrinfo(result);
-        closesocket(sock);
-        return;
-    }
-    freeaddrinfo(result);
-    
-    log("[DEBUG] TCP connected, starting TLS handshake...");
+    log("[DEBUG] TCP connected in " + std::to_string(GetTickCount64() - connectStart) +
+        "ms, starting TLS handshake...");
     
     // Create SSL context
     SchannelContext* ssl = SchannelCreate(sock);
@@ -164,97 +234,87 @@ void TwitchBot::connectIRC() {
     }
     
     // TLS handshake
-    if (!SchannelHandshake(ssl, "irc-ws.chat.twitch.tv")) {
+    ULONGLONG handshakeStart = GetTickCount64();
+    if (!SchannelHandshake(ssl, host)) {
         log("[ERROR] TLS handshake failed");
         SchannelDestroy(ssl);
         closesocket(sock);
         return;
     }
     
-    log("[DEBUG] TLS established, sending WebSocket upgrade...");
-    
-    // WebSocket handshake - Twitch requires specific headers
-    std::string wsKey = base64Encode("twitch-kindroid-bot!");
-    std::string wsRequest = 
-        "GET / HTTP/1.1\r\n"
-        "Host: irc-ws.chat.twitch.tv\r\n"
-        "Upgrade: websocket\r\n"
-        "Connection: Upgrade\r\n"
-        "Sec-WebSocket-Key: " + wsKey + "\r\n"
-        "Sec-WebSocket-Version: 13\r\n"
-        "Origin: https://irc-ws.chat.twitch.tv\r\n\r\n";
-    
-    log("[DEBUG] Sending WebSocket request...");
-    
-    if (SchannelSend(ssl, wsRequest.c_str(), (int)wsRequest.length()) <= 0) {
-        log("[ERROR] Failed to send WebSocket upgrade");
-        SchannelDestroy(ssl);
-        closesocket(sock);
-        return;
-    }
-    
-    // Read WebSocket upgrade response
-    char buffer[4096];
-    int received = SchannelRecv(ssl, buffer, sizeof(buffer) - 1);
-    if (received <= 0) {
-        log("[ERROR] Failed to receive WebSocket upgrade response");
-        SchannelDestroy(ssl);
-        closesocket(sock);
-        return;
-    }
-    buffer[received] = '\0';
-    
-    log("[DEBUG] Got response: " + std::string(buffer, (received < 100) ? received : 100));
-    
-    if (strstr(buffer, "101") == nullptr) {
-        log("[ERROR] WebSocket upgrade failed - expected 101 Switching Protocols");
+    log("[DEBUG] TLS handshake took " + std::to_string(GetTickCount64() - handshakeStart) + "ms" +
+        (SchannelSessionResumed(ssl) ? " (session resumed)" : " (full handshake)"));
+    if (rawIrc) {
+        log("[INFO] Connected to Twitch IRC (raw IRC over TLS)");
+    } else if (!upgradeWebSocket(ssl)) {
         SchannelDestroy(ssl);
         closesocket(sock);
         return;
     }
     
-    log("[INFO] WebSocket connected to Twitch IRC!");
-    
     // Set socket timeout for recv (5 seconds)
     DWORD timeout = 5000;
     setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
     
-    // Store SSL context for announcements
+    // Store SSL context for replies and announcements (senders only take sendMutex)
     {
         std::lock_guard<std::mutex> lock(socketMutex);
-        currentSSL = ssl;
+        std::lock_guard<std::mutex> sendLock(conn->sendMutex);
+        conn->ssl = ssl;
+        conn->connected = true;
     }
     
     // Send IRC authentication
     log("[DEBUG] Sending IRC authentication...");
     
     // CAP REQ for tags (to get user info)
-    sendIRCMessage(ssl, "CAP REQ :twitch.tv/tags twitch.tv/commands");
+    sendIRCMessage(conn, "CAP REQ :twitch.tv/tags twitch.tv/commands");
     
     // PASS (OAuth token)
     std::string passCmd = "PASS " + oauthToken;
-    sendIRCMessage(ssl, passCmd);
+    sendIRCMessage(conn, passCmd);
     
     // NICK (username)
     std::string nickCmd = "NICK " + username;
-    sendIRCMessage(ssl, nickCmd);
+    sendIRCMessage(conn, nickCmd);
     
-    log("[DEBUG] Joining channel #" + channel + "...");
+    // JOINs are paced by the account-wide limit, so they go out from a helper
+    // thread while this one keeps reading (and answering PINGs)
+    std::thread joiner(&TwitchBot::joinChannels, this, conn);
     
-    // JOIN channel
-    std::string joinCmd = "JOIN #" + channel;
-    sendIRCMessage(ssl, joinCmd);
-    
-    log("[INFO] Joined #" + channel);
     log("[INFO] Listening for messages mentioning @" + username + "...");
     
     // Main message loop
-    std::string lineBuffer;
+    LineBuffer lines;
     
     while (running) {
+        if (rawIrc) {
+            // The TLS plaintext is the IRC line stream itself - split it where it lies
+            const char* data = nullptr;
+            WSASetLastError(0);
+            int received = SchannelRecvView(ssl, &data, 16384);
+            if (received <= 0) {
+                int err = WSAGetLastError();
+                if (err == WSAETIMEDOUT || err == WSAEWOULDBLOCK) {
+                    continue;
+                }
+                log("[ERROR] Connection lost (recv failed, err=" + std::to_string(err) + ")");
+                break;
+            }
+            
+            lines.append(data, received);
+            std::string_view line;
+            while (lines.next(line)) {
+                if (!line.empty()) {
+                    handleMessage(line, conn);
+                }
+            }
+            continue;
+        }
+        
         // Read WebSocket frame header
         unsigned char header[2];
-        int headerLen = SchannelRecv(ssl, header, 2);
+        int headerLen = SchannelRecvAll(ssl, header, 2);
         if (headerLen <= 0) {
             // Check if it's a timeout (would return -1 or 0)
             int err = WSAGetLastError();
@@ -265,11 +325,6 @@ void TwitchBot::connectIRC() {
             log("[ERROR] Connection lost (header read failed, err=" + std::to_string(err) + ")");
             break;
         }
-        if (headerLen != 2) {
-            log("[DEBUG] Partial header read: " + std::to_string(headerLen));
-            continue;
-        }
-        
         // Parse frame
         // int fin = (header[0] >> 7) & 1;
         int opcode = header[0] & 0x0F;
@@ -279,14 +334,14 @@ void TwitchBot::connectIRC() {
         // Extended payload length
         if (payloadLen == 126) {
             unsigned char ext[2];
-            if (SchannelRecv(ssl, ext, 2) != 2) {
+            if (SchannelRecvAll(ssl, ext, 2) != 2) {
                 log("[ERROR] Connection lost (ext len read failed)");
                 break;
             }
             payloadLen = (ext[0] << 8) | ext[1];
         } else if (payloadLen == 127) {
             unsigned char ext[8];
-            if (SchannelRecv(ssl, ext, 8) != 8) {
+            if (SchannelRecvAll(ssl, ext, 8) != 8) {
                 log("[ERROR] Connection lost (ext len read failed)");
                 break;
             }
@@ -299,7 +354,7 @@ void TwitchBot::connectIRC() {
         // Read mask key if present (server frames shouldn't be masked, but handle it)
         unsigned char maskKey[4] = {0};
         if (masked) {
-            if (SchannelRecv(ssl, maskKey, 4) != 4) {
+            if (SchannelRecvAll(ssl, maskKey, 4) != 4) {
                 log("[ERROR] Connection lost (mask read failed)");
                 break;
             }
@@ -336,234 +391,383 @@ void TwitchBot::connectIRC() {
         } else if (opcode == 0x9) { // Ping frame
             log("[DEBUG] Received WebSocket ping, sending pong");
             // Send pong with same payload
-            std::vector<unsigned char> pong;
-            pong.push_back(0x8A); // FIN + pong
-            pong.push_back(0x80 | (unsigned char)payload.length()); // Masked + length
-            unsigned char pongMask[4] = {0x12, 0x34, 0x56, 0x78};
-            for (int i = 0; i < 4; i++) pong.push_back(pongMask[i]);
-            for (size_t i = 0; i < payload.length(); i++) {
-                pong.push_back(payload[i] ^ pongMask[i % 4]);
-            }
-            SchannelSend(ssl, pong.data(), (int)pong.size());
+            std::lock_guard<std::mutex> lock(conn->sendMutex);
+            WebSocketSend(ssl, 0xA, payload.data(), payload.length());
             continue;
         } else if (opcode == 0xA) { // Pong frame
             log("[DEBUG] Received pong");
             continue;
         } else if (opcode == 0x1 || opcode == 0x0) { // Text or continuation
-            // Add to line buffer and process
-            lineBuffer += payload;
+            // Add to line buffer and process complete lines in place
+            lines.append(payload.data(), payload.length());
             
-            // Process complete lines
-            size_t pos;
-            while ((pos = lineBuffer.find("\r\n")) != std::string::npos) {
-                std::string line = lineBuffer.substr(0, pos);
-                lineBuffer = lineBuffer.substr(pos + 2);
-                
+            std::string_view line;
+            while (lines.next(line)) {
                 if (!line.empty()) {
-                    handleMessage(line, ssl);
+                    handleMessage(line, conn);
                 }
             }
         }
     }
     
-    // Cleanup
-    sendIRCMessage(ssl, "QUIT");
-    SchannelDestroy(ssl);
-    closesocket(sock);
-    
+    // Cleanup - detach the context from the connection before destroying it
+    conn->connected = false;
+    if (joiner.joinable()) joiner.join();
+    sendIRCMessage(conn, "QUIT");
     {
         std::lock_guard<std::mutex> lock(socketMutex);
-        currentSocket = INVALID_SOCKET;
-        currentSSL = nullptr;
+        std::lock_guard<std::mutex> sendLock(conn->sendMutex);
+        conn->socket = INVALID_SOCKET;
+        conn->ssl = nullptr;
     }
+    SchannelDestroy(ssl);
+    closesocket(sock);
     
-    log("[INFO] Disconnected from Twitch IRC");
+    log("[INFO] Connection " + std::to_string(conn->id) + ": disconnected from Twitch IRC");
 }
 
-void TwitchBot::sendIRCMessage(SchannelContext* ssl, const std::string& message) {
-    // Send as WebSocket text frame
-    std::string data = message + "\r\n";
-    
-    std::vector<unsigned char> frame;
-    frame.push_back(0x81); // FIN + text frame
-    
-    size_t len = data.length();
-    if (len < 126) {
-        frame.push_back((unsigned char)(0x80 | len)); // Masked
-    } else if (len < 65536) {
-        frame.push_back(0x80 | 126);
-        frame.push_back((unsigned char)((len >> 8) & 0xFF));
-        frame.push_back((unsigned char)(len & 0xFF));
-    } else {
-        frame.push_back(0x80 | 127);
-        for (int i = 7; i >= 0; i--) {
-            frame.push_back((unsigned char)((len >> (i * 8)) & 0xFF));
-        }
+// WebSocket transport: HTTP upgrade on the fresh TLS connection
+bool TwitchBot::upgradeWebSocket(SchannelContext* ssl) {
+    log("[DEBUG] TLS established, sending WebSocket upgrade...");
+    
+    // WebSocket handshake - Twitch requires specific headers
+    std::string wsKey = base64Encode("twitch-kindroid-bot!");
+    std::string wsRequest = 
+        "GET / HTTP/1.1\r\n"
+        "Host: irc-ws.chat.twitch.tv\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: " + wsKey + "\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "Origin: https://irc-ws.chat.twitch.tv\r\n\r\n";
+    
+    log("[DEBUG] Sending WebSocket request...");
+    
+    if (SchannelSend(ssl, wsRequest.c_str(), (int)wsRequest.length()) <= 0) {
+        log("[ERROR] Failed to send WebSocket upgrade");
+        return false;
     }
     
-    // Mask key
-    unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
-    for (int i = 0; i < 4; i++) frame.push_back(mask[i]);
+    // Read WebSocket upgrade response
+    char buffer[4096];
+    int received = SchannelRecv(ssl, buffer, sizeof(buffer) - 1);
+    if (received <= 0) {
+        log("[ERROR] Failed to receive WebSocket upgrade response");
+        return false;
+    }
+    buffer[received] = '\0';
+    
+    log("[DEBUG] Got response: " + std::string(buffer, (received < 100) ? received : 100));
+    
+    if (strstr(buffer, "101") == nullptr) {
+        log("[ERROR] WebSocket upgrade failed - expected 101 Switching Protocols");
+        return false;
+    }
     
-    // Masked payload
-    for (size_t i = 0; i < data.length(); i++) {
-        frame.push_back(data[i] ^ mask[i % 4]);
+    log("[INFO] WebSocket connected to Twitch IRC!");
+    return true;
+}
+
+void TwitchBot::joinChannels(TwitchConnection* conn) {
+    for (const auto& name : conn->channels) {
+        if (!joinLimiter.acquire(stopEvent) || !conn->connected) return;
+        
+        sendIRCMessage(conn, "JOIN #" + name);
+        log("[INFO] Joined #" + name);
+    }
+}
+
+void TwitchBot::sendIRCMessage(TwitchConnection* conn, const std::string& message) {
+    // conn->ssl is only swapped under sendMutex, so it stays valid for this send.
+    // Other connections and the socket bookkeeping are not blocked meanwhile.
+    std::lock_guard<std::mutex> lock(conn->sendMutex);
+    if (!conn->ssl) return;
+    
+    if (!rawIrc) {
+        // WebSocket text frame, CRLF appended while masking (no temporary string)
+        WebSocketSend(conn->ssl, 0x1, message.data(), message.length(), "\r\n", 2);
+        return;
     }
     
-    SchannelSend(ssl, frame.data(), (int)frame.size());
+    // Raw IRC: write the line straight into the TLS record buffer
+    int capacity = 0;
+    BYTE* out = SchannelSendBuffer(conn->ssl, &capacity);
+    if (!out) return;
+    size_t len = message.length() + 2;
+    if (len <= (size_t)capacity) {
+        memcpy(out, message.data(), message.length());
+        memcpy(out + message.length(), "\r\n", 2);
+        SchannelSendInPlace(conn->ssl, (int)len);
+    } else {
+        std::string line = message + "\r\n";
+        SchannelSend(conn->ssl, line.data(), (int)line.length());
+    }
 }
 
-void TwitchBot::sendChatMessage(SchannelContext* ssl, const std::string& message) {
+void TwitchBot::sendChatMessage(const std::string& channel, const std::string& message) {
+    auto owner = channelOwner.find(channel);
+    if (owner == channelOwner.end()) return;
+    TwitchConnection* conn = owner->second;
+    
     // Split long messages (Twitch limit is 500 chars)
     const size_t MAX_LEN = 450; // Leave some room
     
-    std::string remaining = message;
-    while (!remaining.empty()) {
-        std::string chunk;
-        if (remaining.length() <= MAX_LEN) {
-            chunk = remaining;
-            remaining.clear();
-        } else {
-            // Find a good break point
-            size_t breakPos = remaining.rfind(' ', MAX_LEN);
-            if (breakPos == std::string::npos || breakPos < MAX_LEN / 2) {
-                breakPos = MAX_LEN;
-            }
-            chunk = remaining.substr(0, breakPos);
-            remaining = remaining.substr(breakPos);
-            // Trim leading space from remaining
-            while (!remaining.empty() && remaining[0] == ' ') {
-                remaining = remaining.substr(1);
-            }
-        }
-        
-        std::string privmsg = "PRIVMSG #" + channel + " :" + chunk;
-        sendIRCMessage(ssl, privmsg);
+    std::vector<std::string> parts = splitMessage(message, MAX_LEN, false);
+    for (const auto& part : parts) {
+        // Every PRIVMSG counts against the account-wide limit, whichever channel it goes to
+        if (!messageLimiter.acquire(stopEvent)) return;
         
-        // Small delay between chunks to avoid rate limiting
-        if (!remaining.empty()) {
-            Sleep(100);
+        if (!running || !conn->connected) {
+            log("[WARNING] #" + channel + " not connected, reply dropped");
+            return;
         }
+        sendIRCMessage(conn, "PRIVMSG #" + channel + " :" + part);
     }
 }
 
-void TwitchBot::handleMessage(const std::string& line, SchannelContext* ssl) {
-    log("[DEBUG] IRC: " + line);
+static bool equalsNoCase(std::string_view a, std::string_view lowerB) {
+    if (a.size() != lowerB.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (tolower((unsigned char)a[i]) != lowerB[i]) return false;
+    }
+    return true;
+}
+
+void TwitchBot::handleMessage(std::string_view line, TwitchConnection* conn) {
+    // Every chat line lands here; only copy and write it out when debugging
+    if (g_debugMode) log("[DEBUG] IRC: " + std::string(line));
+    
+    // Format: @tags :user!user@user.tmi.twitch.tv PRIVMSG #channel :message
+    IrcMessage msg;
+    if (!msg.parse(line)) {
+        return;
+    }
     
     // Handle PING
-    if (line.substr(0, 4) == "PING") {
-        std::string pong = "PONG" + line.substr(4);
-        sendIRCMessage(ssl, pong);
+    if (msg.command == "PING") {
+        sendIRCMessage(conn, "PONG :" + std::string(msg.param(0)));
         log("[DEBUG] Sent PONG response");
         return;
     }
     
-    // Parse PRIVMSG
-    // Format: @tags :user!user@user.tmi.twitch.tv PRIVMSG #channel :message
-    // Or without tags: :user!user@user.tmi.twitch.tv PRIVMSG #channel :message
-    
-    size_t privmsgPos = line.find("PRIVMSG");
-    if (privmsgPos == std::string::npos) {
+    // RPL_WELCOME - login accepted, the connection counts as established
+    if (msg.command == "001") {
+        conn->reconnect.connected();
         return;
     }
     
-    // Extract username
-    std::string sender;
-    size_t userStart = line.find(':');
-    if (userStart != std::string::npos) {
-        // Skip tags if present
-        if (line[0] == '@') {
-            userStart = line.find(':', line.find(' '));
-        }
-        if (userStart != std::string::npos) {
-            size_t userEnd = line.find('!', userStart);
-            if (userEnd != std::string::npos) {
-                sender = line.substr(userStart + 1, userEnd - userStart - 1);
-            }
-        }
+    if (msg.command == "CLEARCHAT" || msg.command == "CLEARMSG" || msg.command == "ROOMSTATE") {
+        handleModeration(msg);
+        return;
     }
     
-    // Extract message content
-    size_t msgStart = line.find(':', privmsgPos);
-    if (msgStart == std::string::npos) {
+    if (msg.command != "PRIVMSG" || msg.paramCount < 2) {
         return;
     }
-    std::string content = line.substr(msgStart + 1);
     
     // Ignore messages from self
-    std::string senderLower = sender;
-    std::transform(senderLower.begin(), senderLower.end(), senderLower.begin(), ::tolower);
-    if (senderLower == username) {
+    std::string_view sender = msg.nick();
+    if (equalsNoCase(sender, username)) {
         return;
     }
     
-    // Check for mention (@username)
-    std::string mention = "@" + username;
-    std::string contentLower = content;
-    std::transform(contentLower.begin(), contentLower.end(), contentLower.begin(), ::tolower);
-    
-    if (contentLower.find(mention) == std::string::npos) {
+    // Check for mention (@username) in place - almost every line is not one
+    std::string_view text = msg.param(1);
+    bool mentioned = mentions.matches(text);
+    if (!mentioned && !triggers.hasTriggers()) {
         // Not mentioned, ignore
         return;
     }
     
-    log("[DEBUG] Bot was mentioned by " + sender);
+    std::string_view channel = msg.param(0);
+    if (!channel.empty() && channel[0] == '#') channel.remove_prefix(1);
     
-    // Remove the mention from content
-    size_t mentionPos = contentLower.find(mention);
-    if (mentionPos != std::string::npos) {
-        content = content.substr(0, mentionPos) + content.substr(mentionPos + mention.length());
+    // One pass over the message for every rule: ignore rules veto, trigger rules
+    // stand in for a mention
+    TriggerRules::Result rule = triggers.evaluate(text, channel, !mentioned);
+    if (rule == TriggerRules::IGNORED || (!mentioned && rule != TriggerRules::TRIGGERED)) {
+        return;
     }
     
-    // Trim whitespace
-    size_t start = content.find_first_not_of(" \t\n\r");
-    size_t end = content.find_last_not_of(" \t\n\r");
-    if (start != std::string::npos && end != std::string::npos) {
-        content = content.substr(start, end - start + 1);
-    } else {
-        content.clear();
-    }
+    // Prefer the display name (capitalization, localized names) over the login
+    std::string user = msg.displayName();
+    if (user.empty()) user = std::string(sender);
+    
+    log(std::string("[DEBUG] ") + (mentioned ? "Bot was mentioned by " : "Trigger rule matched for ") +
+        user + " in #" + std::string(channel));
     
+    // Remove the mention(s) and surrounding whitespace
+    std::string content = mentions.strip(text);
     if (content.empty()) {
         return;
     }
     
-    processChatMessage(ssl, sender, content);
+    std::string channelName(channel);
+    if (isEmoteOnly(channelName)) {
+        log("[DEBUG] #" + channelName + " is in emote-only mode, ignoring");
+        return;
+    }
+    
+    // A full lane would drop the reply, so check before the cooldown is spent
+    if (!replies.hasRoom(channelName)) {
+        log("[WARNING] Reply queue for #" + channelName + " is full, ignoring " + user);
+        return;
+    }
+    
+    // Cooldowns before anything is queued: every reply is a Kindroid call
+    std::string_view userKey = msg.userId().empty() ? sender : msg.userId();
+    if (!cooldowns.tryAcquire(CooldownTable::makeKey("twitch", channel, userKey), userCooldownMs,
+                              CooldownTable::makeKey("twitch", channel, ""), channelCooldownMs)) {
+        log("[DEBUG] " + user + " in #" + channelName + " is on cooldown, ignoring");
+        return;
+    }
+    
+    processChatMessage(channelName, user, std::string(userKey), std::string(msg.rawTag("id")), content);
 }
 
-void TwitchBot::processChatMessage(SchannelContext* ssl, const std::string& user, const std::string& message) {
-    log("[CHAT] " + user + ": " + message);
+void TwitchBot::handleModeration(const IrcMessage& msg) {
+    std::string_view channelView = msg.param(0);
+    if (!channelView.empty() && channelView[0] == '#') channelView.remove_prefix(1);
+    std::string channel(channelView);
+    
+    // @login=<user>;target-msg-id=<id> :tmi.twitch.tv CLEARMSG #channel :<message>
+    if (msg.command == "CLEARMSG") {
+        size_t count = replies.cancelMessage(channel, std::string(msg.rawTag("target-msg-id")));
+        if (count > 0) {
+            log("[INFO] Message from " + std::string(msg.rawTag("login")) + " deleted in #" + channel +
+                ", reply cancelled");
+        }
+        return;
+    }
+    
+    // @ban-duration=<s>;target-user-id=<id> :tmi.twitch.tv CLEARCHAT #channel :<user>
+    // (timeout or ban), or no user when the whole chat was cleared
+    if (msg.command == "CLEARCHAT") {
+        size_t count;
+        std::string who;
+        if (msg.paramCount < 2) {
+            count = replies.cancelLane(channel);
+            who = "Chat cleared";
+        } else {
+            std::string_view userKey = msg.rawTag("target-user-id");
+            if (userKey.empty()) userKey = msg.param(1);
+            count = replies.cancelUser(channel, std::string(userKey));
+            who = std::string(msg.param(1)) + (msg.rawTag("ban-duration").empty() ? " banned" : " timed out");
+        }
+        if (count > 0) {
+            log("[INFO] " + who + " in #" + channel + ", " + std::to_string(count) + " reply(s) cancelled");
+        }
+        return;
+    }
+    
+    // ROOMSTATE: every mode after JOIN, afterwards only the ones that changed
+    std::string_view value;
+    bool emoteOnlyChanged = msg.findTag("emote-only", value);
+    bool emoteOnly = value == "1";
+    bool slowChanged = msg.findTag("slow", value);
+    int slowSecs = slowChanged ? atoi(std::string(value).c_str()) : 0;
+    {
+        std::lock_guard<std::mutex> lock(roomMutex);
+        RoomState& room = rooms[channel];
+        if (emoteOnlyChanged) room.emoteOnly = emoteOnly;
+        if (slowChanged) room.slowSecs = slowSecs;
+    }
     
-    // Process in a detached thread to avoid blocking the receive loop
-    std::thread([this, ssl, user, message]() {
+    if (emoteOnlyChanged && emoteOnly) {
+        size_t count = replies.cancelLane(channel);
+        log("[INFO] #" + channel + " is in emote-only mode, " + std::to_string(count) + " reply(s) cancelled");
+    }
+    if (slowChanged) {
+        // Slow mode applies to the bot too (unless it is a moderator), so pace the lane to match
+        replies.setLaneInterval(channel, slowSecs > 0 ? (DWORD)slowSecs * 1000 : 0);
+        if (slowSecs > 0) log("[INFO] #" + channel + " is in slow mode (" + std::to_string(slowSecs) + " s)");
+    }
+}
+
+bool TwitchBot::isEmoteOnly(const std::string& channel) {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    auto it = rooms.find(channel);
+    return it != rooms.end() && it->second.emoteOnly;
+}
+
+void TwitchBot::processChatMessage(const std::string& channel, const std::string& user, const std::string& userKey,
+                                   const std::string& messageId, const std::string& message) {
+    log("[CHAT] #" + channel + " " + user + ": " + message);
+    
+    // Replies run on the queue's workers: one at a time and paced per channel,
+    // so a busy channel can't starve the others or block the receive loop
+    bool queued = replies.enqueue(channel, userKey, messageId,
+                                  [this, channel, user, message](const std::atomic<bool>& cancelled) {
         // Create context for Kindroid
         std::string context = "Twitch / #" + channel;
         
         log("[DEBUG] Sending to Kindroid API...");
         std::string response = kindroid->sendMessage(user, context, message);
+        if (!running) return;
+        
+        // Moderation removed the message (or its author) while Kindroid was answering
+        if (cancelled) {
+            log("[DEBUG] Reply to " + user + " in #" + channel + " cancelled by moderation, not sent");
+            return;
+        }
         
         log("[KINDROID] " + response);
         
         if (!response.empty() && response.find("[ERROR]") == std::string::npos) {
-            log("[DEBUG] Sending response to Twitch chat...");
-            // Use mutex to protect socket access
-            std::lock_guard<std::mutex> lock(socketMutex);
-            if (running && currentSocket != INVALID_SOCKET) {
-                sendChatMessage(ssl, response);
-                log("[DEBUG] Response sent");
-            }
+            log("[DEBUG] Sending response to Twitch #" + channel + "...");
+            sendChatMessage(channel, response);
         }
-    }).detach();
+    });
+    
+    if (!queued) {
+        log("[WARNING] Reply queue for #" + channel + " is full, ignoring " + user);
+    }
+}
+
+void TwitchBot::setTriggerRules(const std::string& rulesText) {
+    for (const auto& problem : triggers.load(rulesText)) {
+        log("[WARNING] Trigger rules, " + problem);
+    }
+    if (triggers.ruleCount() > 0) {
+        log("[INFO] Loaded " + std::to_string(triggers.ruleCount()) + " trigger rule(s)");
+    }
+}
+
+void TwitchBot::setMentionAliases(const std::string& aliasList) {
+    mentions.addNames(aliasList);
+}
+
+void TwitchBot::setCooldowns(int userSecs, int channelSecs) {
+    userCooldownMs = userSecs > 0 ? (DWORD)userSecs * 1000 : 0;
+    channelCooldownMs = channelSecs > 0 ? (DWORD)channelSecs * 1000 : 0;
+}
+
+void TwitchBot::setServer(const std::string& host, const std::string& port) {
+    serverHost = host;
+    serverPort = port;
+}
+
+void TwitchBot::setRateLimits(size_t joins, DWORD joinWindowMs, size_t messages, DWORD messageWindowMs) {
+    joinLimiter.setLimit(joins, joinWindowMs);
+    messageLimiter.setLimit(messages, messageWindowMs);
 }
 
 void TwitchBot::sendAnnouncement(const std::string& message) {
-    std::lock_guard<std::mutex> lock(socketMutex);
-    
-    if (!running || currentSocket == INVALID_SOCKET || currentSSL == nullptr) {
+    if (!running) {
         log("[ANNOUNCE] Twitch not connected, cannot send announcement");
         return;
     }
     
-    log("[ANNOUNCE] Sending to Twitch #" + channel + ": " + message);
-    sendChatMessage(currentSSL, message);
+    // Queued behind any pending replies so the rate limit never blocks the caller
+    for (const auto& channel : channels) {
+        bool queued = replies.enqueue(channel, "", "", [this, channel, message](const std::atomic<bool>& cancelled) {
+            // Chat cleared or emote-only switched on while this waited
+            if (cancelled) return;
+            log("[ANNOUNCE] Sending to Twitch #" + channel + ": " + message);
+            sendChatMessage(channel, message);
+        });
+        if (!queued) {
+            log("[ANNOUNCE] Reply queue for #" + channel + " is full, announcement skipped");
+        }
+    }
 }
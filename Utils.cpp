@@ -1,4 +1,6 @@
 #include "KindroidBot.h"
+#include <charconv>
+#include <random>
 
 std::string wstringToString(const std::wstring& wstr) {
     if (wstr.empty()) return std::string();
@@ -31,6 +33,13 @@ std::string getCurrentTimestamp() {
     return std::string(buffer);
 }
 
+// Uniform random delay in [0, maxMs], for heartbeat and reconnect jitter
+DWORD randomDelay(DWORD maxMs) {
+    static thread_local std::mt19937 rng(std::random_device{}());
+    std::uniform_int_distribution<DWORD> dist(0, maxMs);
+    return dist(rng);
+}
+
 static const char base64_chars[] = 
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
     "abcdefghijklmnopqrstuvwxyz"
@@ -44,7 +53,7 @@ std::string base64Encode(const std::string& input) {
     unsigned char char_array_4[4];
     size_t in_len = input.size();
     const unsigned char* bytes_to_encode = (const unsigned char*)input.c_str();
-
+    
     while (in_len--) {
         char_array_3[i++] = *(bytes_to_encode++);
         if (i == 3) {
@@ -52,143 +61,322 @@ std::string base64Encode(const std::string& input) {
             char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
             char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
             char_array_4[3] = char_array_3[2] & 0x3f;
-
+            
             for(i = 0; i < 4; i++)
                 ret += base64_chars[char_array_4[i]];
             i = 0;
         }
     }
-
+    
     if (i) {
         for(j = i; j < 3; j++)
             char_array_3[j] = '\0';
-
+        
         char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
         char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
         char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-
+        
         for (j = 0; j < i + 1; j++)
             ret += base64_chars[char_array_4[j]];
-
+        
         while(i++ < 3)
             ret += '=';
     }
-
+    
     return ret;
 }
 
 // Simple JSON implementation
-std::string SimpleJSON::escape(const std::string& str) {
-    std::string result;
-    for (size_t i = 0; i < str.length(); i++) {
-        unsigned char c = (unsigned char)str[i];
+
+// Strings are scanned 16 bytes at a time for the bytes that need work (quote,
+// backslash and control characters when escaping; backslash when unescaping),
+// and the clean runs in between are appended in one go. SSE2 is part of the
+// x64 baseline; other targets use the scalar loop. Long clean runs (history,
+// backfills, emoji-heavy text) go 32 bytes at a time with AVX2 when CPUID says
+// the CPU and OS support it. Build with SIMPLEJSON_NO_AVX2 for the SSE2-only baseline.
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define SIMPLEJSON_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static inline unsigned firstSetBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+#if !defined(SIMPLEJSON_NO_AVX2) && (defined(_MSC_VER) || defined(__GNUC__))
+#define SIMPLEJSON_AVX2 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define SIMPLEJSON_AVX2_FN
+#else
+#define SIMPLEJSON_AVX2_FN __attribute__((target("avx2")))
+#endif
+
+static bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    // AVX, and the OS saving YMM state (OSXSAVE + XCR0 bits 1-2), before AVX2 itself
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool useAvx2() {
+    static const bool supported = cpuHasAvx2();
+    return supported;
+}
+
+// Chat text hits a quote or newline every few dozen bytes, where the switch costs
+// more than the wider loop saves. Only a run still clean after eight SSE2 blocks,
+// with at least two AVX2 blocks left, moves over.
+static const size_t AVX2_AFTER_CLEAN_BYTES = 128;
+static const size_t AVX2_MIN_BYTES = 64;
+
+// Scans whole 32-byte blocks from i; true with i at the first hit, false with
+// i at the unscanned tail (fewer than 32 bytes)
+SIMPLEJSON_AVX2_FN static bool findEscapeByteAvx2(const char* data, size_t& i, size_t len) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i controlMax = _mm256_set1_epi8(0x1F);
+    bool found = false;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(v, controlMax), v));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hits);
+        if (mask) {
+            i += firstSetBit(mask);
+            found = true;
+            break;
+        }
+    }
+    _mm256_zeroupper(); // No AVX-SSE transition penalty in the SSE2 code after this
+    return found;
+}
+
+SIMPLEJSON_AVX2_FN static bool findBackslashAvx2(const char* data, size_t& i, size_t len) {
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    bool found = false;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash));
+        if (mask) {
+            i += firstSetBit(mask);
+            found = true;
+            break;
+        }
+    }
+    _mm256_zeroupper();
+    return found;
+}
+#endif
+#endif
+
+static inline bool needsEscape(unsigned char c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+// Offset of the first byte in [from, len) that needs escaping, or len
+static size_t findEscapeByte(const char* data, size_t from, size_t len) {
+    size_t i = from;
+#ifdef SIMPLEJSON_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i controlMax = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= len; i += 16) {
+#ifdef SIMPLEJSON_AVX2
+        if (i - from == AVX2_AFTER_CLEAN_BYTES && len - i >= AVX2_MIN_BYTES && useAvx2()) {
+            if (findEscapeByteAvx2(data, i, len)) return i;
+            if (i + 16 > len) break;
+        }
+#endif
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(v, controlMax), v)); // unsigned v <= 0x1F
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask) return i + firstSetBit(mask);
+    }
+#endif
+    for (; i < len; i++) {
+        if (needsEscape((unsigned char)data[i])) return i;
+    }
+    return len;
+}
+
+// Offset of the next backslash in [from, len), or len
+static size_t findBackslash(const char* data, size_t from, size_t len) {
+    size_t i = from;
+#ifdef SIMPLEJSON_SSE2
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; i + 16 <= len; i += 16) {
+#ifdef SIMPLEJSON_AVX2
+        if (i - from == AVX2_AFTER_CLEAN_BYTES && len - i >= AVX2_MIN_BYTES && useAvx2()) {
+            if (findBackslashAvx2(data, i, len)) return i;
+            if (i + 16 > len) break;
+        }
+#endif
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash));
+        if (mask) return i + firstSetBit(mask);
+    }
+#endif
+    const void* hit = memchr(data + i, '\\', len - i);
+    return hit ? (size_t)((const char*)hit - data) : len;
+}
+
+// Value of the four hex digits at p, or -1 if any of them is not a hex digit
+static int parseHex4(const char* p) {
+    int value = 0;
+    for (int k = 0; k < 4; k++) {
+        char c = p[k];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return -1;
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+// Callers pass scalar values only (surrogates already paired or replaced)
+static void appendUtf8(std::string& out, unsigned int codepoint) {
+    char buf[4];
+    size_t len;
+    if (codepoint <= 0x7F) {
+        buf[0] = (char)codepoint;
+        len = 1;
+    } else if (codepoint <= 0x7FF) {
+        buf[0] = (char)(0xC0 | (codepoint >> 6));
+        buf[1] = (char)(0x80 | (codepoint & 0x3F));
+        len = 2;
+    } else if (codepoint <= 0xFFFF) {
+        buf[0] = (char)(0xE0 | (codepoint >> 12));
+        buf[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (codepoint & 0x3F));
+        len = 3;
+    } else {
+        buf[0] = (char)(0xF0 | (codepoint >> 18));
+        buf[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+        buf[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        buf[3] = (char)(0x80 | (codepoint & 0x3F));
+        len = 4;
+    }
+    out.append(buf, len);
+}
+
+void SimpleJSON::escapeAppend(std::string& out, const char* data, size_t len) {
+    static const char hexDigits[] = "0123456789abcdef";
+    size_t pos = 0;
+    while (pos < len) {
+        size_t hit = findEscapeByte(data, pos, len);
+        out.append(data + pos, hit - pos); // Clean run, including all bytes >= 0x80 (UTF-8)
+        if (hit == len) break;
+        
+        unsigned char c = (unsigned char)data[hit];
         switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\b': result += "\\b"; break;
-            case '\f': result += "\\f"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default:
-                // Pass through all bytes >= 0x80 (UTF-8 continuation bytes and multibyte chars)
-                // Only escape control characters < 32
-                if (c < 32) {
-                    char buf[8];
-                    sprintf(buf, "\\u%04x", c);
-                    result += buf;
-                } else {
-                    result += (char)c;
-                }
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                // Remaining control characters < 32
+                char buf[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF] };
+                out.append(buf, 6);
+            }
         }
+        pos = hit + 1;
     }
+}
+
+std::string SimpleJSON::escape(const std::string& str) {
+    std::string result;
+    result.reserve(str.length() + str.length() / 8 + 8);
+    escapeAppend(result, str.data(), str.length());
     return result;
 }
 
 std::string SimpleJSON::unescape(const std::string& str) {
     std::string result;
-    for (size_t i = 0; i < str.length(); i++) {
-        if (str[i] == '\\' && i + 1 < str.length()) {
-            switch (str[i + 1]) {
-                case '"': result += '"'; i++; break;
-                case '\\': result += '\\'; i++; break;
-                case 'b': result += '\b'; i++; break;
-                case 'f': result += '\f'; i++; break;
-                case 'n': result += '\n'; i++; break;
-                case 'r': result += '\r'; i++; break;
-                case 't': result += '\t'; i++; break;
-                case '/': result += '/'; i++; break;
-                case 'u': {
-                    // Unicode escape: \uXXXX
-                    if (i + 5 < str.length()) {
-                        std::string hex = str.substr(i + 2, 4);
-                        unsigned int codepoint = std::stoul(hex, nullptr, 16);
-                        
-                        // Check for surrogate pair (emoji)
-                        if (codepoint >= 0xD800 && codepoint <= 0xDBFF && i + 11 < str.length() 
-                            && str[i + 6] == '\\' && str[i + 7] == 'u') {
-                            // High surrogate followed by low surrogate
-                            std::string hex2 = str.substr(i + 8, 4);
-                            unsigned int low = std::stoul(hex2, nullptr, 16);
-                            if (low >= 0xDC00 && low <= 0xDFFF) {
-                                // Combine surrogates into full codepoint
-                                unsigned int fullCodepoint = 0x10000 + ((codepoint & 0x3FF) << 10) + (low & 0x3FF);
-                                // Convert to UTF-8
-                                if (fullCodepoint <= 0x7F) {
-                                    result += (char)fullCodepoint;
-                                } else if (fullCodepoint <= 0x7FF) {
-                                    result += (char)(0xC0 | (fullCodepoint >> 6));
-                                    result += (char)(0x80 | (fullCodepoint & 0x3F));
-                                } else if (fullCodepoint <= 0xFFFF) {
-                                    result += (char)(0xE0 | (fullCodepoint >> 12));
-                                    result += (char)(0x80 | ((fullCodepoint >> 6) & 0x3F));
-                                    result += (char)(0x80 | (fullCodepoint & 0x3F));
-                                } else {
-                                    result += (char)(0xF0 | (fullCodepoint >> 18));
-                                    result += (char)(0x80 | ((fullCodepoint >> 12) & 0x3F));
-                                    result += (char)(0x80 | ((fullCodepoint >> 6) & 0x3F));
-                                    result += (char)(0x80 | (fullCodepoint & 0x3F));
-                                }
-                                i += 11; // Skip both \uXXXX sequences
-                                break;
-                            }
-                        }
-                        
-                        // Single codepoint (not surrogate pair) - convert to UTF-8
-                        if (codepoint <= 0x7F) {
-                            result += (char)codepoint;
-                        } else if (codepoint <= 0x7FF) {
-                            result += (char)(0xC0 | (codepoint >> 6));
-                            result += (char)(0x80 | (codepoint & 0x3F));
-                        } else {
-                            result += (char)(0xE0 | (codepoint >> 12));
-                            result += (char)(0x80 | ((codepoint >> 6) & 0x3F));
-                            result += (char)(0x80 | (codepoint & 0x3F));
-                        }
-                        i += 5; // Skip \uXXXX
+    result.reserve(str.length());
+    size_t pos = 0;
+    while (pos < str.length()) {
+        size_t i = findBackslash(str.data(), pos, str.length());
+        result.append(str, pos, i - pos);
+        if (i == str.length()) break;
+        
+        if (i + 1 >= str.length()) {
+            result += str[i]; // Trailing lone backslash
+            break;
+        }
+        switch (str[i + 1]) {
+            case '"': result += '"'; i++; break;
+            case '\\': result += '\\'; i++; break;
+            case 'b': result += '\b'; i++; break;
+            case 'f': result += '\f'; i++; break;
+            case 'n': result += '\n'; i++; break;
+            case 'r': result += '\r'; i++; break;
+            case 't': result += '\t'; i++; break;
+            case '/': result += '/'; i++; break;
+            case 'u': {
+                // Unicode escape: \uXXXX, or a \uD8xx\uDCxx surrogate pair (emoji)
+                int codepoint = i + 5 < str.length() ? parseHex4(str.data() + i + 2) : -1;
+                if (codepoint < 0) {
+                    result += str[i]; // Malformed - keep the text as it was
+                    break;
+                }
+                i += 5; // Skip \uXXXX
+                
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                    int low = (i + 6 < str.length() && str[i + 1] == '\\' && str[i + 2] == 'u')
+                                  ? parseHex4(str.data() + i + 3) : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codepoint = 0x10000 + ((codepoint & 0x3FF) << 10) + (low & 0x3FF);
+                        i += 6;
                     } else {
-                        result += str[i];
+                        codepoint = 0xFFFD; // Lone high surrogate
                     }
-                    break;
+                } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+                    codepoint = 0xFFFD; // Lone low surrogate
                 }
-                default: result += str[i];
+                appendUtf8(result, (unsigned int)codepoint);
+                break;
             }
-        } else {
-            result += str[i];
+            default: result += str[i];
         }
+        pos = i + 1;
     }
     return result;
 }
 
 std::string SimpleJSON::buildObject(const std::map<std::string, std::string>& obj) {
-    std::string result = "{";
-    bool first = true;
+    std::string result;
+    JsonWriter writer(result);
+    writer.beginObject();
     for (const auto& pair : obj) {
-        if (!first) result += ",";
-        result += "\"" + pair.first + "\":\"" + escape(pair.second) + "\"";
-        first = false;
+        writer.key(pair.first).string(pair.second);
     }
-    result += "}";
+    writer.endObject();
     return result;
 }
 
@@ -292,11 +480,238 @@ std::vector<std::map<std::string, std::string>> SimpleJSON::parseArray(const std
 }
 
 std::string SimpleJSON::buildConversationArray(const std::vector<std::map<std::string, std::string>>& conversation) {
-    std::string result = "[";
-    for (size_t i = 0; i < conversation.size(); i++) {
-        if (i > 0) result += ",";
-        result += buildObject(conversation[i]);
+    std::string result;
+    JsonWriter writer(result);
+    writer.beginArray();
+    for (const auto& message : conversation) {
+        writer.beginObject();
+        for (const auto& pair : message) {
+            writer.key(pair.first).string(pair.second);
+        }
+        writer.endObject();
+    }
+    writer.endArray();
+    return result;
+}
+
+// Returns the index just past the JSON value starting at pos (whitespace skipped)
+size_t SimpleJSON::skipValue(const std::string& json, size_t pos) {
+    size_t len = json.length();
+    while (pos < len && (json[pos] == ' ' || json[pos] == '\n' || json[pos] == '\r' || json[pos] == '\t')) pos++;
+    if (pos >= len) return len;
+    
+    if (json[pos] == '"') {
+        pos++;
+        while (pos < len && json[pos] != '"') {
+            if (json[pos] == '\\') pos++;
+            pos++;
+        }
+        return (pos < len) ? pos + 1 : len;
+    }
+    
+    if (json[pos] == '{' || json[pos] == '[') {
+        int depth = 0;
+        while (pos < len) {
+            char c = json[pos];
+            if (c == '"') {
+                pos = skipValue(json, pos);
+                continue;
+            }
+            if (c == '{' || c == '[') depth++;
+            else if (c == '}' || c == ']') {
+                depth--;
+                if (depth == 0) return pos + 1;
+            }
+            pos++;
+        }
+        return len;
+    }
+    
+    // Number, true, false, null
+    while (pos < len && json[pos] != ',' && json[pos] != '}' && json[pos] != ']') pos++;
+    return pos;
+}
+
+bool SimpleJSON::findMember(const std::string& json, size_t objStart, const std::string& key,
+                            size_t& valueStart, size_t& valueEnd) {
+    size_t pos = json.find('{', objStart);
+    if (pos == std::string::npos) return false;
+    pos++;
+    
+    size_t len = json.length();
+    while (pos < len) {
+        // Find next key at this level
+        while (pos < len && json[pos] != '"' && json[pos] != '}') pos++;
+        if (pos >= len || json[pos] == '}') break;
+        
+        size_t keyStart = pos + 1;
+        size_t keyEnd = skipValue(json, pos) - 1;
+        if (keyEnd >= len) break;
+        
+        pos = json.find(':', keyEnd + 1);
+        if (pos == std::string::npos) break;
+        pos++;
+        while (pos < len && (json[pos] == ' ' || json[pos] == '\n' || json[pos] == '\r' || json[pos] == '\t')) pos++;
+        
+        size_t end = skipValue(json, pos);
+        if (keyEnd - keyStart == key.length() && json.compare(keyStart, key.length(), key) == 0) {
+            valueStart = pos;
+            valueEnd = end;
+            return true;
+        }
+        
+        pos = end;
+        while (pos < len && json[pos] != ',' && json[pos] != '}') pos++;
+        if (pos < len && json[pos] == ',') pos++;
+    }
+    
+    return false;
+}
+
+std::string SimpleJSON::getMember(const std::string& json, const std::string& key) {
+    size_t valueStart, valueEnd;
+    if (!findMember(json, 0, key, valueStart, valueEnd)) return "";
+    return json.substr(valueStart, valueEnd - valueStart);
+}
+
+std::string SimpleJSON::getMemberString(const std::string& json, const std::string& key) {
+    std::string raw = getMember(json, key);
+    if (raw.length() < 2 || raw[0] != '"') return "";
+    return unescape(raw.substr(1, raw.length() - 2));
+}
+
+std::vector<std::string> SimpleJSON::splitArray(const std::string& json) {
+    std::vector<std::string> result;
+    
+    size_t pos = json.find('[');
+    if (pos == std::string::npos) return result;
+    pos++;
+    
+    size_t len = json.length();
+    while (pos < len) {
+        while (pos < len && (json[pos] == ' ' || json[pos] == '\n' || json[pos] == '\r' || json[pos] == '\t' || json[pos] == ',')) pos++;
+        if (pos >= len || json[pos] == ']') break;
+        
+        size_t end = skipValue(json, pos);
+        result.push_back(json.substr(pos, end - pos));
+        pos = end;
     }
-    result += "]";
+    
     return result;
 }
+
+// ============================================
+// JsonWriter
+// ============================================
+
+JsonWriter::JsonWriter(std::string& out, int indent)
+    : out(out), indent(indent), depth(0), afterKey(false) {
+    hasItems[0] = false;
+}
+
+void JsonWriter::newline(int level) {
+    if (indent <= 0) return;
+    out += '\n';
+    out.append((size_t)(level * indent), ' ');
+}
+
+void JsonWriter::beforeValue() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (depth > 0) {
+        if (hasItems[depth]) out += ',';
+        newline(depth);
+    }
+    hasItems[depth] = true;
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    beforeValue();
+    out += '{';
+    if (depth + 1 < MAX_DEPTH) depth++;
+    hasItems[depth] = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    if (depth > 0) depth--;
+    newline(depth);
+    out += '}';
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    beforeValue();
+    out += '[';
+    if (depth + 1 < MAX_DEPTH) depth++;
+    hasItems[depth] = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    if (depth > 0) depth--;
+    newline(depth);
+    out += ']';
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name, size_t len) {
+    beforeValue();
+    out += '"';
+    SimpleJSON::escapeAppend(out, name, len);
+    out += indent > 0 ? "\": " : "\":";
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const std::string& name) {
+    return key(name.data(), name.length());
+}
+
+JsonWriter& JsonWriter::key(const char* name) {
+    return key(name, strlen(name));
+}
+
+JsonWriter& JsonWriter::string(const char* value, size_t len) {
+    beforeValue();
+    out += '"';
+    SimpleJSON::escapeAppend(out, value, len);
+    out += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::string(const std::string& value) {
+    return string(value.data(), value.length());
+}
+
+JsonWriter& JsonWriter::string(const char* value) {
+    return string(value, strlen(value));
+}
+
+JsonWriter& JsonWriter::number(long long value) {
+    beforeValue();
+    char buf[24];
+    char* end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+    out.append(buf, (size_t)(end - buf));
+    return *this;
+}
+
+JsonWriter& JsonWriter::boolean(bool value) {
+    beforeValue();
+    out += value ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    beforeValue();
+    out += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(const std::string& json) {
+    beforeValue();
+    out += json;
+    return *this;
+}
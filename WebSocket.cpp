@@ -0,0 +1,86 @@
+#include "KindroidBot.h"
+
+// ============================================
+// WebSocket client frames (RFC 6455)
+// ============================================
+
+static const unsigned char kMaskKey[4] = {0x12, 0x34, 0x56, 0x78};
+
+static size_t frameHeaderLength(size_t payloadLen) {
+    size_t len = 2 + 4; // Opcode/length bytes + mask key
+    if (payloadLen >= 65536) len += 8;
+    else if (payloadLen >= 126) len += 2;
+    return len;
+}
+
+static size_t writeFrameHeader(unsigned char* out, int opcode, size_t payloadLen) {
+    size_t pos = 0;
+    out[pos++] = (unsigned char)(0x80 | (opcode & 0x0F)); // FIN + opcode
+    
+    if (payloadLen < 126) {
+        out[pos++] = (unsigned char)(0x80 | payloadLen); // Masked
+    } else if (payloadLen < 65536) {
+        out[pos++] = 0x80 | 126;
+        out[pos++] = (unsigned char)((payloadLen >> 8) & 0xFF);
+        out[pos++] = (unsigned char)(payloadLen & 0xFF);
+    } else {
+        out[pos++] = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) {
+            out[pos++] = (unsigned char)(((uint64_t)payloadLen >> (i * 8)) & 0xFF);
+        }
+    }
+    
+    memcpy(out + pos, kMaskKey, 4);
+    return pos + 4;
+}
+
+// Copy src to dst masked, where src starts maskOffset bytes into the payload.
+// Works a 32-bit word at a time; the key is rotated to line up with maskOffset.
+static void maskCopy(unsigned char* dst, const char* src, size_t len, size_t maskOffset) {
+    unsigned char key[4];
+    for (int i = 0; i < 4; i++) key[i] = kMaskKey[(maskOffset + i) % 4];
+    
+    uint32_t key32;
+    memcpy(&key32, key, 4);
+    
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        uint32_t word;
+        memcpy(&word, src + i, 4);
+        word ^= key32;
+        memcpy(dst + i, &word, 4);
+    }
+    for (; i < len; i++) {
+        dst[i] = (unsigned char)(src[i] ^ key[i % 4]);
+    }
+}
+
+bool WebSocketSend(SchannelContext* ssl, int opcode, const char* data, size_t len,
+                   const char* suffix, size_t suffixLen) {
+    size_t payloadLen = len + suffixLen;
+    size_t headerLen = frameHeaderLength(payloadLen);
+    size_t frameLen = headerLen + payloadLen;
+    
+    // Common case: the whole frame fits in one TLS record, so build it directly
+    // in the connection's record buffer and encrypt it there.
+    int capacity = 0;
+    BYTE* out = SchannelSendBuffer(ssl, &capacity);
+    if (!out) return false;
+    
+    if (frameLen <= (size_t)capacity) {
+        writeFrameHeader(out, opcode, payloadLen);
+        maskCopy(out + headerLen, data, len, 0);
+        if (suffixLen > 0) maskCopy(out + headerLen + len, suffix, suffixLen, len);
+        return SchannelSendInPlace(ssl, (int)frameLen) == (int)frameLen;
+    }
+    
+    // Larger frames are assembled in a reused per-thread buffer and sent as
+    // several records in one gather write by SchannelSend.
+    static thread_local std::vector<unsigned char> frame;
+    frame.resize(frameLen);
+    writeFrameHeader(frame.data(), opcode, payloadLen);
+    maskCopy(frame.data() + headerLen, data, len, 0);
+    if (suffixLen > 0) maskCopy(frame.data() + headerLen + len, suffix, suffixLen, len);
+    
+    return SchannelSend(ssl, frame.data(), (int)frameLen) == (int)frameLen;
+}
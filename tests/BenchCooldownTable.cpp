@@ -0,0 +1,74 @@
+// Check and benchmark for CooldownTable (CooldownTable.cpp).
+// First the rules the bots rely on: a user is held back until their cooldown runs
+// out, 0 ms never holds anyone, and the two-key form starts both cooldowns or
+// neither. Then DISTINCT_USERS different users each ask once in one channel, with a
+// user and a channel key per check as the bots build them, through a table of
+// CAPACITY slots: reports ns per check, memory and evictions. Run
+// tests\build_tests.bat from a Visual Studio x64 Native Tools prompt; exits non-zero
+// on any failed check.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <chrono>
+
+static const size_t CAPACITY = 65536;
+static const int DISTINCT_USERS = 5000000;
+static const DWORD COOLDOWN_MS = 10000; // userCooldownSecs' default
+static const DWORD SHORT_MS = 50;       // For the expiry check
+
+static int expect(const char* what, bool actual, bool expected) {
+    if (actual == expected) return 0;
+    printf("%s: %s, expected %s\n", what, actual ? "allowed" : "held back", expected ? "allowed" : "held back");
+    return 1;
+}
+
+int main() {
+    int failures = 0;
+
+    {
+        CooldownTable table(1024);
+        uint64_t user = CooldownTable::makeKey("discord", "c", "u");
+        uint64_t other = CooldownTable::makeKey("discord", "c", "v");
+        uint64_t channel = CooldownTable::makeKey("discord", "c", "");
+
+        failures += expect("first ask", table.tryAcquire(user, COOLDOWN_MS), true);
+        failures += expect("same user again", table.tryAcquire(user, COOLDOWN_MS), false);
+        failures += expect("same user in another channel",
+                           table.tryAcquire(CooldownTable::makeKey("discord", "d", "u"), COOLDOWN_MS), true);
+        failures += expect("same user, 0 ms", table.tryAcquire(user, 0), true);
+
+        // The channel cooldown holds back the next user without starting theirs
+        failures += expect("other user, channel free", table.tryAcquire(other, COOLDOWN_MS, channel, SHORT_MS), true);
+        uint64_t third = CooldownTable::makeKey("discord", "c", "w");
+        failures += expect("third user, channel cooling", table.tryAcquire(third, COOLDOWN_MS, channel, SHORT_MS), false);
+        failures += expect("third user alone", table.tryAcquire(third, COOLDOWN_MS), true);
+
+        uint64_t brief = CooldownTable::makeKey("discord", "c", "x");
+        table.tryAcquire(brief, SHORT_MS);
+        Sleep(SHORT_MS * 2);
+        failures += expect("after the cooldown", table.tryAcquire(brief, SHORT_MS), true);
+        failures += expect("channel after its cooldown", table.tryAcquire(0, 0, channel, SHORT_MS), true);
+    }
+
+    // Churn: far more users than slots, each asking once
+    CooldownTable table(CAPACITY);
+    uint64_t channel = CooldownTable::makeKey("twitch", "chan", "");
+    size_t allowed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < DISTINCT_USERS; i++) {
+        std::string user = std::to_string(i);
+        allowed += table.tryAcquire(CooldownTable::makeKey("twitch", "chan", user), COOLDOWN_MS, channel, 0);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%d distinct users, %zu slots (%zu KB): %.0f ns per check including the key, %llu evictions\n",
+           DISTINCT_USERS, table.capacity(), table.capacity() * 16 / 1024, ns / DISTINCT_USERS,
+           (unsigned long long)table.evictions());
+    if (allowed != (size_t)DISTINCT_USERS) {
+        printf("%zu of %d first asks allowed\n", allowed, DISTINCT_USERS);
+        failures++;
+    }
+
+    printf("BenchCooldownTable: %d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
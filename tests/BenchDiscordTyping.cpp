@@ -0,0 +1,269 @@
+// Mock-gateway benchmark for Discord's typing indicator: what it saves in repeat
+// mentions and what it costs in REST calls. A real DiscordBot answers mentions in
+// CHANNELS channels over a local gateway (see ReplayDiscordEdits); Discord's REST API
+// and Kindroid are faked here: each Discord call takes DISCORD_REST_MS, and Kindroid
+// latencies are drawn from a log-normal around KINDROID_MEDIAN_MS. Every third
+// channel gets a second mention that queues behind the first. The fake API records
+// each typing trigger and each post.
+//
+// There are no real users here, so the repeat-mention rate comes from a patience
+// model. A user waits an exponentially distributed time (mean PATIENCE_MS[]) before
+// mentioning the bot again. The wait only runs while nothing shows that an answer is
+// coming, so the user repeats with probability 1 - exp(-unattended / mean).
+// "Unattended" is the time from the mention to the answer, minus the time a typing
+// indicator was showing: 10 s after a trigger, or until the bot's next post in that
+// channel. Without typing (or with users who ignore it), the whole wait is
+// unattended. Run tests\build_tests.bat from a Visual Studio x64 Native Tools prompt;
+// exits non-zero if an answer never arrives.
+
+#include "MockDiscordGateway.h"
+#include <cstdio>
+#include <cmath>
+#include <map>
+#include <random>
+
+#pragma comment(lib, "user32.lib")
+
+bool g_debugMode = false; // Normally Main.cpp's; off so chat lines are not logged
+
+static const unsigned SEED = 50;
+static const int CHANNELS = 12;
+static const int SECOND_MENTION_EVERY = 3;  // These channels get a second mention...
+static const DWORD SECOND_MENTION_MS = 2000; // ...this long after the first
+static const double KINDROID_MEDIAN_MS = 4000;
+static const double KINDROID_SIGMA = 0.7;    // Of the log-normal; about 1.3 s to 12.5 s for 90%
+static const DWORD KINDROID_MAX_MS = 15000;
+static const DWORD TYPING_SHOWN_MS = 10000;  // How long Discord shows one trigger
+static const DWORD DISCORD_REST_MS = 80;     // Per Discord call, so a trigger lags its mention
+static const double PATIENCE_MS[] = { 5000, 10000, 20000 };
+static const DWORD DEADLINE_MS = 90000;
+static const wchar_t* KEY_CONTAINER = L"KinBotManagerTypingBench";
+
+static std::string gatewayPort;
+static ULONGLONG started;
+static std::vector<DWORD> kindroidMs; // Per question, channel * 2 + k
+
+// ============================================
+// Fake REST: Discord's API and Kindroid
+// ============================================
+
+struct ChannelLog {
+    ULONGLONG askedAt[2] = { 0, 0 };    // Mentions, ms since started
+    ULONGLONG answeredAt[2] = { 0, 0 }; // Their answers' posts
+    std::vector<ULONGLONG> typingAt;    // Typing triggers
+    std::vector<ULONGLONG> postedAt;    // Every post
+};
+
+static std::mutex seenMutex;
+static std::map<int, ChannelLog> channels;
+static int typingPosts = 0;
+static int messagePosts = 0;
+static int answers = 0;
+
+static ULONGLONG now() {
+    return GetTickCount64() - started;
+}
+
+static std::string channelId(int i) {
+    return std::to_string(7000 + i);
+}
+
+// "/api/v10/channels/<id>/..." -> channel index
+static int channelIndex(const std::string& path) {
+    return atoi(path.c_str() + 18) - 7000;
+}
+
+std::string HttpClient::request(const std::string& method, const std::string& host, const std::string& path,
+                                const std::string& headers, const std::string& body, DWORD* statusCode) {
+    if (statusCode) *statusCode = 200;
+
+    if (host == "discord.com") {
+        if (path == "/api/v10/gateway/bot") return mockGatewayBot(gatewayPort);
+        Sleep(DISCORD_REST_MS);
+
+        std::lock_guard<std::mutex> lock(seenMutex);
+        if (path.size() > 7 && path.compare(path.size() - 7, 7, "/typing") == 0) {
+            channels[channelIndex(path)].typingAt.push_back(now());
+            typingPosts++;
+            if (statusCode) *statusCode = 204;
+            return "";
+        }
+        if (path.size() > 9 && path.compare(path.size() - 9, 9, "/messages") == 0) {
+            // "re: ch<i> question <k>", possibly two merged into one post
+            ChannelLog& log = channels[channelIndex(path)];
+            std::string content = SimpleJSON::getString(SimpleJSON::parseObject(body), "content");
+            size_t at = 0;
+            while ((at = content.find(" question ", at)) != std::string::npos) {
+                log.answeredAt[content[at + 10] - '0'] = now();
+                answers++;
+                at += 10;
+            }
+            log.postedAt.push_back(now());
+            messagePosts++;
+            return "{\"id\":\"1\"}";
+        }
+        // Channel and guild lookups for the reply context
+        return path.find("/guilds/") != std::string::npos ? "{\"name\":\"Bench\"}"
+                                                          : "{\"name\":\"general\",\"guild_id\":\"9\"}";
+    }
+
+    // Kindroid: the text ends in "ch<i> question <k>"
+    std::string message = SimpleJSON::getString(SimpleJSON::parseObject(body), "message");
+    size_t question = message.rfind(" question ");
+    int i = atoi(message.c_str() + message.rfind(" ch", question) + 3);
+    int k = message[question + 10] - '0';
+    Sleep(kindroidMs[i * 2 + k]);
+
+    std::string response;
+    JsonWriter(response).beginObject().key("response_text").string("re: " + message.substr(message.rfind(" ch", question) + 1)).endObject();
+    return response;
+}
+
+void HttpClient::prewarm(const std::string& host) {
+}
+
+// ============================================
+// Mock gateway and the patience model
+// ============================================
+
+static void serveGateway(MockConnection* conn, bool* ready) {
+    if (!greetBot(*conn, gatewayPort)) return;
+    *ready = true;
+
+    for (int k = 0; k < 2; k++) {
+        for (int i = 0; i < CHANNELS; i++) {
+            if (k == 1 && i % SECOND_MENTION_EVERY != 0) continue;
+            {
+                std::lock_guard<std::mutex> lock(seenMutex);
+                channels[i].askedAt[k] = now();
+            }
+            sendDispatch(*conn, "MESSAGE_CREATE", messageBody(channelId(i), std::to_string(900000 + i * 2 + k),
+                                                              std::to_string(1000 + k), "ch" + std::to_string(i) +
+                                                              " question " + std::to_string(k), true));
+        }
+        if (k == 0) Sleep(SECOND_MENTION_MS);
+    }
+
+    answerHeartbeats(*conn);
+}
+
+// Time between from and to with no typing indicator showing in the channel
+static ULONGLONG unattendedMs(const ChannelLog& log, ULONGLONG from, ULONGLONG to) {
+    ULONGLONG unattended = 0;
+    ULONGLONG covered = from; // Everything before this is accounted for
+    for (ULONGLONG trigger : log.typingAt) {
+        ULONGLONG hidden = trigger + TYPING_SHOWN_MS;
+        for (ULONGLONG post : log.postedAt) {
+            if (post > trigger && post < hidden) hidden = post;
+        }
+        if (hidden <= covered || trigger >= to) continue;
+        if (trigger > covered) unattended += trigger - covered;
+        covered = hidden < to ? hidden : to;
+        if (covered >= to) break;
+    }
+    if (covered < to) unattended += to - covered;
+    return unattended;
+}
+
+int main() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("WSAStartup failed\n");
+        return 1;
+    }
+
+    PCCERT_CONTEXT cert = createCertificate(KEY_CONTAINER);
+    CredHandle credentials;
+    SOCKET listener = INVALID_SOCKET;
+    if (!cert || !acquireServerCredentials(cert, &credentials) ||
+        (listener = openLoopbackListener(1, gatewayPort)) == INVALID_SOCKET) {
+        printf("Could not set up the mock server (error %lu)\n", GetLastError());
+        if (cert) CertFreeCertificateContext(cert);
+        deleteKeyContainer(KEY_CONTAINER);
+        WSACleanup();
+        return 1;
+    }
+
+    std::mt19937 rng(SEED);
+    std::lognormal_distribution<double> latency(log(KINDROID_MEDIAN_MS), KINDROID_SIGMA);
+    int mentions = 0;
+    for (int i = 0; i < CHANNELS * 2; i++) {
+        double ms = latency(rng);
+        kindroidMs.push_back(ms > KINDROID_MAX_MS ? KINDROID_MAX_MS : (DWORD)ms);
+        if (i % 2 == 0 || (i / 2) % SECOND_MENTION_EVERY == 0) mentions++;
+    }
+
+    started = GetTickCount64();
+    KindroidAPI kindroid("bench-key", "bench-ai", "https://kindroid.invalid/v1");
+    DiscordBot* bot = new DiscordBot("bench-token", &kindroid, NULL);
+    bot->start();
+
+    int failures = 0;
+    bool ready = false;
+    MockConnection conn;
+    std::thread server;
+    if (conn.accept(listener, &credentials)) {
+        server = std::thread(serveGateway, &conn, &ready);
+    } else {
+        printf("TLS accept failed\n");
+        failures++;
+    }
+
+    while (failures == 0 && now() < DEADLINE_MS) {
+        {
+            std::lock_guard<std::mutex> lock(seenMutex);
+            if (answers >= mentions) break;
+        }
+        Sleep(50);
+    }
+
+    bot->stop();
+    if (server.joinable()) server.join();
+    delete bot;
+
+    if (failures == 0 && answers != mentions) {
+        printf("%d of %d mentions answered (bot %s)\n", answers, mentions, ready ? "identified" : "never identified");
+        failures++;
+    }
+
+    if (failures == 0) {
+        double waitMs = 0, withoutMs = 0, withMs = 0;
+        double repeatWithout[3] = { 0, 0, 0 }, repeatWith[3] = { 0, 0, 0 };
+        for (auto& entry : channels) {
+            const ChannelLog& log = entry.second;
+            for (int k = 0; k < 2; k++) {
+                if (log.answeredAt[k] == 0) continue;
+                double wait = (double)(log.answeredAt[k] - log.askedAt[k]);
+                double unattended = (double)unattendedMs(log, log.askedAt[k], log.answeredAt[k]);
+                waitMs += wait;
+                withoutMs += wait;
+                withMs += unattended;
+                for (int p = 0; p < 3; p++) {
+                    repeatWithout[p] += 1 - exp(-wait / PATIENCE_MS[p]);
+                    repeatWith[p] += 1 - exp(-unattended / PATIENCE_MS[p]);
+                }
+            }
+        }
+
+        printf("%d mentions in %d channels, mean wait for an answer %.1f s\n", mentions, CHANNELS,
+               waitMs / mentions / 1000);
+        printf("mean unattended wait: %.2f s without typing, %.2f s with typing\n", withoutMs / mentions / 1000,
+               withMs / mentions / 1000);
+        printf("repeat-mention rate (patience model):\n");
+        for (int p = 0; p < 3; p++) {
+            printf("  mean patience %2.0f s: %5.1f%% without typing (or ignored), %5.1f%% with typing as feedback\n",
+                   PATIENCE_MS[p] / 1000, repeatWithout[p] * 100 / mentions, repeatWith[p] * 100 / mentions);
+        }
+        printf("REST: %d message posts, %d typing triggers (%.2f per answer)\n", messagePosts, typingPosts,
+               (double)typingPosts / mentions);
+    }
+
+    closesocket(listener);
+    FreeCredentialsHandle(&credentials);
+    CertFreeCertificateContext(cert);
+    deleteKeyContainer(KEY_CONTAINER);
+    WSACleanup();
+
+    printf("BenchDiscordTyping: %d failure(s), %d of %d mentions answered\n", failures, answers, mentions);
+    return failures == 0 ? 0 : 1;
+}
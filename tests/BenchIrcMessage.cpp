@@ -0,0 +1,163 @@
+// Check and benchmark for IrcMessage (IrcMessage.cpp), the Twitch line parser.
+// First parses hand-written lines (tags with escapes, no tags, PING, numerics, a
+// line with no trailing parameter) and compares every field. Then builds CHAT_LINES
+// fully tagged PRIVMSG lines like Twitch sends, checks that the parser finds the
+// same sender, channel and text as the find/substr code it replaced, and times both
+// paths, mention check included. Run tests\build_tests.bat from a Visual Studio x64
+// Native Tools prompt; exits non-zero on any failed check.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+static const unsigned SEED = 42;
+static const int CHAT_LINES = 200000;
+static const char* BOT = "kinbot";
+
+// The PRIVMSG handling TwitchBot::handleMessage had before IrcMessage
+static bool oldParse(const std::string& line, std::string& sender, std::string& channel, std::string& content) {
+    size_t privmsgPos = line.find("PRIVMSG");
+    if (privmsgPos == std::string::npos) return false;
+
+    size_t userStart = line.find(':');
+    if (userStart != std::string::npos) {
+        if (line[0] == '@') userStart = line.find(':', line.find(' '));
+        if (userStart != std::string::npos) {
+            size_t userEnd = line.find('!', userStart);
+            if (userEnd != std::string::npos) sender = line.substr(userStart + 1, userEnd - userStart - 1);
+        }
+    }
+    size_t chanStart = line.find('#', privmsgPos);
+    if (chanStart == std::string::npos) return false;
+    size_t chanEnd = line.find(' ', chanStart);
+    if (chanEnd == std::string::npos) return false;
+    channel = line.substr(chanStart + 1, chanEnd - chanStart - 1);
+    size_t msgStart = line.find(':', chanEnd);
+    if (msgStart == std::string::npos) return false;
+    content = line.substr(msgStart + 1);
+    return true;
+}
+
+static bool oldMentioned(const std::string& sender, const std::string& content) {
+    std::string senderLower = sender;
+    std::transform(senderLower.begin(), senderLower.end(), senderLower.begin(), ::tolower);
+    if (senderLower == BOT) return false;
+    std::string contentLower = content;
+    std::transform(contentLower.begin(), contentLower.end(), contentLower.begin(), ::tolower);
+    return contentLower.find(std::string("@") + BOT) != std::string::npos;
+}
+
+struct Expected {
+    const char* line;
+    const char* command;
+    const char* prefix;
+    int paramCount;
+    const char* lastParam;
+    const char* tagKey;   // Looked up with tag(); NULL for none
+    const char* tagValue; // Unescaped
+};
+
+static const Expected LINES[] = {
+    { "@badge-info=;badges=moderator/1;display-name=Some\\sOne;user-id=12 :someone!someone@someone.tmi.twitch.tv "
+      "PRIVMSG #chan :hello @KinBot: how are you?", "PRIVMSG", "someone!someone@someone.tmi.twitch.tv", 2,
+      "hello @KinBot: how are you?", "display-name", "Some One" },
+    { ":someone!someone@someone.tmi.twitch.tv PRIVMSG #chan :no tags here", "PRIVMSG",
+      "someone!someone@someone.tmi.twitch.tv", 2, "no tags here", NULL, NULL },
+    { "PING :tmi.twitch.tv", "PING", "", 1, "tmi.twitch.tv", NULL, NULL },
+    { ":tmi.twitch.tv 001 kinbot :Welcome, GLHF!", "001", "tmi.twitch.tv", 2, "Welcome, GLHF!", NULL, NULL },
+    { "@a=x\\:y\\\\z\\r\\n;b :tmi.twitch.tv CLEARMSG #chan :gone", "CLEARMSG", "tmi.twitch.tv", 2, "gone", "a",
+      "x;y\\z\r\n" },
+    { "@emote-only=1 :tmi.twitch.tv ROOMSTATE #chan", "ROOMSTATE", "tmi.twitch.tv", 1, "#chan", "emote-only", "1" },
+    { ":kinbot!kinbot@kinbot.tmi.twitch.tv JOIN #chan", "JOIN", "kinbot!kinbot@kinbot.tmi.twitch.tv", 1, "#chan",
+      "missing", "" },
+};
+
+static int checkLines() {
+    int failures = 0;
+    for (const auto& e : LINES) {
+        IrcMessage msg;
+        bool ok = msg.parse(e.line) && msg.command == e.command && msg.prefix == e.prefix &&
+                  msg.paramCount == e.paramCount && msg.param(e.paramCount - 1) == e.lastParam &&
+                  (!e.tagKey || msg.tag(e.tagKey) == e.tagValue);
+        if (!ok) {
+            printf("\"%s\": command \"%.*s\", prefix \"%.*s\", %d param(s), last \"%.*s\"\n", e.line,
+                   (int)msg.command.size(), msg.command.data(), (int)msg.prefix.size(), msg.prefix.data(),
+                   msg.paramCount, (int)msg.param(msg.paramCount - 1).size(), msg.param(msg.paramCount - 1).data());
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main() {
+    std::mt19937 rng(SEED);
+    int failures = checkLines();
+
+    // Tagged PRIVMSGs as Twitch sends them; every 12th word or so is a mention
+    const char* words[] = { "PogChamp", "lol", "hello", "what", "is", "this", "stream", "KEKW",
+                            "gg", "nice", "play", "@KinBot" };
+    std::vector<std::string> lines;
+    for (int i = 0; i < CHAT_LINES; i++) {
+        std::string user = "user" + std::to_string(rng() % 5000);
+        std::string line = "@badge-info=subscriber/8;badges=subscriber/6,bits/100;color=#1E90FF;display-name=User\\s" +
+                           std::to_string(i % 50) + ";emotes=25:0-4;first-msg=0;flags=;"
+                           "id=b34ccfc7-4977-403a-8a94-33c6bac34fb8;mod=0;returning-chatter=0;room-id=1337;"
+                           "subscriber=1;tmi-sent-ts=1642696567751;turbo=0;user-id=" + std::to_string(100000 + i) +
+                           ";user-type= :" + user + "!" + user + "@" + user + ".tmi.twitch.tv PRIVMSG #somechannel :";
+        int count = 3 + rng() % 15;
+        for (int w = 0; w < count; w++) {
+            line += words[rng() % (w == count - 1 ? 12 : 11)];
+            line += ' ';
+        }
+        lines.push_back(line);
+    }
+
+    MentionMatcher mentions;
+    mentions.addName(BOT);
+
+    // Same fields from both paths
+    for (const auto& line : lines) {
+        std::string sender, channel, content;
+        IrcMessage msg;
+        if (!oldParse(line, sender, channel, content) || !msg.parse(line) || msg.nick() != sender ||
+            msg.param(0) != "#" + channel || msg.param(1) != content) {
+            if (failures < 5) printf("fields differ: %s\n", line.c_str());
+            failures++;
+        }
+    }
+
+    double bestOld = 0, bestNew = 0;
+    int oldHits = 0, newHits = 0;
+    for (int trial = 0; trial < 3; trial++) {
+        oldHits = 0;
+        newHits = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& line : lines) {
+            std::string sender, channel, content;
+            if (oldParse(line, sender, channel, content)) oldHits += oldMentioned(sender, content);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (const auto& line : lines) {
+            IrcMessage msg;
+            if (!msg.parse(line) || msg.command != "PRIVMSG" || msg.paramCount < 2) continue;
+            if (msg.nick() == BOT) continue;
+            newHits += mentions.matches(msg.param(1));
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        double oldRate = lines.size() / std::chrono::duration<double>(t1 - t0).count();
+        double newRate = lines.size() / std::chrono::duration<double>(t2 - t1).count();
+        if (oldRate > bestOld) bestOld = oldRate;
+        if (newRate > bestNew) bestNew = newRate;
+    }
+    printf("%zu tagged PRIVMSG lines: find/substr %.2fM lines/s, IrcMessage + MentionMatcher %.2fM lines/s\n",
+           lines.size(), bestOld / 1e6, bestNew / 1e6);
+    if (oldHits != newHits) {
+        printf("mention counts differ: find/substr %d, IrcMessage %d\n", oldHits, newHits);
+        failures++;
+    }
+
+    printf("BenchIrcMessage: %d failure(s) in %zu lines\n", failures, lines.size() + sizeof(LINES) / sizeof(LINES[0]));
+    return failures == 0 ? 0 : 1;
+}
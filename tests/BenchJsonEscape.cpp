@@ -0,0 +1,119 @@
+// Check and benchmark for SimpleJSON::escape / unescape (Utils.cpp).
+// First compares escape against a byte-at-a-time reference, and checks that
+// unescape undoes it, on random strings whose special bytes land at every offset
+// of the 16- and 32-byte blocks. Then reports ns/byte for chat-sized and
+// history-sized text. BenchJsonEscapeSse2 is the same program built without the
+// AVX2 path, for comparison on the same machine. Run tests\build_tests.bat from a
+// Visual Studio x64 Native Tools prompt; exits non-zero on any mismatch.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+static const unsigned SEED = 37;
+static const int ITERATIONS = 100000;
+
+static std::string referenceEscape(const std::string& s) {
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string out;
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out += hexDigits[c >> 4];
+                    out += hexDigits[c & 0xF];
+                } else {
+                    out += (char)c;
+                }
+        }
+    }
+    return out;
+}
+
+// Mostly plain text (ASCII and UTF-8) with an occasional byte that needs escaping
+static std::string randomText(std::mt19937& rng) {
+    const char* plain[] = { "a", "Z", " ", "lol", "\xC3\xA9", "\xF0\x9F\x98\x80", "\x7F", "~" };
+    const char* special[] = { "\"", "\\", "\n", "\t", "\x01", "\x1F", "\r", "\b" };
+    std::string s;
+    int len = rng() % 600;
+    int specialEvery = 1 + rng() % 400; // Up to long clean runs, for the AVX2 loop
+    for (int k = 0; k < len; k++) {
+        s += rng() % specialEvery == 0 ? special[rng() % 8] : plain[rng() % 8];
+    }
+    return s;
+}
+
+// Best of a few trials, so a busy machine skews the numbers less
+template <typename F>
+static double nsPerByte(F f, const std::string& input, int repeats) {
+    double best = 0;
+    size_t sink = 0;
+    for (int trial = 0; trial < 5; trial++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) sink += f(input).size();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (trial == 0 || ns < best) best = ns;
+    }
+    if (sink == 0 && !input.empty()) printf("(empty output)\n");
+    return best / repeats / input.size();
+}
+
+int main() {
+    std::mt19937 rng(SEED);
+    int failures = 0;
+
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        std::string text = randomText(rng);
+        std::string escaped = SimpleJSON::escape(text);
+        if (escaped != referenceEscape(text)) {
+            if (failures < 5) printf("iteration %d: escape differs from the reference (%zu bytes)\n", iter, text.size());
+            failures++;
+        } else if (SimpleJSON::unescape(escaped) != text) {
+            if (failures < 5) printf("iteration %d: unescape(escape(s)) != s (%zu bytes)\n", iter, text.size());
+            failures++;
+        }
+    }
+
+#ifdef SIMPLEJSON_NO_AVX2
+    const char* build = "SSE2 only";
+#else
+    const char* build = "AVX2 when the CPU has it";
+#endif
+    printf("JSON escape (%s):\n", build);
+
+    std::string line = "Hey there, how is the stream going today? Did you see that \"clip\"? lol\n";
+    std::string emoji = "\xF0\x9F\x98\x80\xF0\x9F\x8E\x89 nice \xE2\x9C\xA8 ";
+    struct Case {
+        const char* name;
+        std::string text;
+    } cases[] = {
+        { "one chat line", line },
+        { "short reply", std::string(line) + line + line },
+        { "long reply", std::string() },
+        { "history (9 KB)", std::string() },
+        { "emoji (9 KB)", std::string() },
+    };
+    while (cases[2].text.size() < 2000) cases[2].text += line;
+    while (cases[3].text.size() < 9000) cases[3].text += line;
+    while (cases[4].text.size() < 9000) cases[4].text += emoji;
+
+    for (const auto& c : cases) {
+        std::string escaped = SimpleJSON::escape(c.text);
+        int repeats = (int)(4000000 / c.text.size());
+        double escapeNs = nsPerByte([](const std::string& s) { return SimpleJSON::escape(s); }, c.text, repeats);
+        double unescapeNs = nsPerByte([](const std::string& s) { return SimpleJSON::unescape(s); }, escaped, repeats);
+        printf("  %-15s %5zu B: escape %.3f ns/B, unescape %.3f ns/B\n", c.name, c.text.size(), escapeNs, unescapeNs);
+    }
+
+    printf("BenchJsonEscape: %d failure(s) in %d strings\n", failures, ITERATIONS);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,5 @@
+// BenchJsonEscape against Utils.cpp built without its AVX2 path: the SSE2-only
+// baseline on the same machine. build_tests.bat passes /DSIMPLEJSON_NO_AVX2,
+// which applies to both files.
+
+#include "BenchJsonEscape.cpp"
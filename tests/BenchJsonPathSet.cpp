@@ -0,0 +1,294 @@
+// Check and benchmark for JsonPathSet (KindroidBot.h) on MESSAGE_CREATE frames.
+// Two frames of about 2.5 KB as Discord sends them: a plain message, and a reply
+// whose referenced_message (with its own author and content) comes before the
+// message's own fields and whose content ends in a backslash. The fields the bot
+// reads are pulled out three ways:
+//   - the find() scans the handler used before JsonPathSet (content, username and
+//     channel only);
+//   - MESSAGE_FIELDS-style extract() and text(), as the handler does now;
+//   - a general DOM parse of the whole frame, then lookups.
+// extract() and the DOM must find the right value for every field; the old scans'
+// wrong fields are reported, not failed. Then times each path. Run
+// tests\build_tests.bat from a Visual Studio x64 Native Tools prompt; exits
+// non-zero on any failed check.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <chrono>
+
+static const int REPEATS = 100000;
+
+enum Field { F_CONTENT, F_USERNAME, F_AUTHOR_ID, F_CHANNEL_ID, F_GUILD_ID, F_ID, FIELD_COUNT };
+static const char* FIELD_NAMES[FIELD_COUNT] = { "content", "username", "author id", "channel", "guild", "id" };
+
+static constexpr JsonPathSet<FIELD_COUNT> FIELDS({
+    "d.content", "d.author.username", "d.author.id", "d.channel_id", "d.guild_id", "d.id"
+});
+
+struct Fields {
+    std::string value[FIELD_COUNT];
+};
+
+// ============================================
+// The three extraction paths
+// ============================================
+
+// DiscordBot::handleGatewayMessage's MESSAGE_CREATE scans before JsonPathSet
+static void oldExtract(const std::string& message, Fields& out) {
+    size_t contentPos = message.find("\"content\":\"");
+    if (contentPos != std::string::npos) {
+        size_t start = contentPos + 11;
+        size_t end = message.find('"', start);
+        while (end != std::string::npos && end > 0 && message[end - 1] == '\\') {
+            end = message.find('"', end + 1);
+        }
+        out.value[F_CONTENT] = SimpleJSON::unescape(message.substr(start, end - start));
+    }
+
+    out.value[F_USERNAME] = "unknown";
+    size_t userPos = message.find("\"author\":");
+    if (userPos != std::string::npos) {
+        size_t unamePos = message.find("\"username\":\"", userPos);
+        if (unamePos != std::string::npos) {
+            size_t start = unamePos + 12;
+            size_t end = message.find('"', start);
+            out.value[F_USERNAME] = message.substr(start, end - start);
+        }
+    }
+
+    size_t chanPos = message.find("\"channel_id\":\"");
+    if (chanPos != std::string::npos) {
+        size_t start = chanPos + 14;
+        size_t end = message.find('"', start);
+        out.value[F_CHANNEL_ID] = message.substr(start, end - start);
+    }
+}
+
+static void pathSetExtract(const std::string& message, Fields& out) {
+    JsonSpan spans[FIELD_COUNT];
+    FIELDS.extract(message, spans);
+    for (int i = 0; i < FIELD_COUNT; i++) out.value[i] = spans[i].text(message);
+}
+
+// A general-purpose DOM: every value parsed, strings unescaped, members kept in order
+struct JsonNode {
+    enum Type { SCALAR, STRING, ARRAY, OBJECT } type = SCALAR;
+    std::string text; // Unescaped for strings, verbatim for numbers, true, false, null
+    std::vector<std::pair<std::string, JsonNode>> members;
+    std::vector<JsonNode> items;
+
+    const JsonNode* get(const char* key) const {
+        for (const auto& member : members) {
+            if (member.first == key) return &member.second;
+        }
+        return nullptr;
+    }
+};
+
+static size_t skipSpace(const std::string& json, size_t pos) {
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\n' || json[pos] == '\r' || json[pos] == '\t')) pos++;
+    return pos;
+}
+
+static bool parseString(const std::string& json, size_t& pos, std::string& out) {
+    size_t start = ++pos;
+    while (pos < json.size() && json[pos] != '"') pos += json[pos] == '\\' ? 2 : 1;
+    if (pos >= json.size()) return false;
+    out = SimpleJSON::unescape(json.substr(start, pos - start));
+    pos++;
+    return true;
+}
+
+static bool parseNode(const std::string& json, size_t& pos, JsonNode& node) {
+    pos = skipSpace(json, pos);
+    if (pos >= json.size()) return false;
+    char c = json[pos];
+    if (c == '"') {
+        node.type = JsonNode::STRING;
+        return parseString(json, pos, node.text);
+    }
+    if (c == '{' || c == '[') {
+        bool object = c == '{';
+        node.type = object ? JsonNode::OBJECT : JsonNode::ARRAY;
+        pos = skipSpace(json, pos + 1);
+        if (pos < json.size() && json[pos] == (object ? '}' : ']')) {
+            pos++;
+            return true;
+        }
+        while (true) {
+            if (object) {
+                pos = skipSpace(json, pos);
+                std::pair<std::string, JsonNode> member;
+                if (pos >= json.size() || json[pos] != '"' || !parseString(json, pos, member.first)) return false;
+                pos = skipSpace(json, pos);
+                if (pos >= json.size() || json[pos] != ':') return false;
+                pos++;
+                if (!parseNode(json, pos, member.second)) return false;
+                node.members.push_back(std::move(member));
+            } else {
+                node.items.emplace_back();
+                if (!parseNode(json, pos, node.items.back())) return false;
+            }
+            pos = skipSpace(json, pos);
+            if (pos >= json.size()) return false;
+            if (json[pos] == ',') { pos++; continue; }
+            if (json[pos] != (object ? '}' : ']')) return false;
+            pos++;
+            return true;
+        }
+    }
+    size_t start = pos;
+    while (pos < json.size() && json[pos] != ',' && json[pos] != '}' && json[pos] != ']' && json[pos] != ' ') pos++;
+    node.text = json.substr(start, pos - start);
+    return true;
+}
+
+static void domExtract(const std::string& message, Fields& out) {
+    JsonNode root;
+    size_t pos = 0;
+    if (!parseNode(message, pos, root)) return;
+    const JsonNode* d = root.get("d");
+    if (!d) return;
+    const JsonNode* author = d->get("author");
+    const JsonNode* found[FIELD_COUNT] = {
+        d->get("content"), author ? author->get("username") : nullptr, author ? author->get("id") : nullptr,
+        d->get("channel_id"), d->get("guild_id"), d->get("id"),
+    };
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (found[i] && found[i]->type == JsonNode::STRING) out.value[i] = found[i]->text;
+    }
+}
+
+// ============================================
+// Frames
+// ============================================
+
+static std::string userJson(const std::string& id, const std::string& name) {
+    return "{\"username\":\"" + name + "\",\"public_flags\":0,\"id\":\"" + id + "\",\"global_name\":\"" + name +
+           "\",\"discriminator\":\"0\",\"clan\":null,\"avatar_decoration_data\":null,"
+           "\"avatar\":\"a1b2c3d4e5f60718293a4b5c6d7e8f90\"}";
+}
+
+static std::string messageJson(const std::string& id, const std::string& content, const std::string& author,
+                               const std::string& referenced) {
+    std::string json = "{\"type\":" + std::string(referenced.empty() ? "0" : "19") + ",\"tts\":false,"
+                       "\"timestamp\":\"2024-05-01T12:34:56.789000+00:00\",";
+    if (!referenced.empty()) {
+        json += "\"referenced_message\":" + referenced + ","
+                "\"message_reference\":{\"type\":0,\"message_id\":\"1235000000000000001\","
+                "\"guild_id\":\"987650000000000000\",\"channel_id\":\"1111111111111111111\"},";
+    }
+    json += "\"pinned\":false,\"nonce\":\"1235000000000000777\","
+            "\"mentions\":[" + userJson("555000000000000000", "KinBot") + "],"
+            "\"mention_roles\":[],\"mention_everyone\":false,"
+            "\"member\":{\"roles\":[\"1000000000000000001\",\"1000000000000000002\"],\"premium_since\":null,"
+            "\"pending\":false,\"nick\":null,\"mute\":false,\"joined_at\":\"2023-01-01T00:00:00.000000+00:00\","
+            "\"flags\":0,\"deaf\":false,\"communication_disabled_until\":null,\"avatar\":null},"
+            "\"id\":\"" + id + "\",\"flags\":0,"
+            "\"embeds\":[{\"type\":\"rich\",\"title\":\"Patch notes\",\"description\":\"Version 1.2 brings "
+            "\\\"faster\\\" replies, fewer reconnects and a typing indicator while the bot thinks.\","
+            "\"color\":5814783,\"fields\":[{\"name\":\"content\",\"value\":\"not this one\",\"inline\":true}]}],"
+            "\"edited_timestamp\":null,\"content\":\"" + content + "\",\"components\":[],"
+            "\"channel_id\":\"1111111111111111111\",\"author\":" + author + ",\"attachments\":[],"
+            "\"guild_id\":\"987650000000000000\"}";
+    return json;
+}
+
+struct Frame {
+    const char* name;
+    std::string json;
+    Fields expected;
+};
+
+static Frame makeFrame(const char* name, bool reply) {
+    Frame frame;
+    frame.name = name;
+    std::string referenced;
+    if (reply) {
+        // Someone else's earlier message, with its own author and content, before ours
+        referenced = messageJson("1235000000000000001", "what do you all think of the new patch?",
+                                 userJson("777000000000000000", "earlier_poster"), "");
+    }
+    std::string content = "<@555000000000000000> they said \\\"it's fine\\\", see C:\\\\Games\\\\";
+    frame.json = "{\"t\":\"MESSAGE_CREATE\",\"s\":4242,\"op\":0,\"d\":" +
+                 messageJson("1235000000000000099", content, userJson("888000000000000000", "replier"), referenced) +
+                 "}";
+    frame.expected.value[F_CONTENT] = "<@555000000000000000> they said \"it's fine\", see C:\\Games\\";
+    frame.expected.value[F_USERNAME] = "replier";
+    frame.expected.value[F_AUTHOR_ID] = "888000000000000000";
+    frame.expected.value[F_CHANNEL_ID] = "1111111111111111111";
+    frame.expected.value[F_GUILD_ID] = "987650000000000000";
+    frame.expected.value[F_ID] = "1235000000000000099";
+    return frame;
+}
+
+// ============================================
+// Benchmark
+// ============================================
+
+static std::string wrongFields(const Fields& got, const Fields& expected) {
+    std::string wrong;
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (got.value[i] == expected.value[i]) continue;
+        if (!wrong.empty()) wrong += ", ";
+        wrong += FIELD_NAMES[i];
+    }
+    return wrong;
+}
+
+static double timePath(const std::string& json, void (*extract)(const std::string&, Fields&), size_t& sink) {
+    double best = 1e18;
+    for (int trial = 0; trial < 3; trial++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < REPEATS; i++) {
+            Fields fields;
+            extract(json, fields);
+            sink += fields.value[F_CONTENT].size();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (ns / REPEATS < best) best = ns / REPEATS;
+    }
+    return best;
+}
+
+int main() {
+    Frame frames[] = { makeFrame("plain message", false), makeFrame("reply", true) };
+    int failures = 0;
+    size_t sink = 0;
+
+    for (const auto& frame : frames) {
+        Fields oldFields, newFields, domFields;
+        oldExtract(frame.json, oldFields);
+        pathSetExtract(frame.json, newFields);
+        domExtract(frame.json, domFields);
+
+        std::string newWrong = wrongFields(newFields, frame.expected);
+        std::string domWrong = wrongFields(domFields, frame.expected);
+        if (!newWrong.empty()) {
+            printf("%s: extract() got %s wrong\n", frame.name, newWrong.c_str());
+            failures++;
+        }
+        if (!domWrong.empty()) {
+            printf("%s: the DOM got %s wrong\n", frame.name, domWrong.c_str());
+            failures++;
+        }
+        // The old scans read content, username and channel only
+        std::string oldWrong;
+        for (int i : { F_CONTENT, F_USERNAME, F_CHANNEL_ID }) {
+            if (oldFields.value[i] == frame.expected.value[i]) continue;
+            if (!oldWrong.empty()) oldWrong += ", ";
+            oldWrong += FIELD_NAMES[i];
+        }
+
+        double oldNs = timePath(frame.json, oldExtract, sink);
+        double newNs = timePath(frame.json, pathSetExtract, sink);
+        double domNs = timePath(frame.json, domExtract, sink);
+        printf("%-13s %4zu B: find scans %5.0f ns (3 fields, wrong: %s); extract() %5.0f ns (6 fields); "
+               "DOM %6.0f ns (6 fields)\n", frame.name, frame.json.size(), oldNs,
+               oldWrong.empty() ? "none" : oldWrong.c_str(), newNs, domNs);
+    }
+    if (sink == 0) failures++;
+
+    printf("BenchJsonPathSet: %d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+// Before/after benchmark for JsonWriter (Utils.cpp) on the payloads the bots send.
+// Each payload is built the way the code before JsonWriter did it (operator+ on
+// temporaries, or a std::map through buildObject) and the way it is built now,
+// with the buffer kept between calls where the bot keeps it (heartbeats and
+// Discord posts) and a fresh string where it does not (IDENTIFY, the Kindroid
+// body). Both must produce the same bytes. Reports heap allocations and ns per
+// payload, and fails if a kept buffer still allocates once warm. Run
+// tests\build_tests.bat from a Visual Studio x64 Native Tools prompt; exits
+// non-zero on any failed check.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <chrono>
+#include <new>
+
+static const int REPEATS = 200000;
+
+// ============================================
+// Allocation counting
+// ============================================
+
+static thread_local size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+// ============================================
+// The payloads, before and after
+// ============================================
+
+struct Inputs {
+    std::string token = "MTIzNDU2Nzg5MDEyMzQ1Njc4.GaBcDe.abcdefghijklmnopqrstuvwxyz0123456789AB";
+    int seq = 1234567;
+    int shardId = 3;
+    int shardCount = 8;
+    std::string reply;
+    std::string aiId = "aBcDeFgHiJkLmNoPqRsT";
+    std::string fullMessage;
+};
+
+// SimpleJSON::buildObject before JsonWriter
+static std::string oldBuildObject(const std::map<std::string, std::string>& obj) {
+    std::string result = "{";
+    bool first = true;
+    for (const auto& pair : obj) {
+        if (!first) result += ",";
+        result += "\"" + pair.first + "\":\"" + SimpleJSON::escape(pair.second) + "\"";
+        first = false;
+    }
+    result += "}";
+    return result;
+}
+
+static std::string oldHeartbeat(const Inputs& in) {
+    std::string hb = "{\"op\":1,\"d\":";
+    hb += (in.seq > 0) ? std::to_string(in.seq) : "null";
+    hb += "}";
+    return hb;
+}
+
+static void newHeartbeat(const Inputs& in, std::string& hb) {
+    hb.clear();
+    JsonWriter writer(hb);
+    writer.beginObject().key("op").number(1).key("d");
+    if (in.seq > 0) writer.number(in.seq); else writer.null();
+    writer.endObject();
+}
+
+static std::string oldIdentify(const Inputs& in) {
+    std::string identify = "{\"op\":2,\"d\":{";
+    identify += "\"token\":\"" + in.token + "\",";
+    identify += "\"intents\":33281,";
+    identify += "\"shard\":[" + std::to_string(in.shardId) + "," + std::to_string(in.shardCount) + "],";
+    identify += "\"properties\":{";
+    identify += "\"os\":\"windows\",";
+    identify += "\"browser\":\"kindroid_bot\",";
+    identify += "\"device\":\"kindroid_bot\"";
+    identify += "}}}";
+    return identify;
+}
+
+static void newIdentify(const Inputs& in, std::string& identify) {
+    identify.clear();
+    identify.reserve(256 + in.token.size());
+    JsonWriter writer(identify);
+    writer.beginObject().key("op").number(2).key("d").beginObject();
+    writer.key("token").string(in.token);
+    writer.key("intents").number(33281);
+    writer.key("shard").beginArray().number(in.shardId).number(in.shardCount).endArray();
+    writer.key("properties").beginObject();
+    writer.key("os").string("windows");
+    writer.key("browser").string("kindroid_bot");
+    writer.key("device").string("kindroid_bot");
+    writer.endObject().endObject().endObject();
+}
+
+static std::string oldPost(const Inputs& in) {
+    std::map<std::string, std::string> payload;
+    payload["content"] = in.reply;
+    return oldBuildObject(payload);
+}
+
+static void newPost(const Inputs& in, std::string& jsonPayload) {
+    jsonPayload.clear();
+    JsonWriter(jsonPayload).beginObject().key("content").string(in.reply).endObject();
+}
+
+static std::string oldKindroidBody(const Inputs& in) {
+    std::map<std::string, std::string> body;
+    body["ai_id"] = in.aiId;
+    body["message"] = in.fullMessage;
+    return oldBuildObject(body);
+}
+
+static void newKindroidBody(const Inputs& in, std::string& jsonBody) {
+    jsonBody.clear();
+    jsonBody.reserve(64 + in.aiId.size() + in.fullMessage.size() + in.fullMessage.size() / 8);
+    JsonWriter(jsonBody).beginObject()
+        .key("ai_id").string(in.aiId)
+        .key("message").string(in.fullMessage)
+        .endObject();
+}
+
+// ============================================
+// Benchmark
+// ============================================
+
+struct Result {
+    double allocs;
+    double ns;
+};
+
+template <typename Build>
+static Result measure(Build build) {
+    Result best = { 0, 1e18 };
+    for (int trial = 0; trial < 3; trial++) {
+        size_t before = allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < REPEATS; i++) build();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best.allocs = (double)(allocations - before) / REPEATS;
+        if (ns / REPEATS < best.ns) best.ns = ns / REPEATS;
+    }
+    return best;
+}
+
+int main() {
+    Inputs in;
+    in.reply = "Oh, that's a \"great\" question!\nLet me think... \xF0\x9F\xA4\x94 ";
+    while (in.reply.size() < 300) in.reply += "Honestly, I'd say it depends on the day. ";
+    in.fullMessage = "<Message to you from viewer42 in channel #somechannel> hey @KinBot, what do you "
+                     "think about \"pineapple\" on pizza?";
+
+    struct Case {
+        const char* name;
+        std::string (*oldBuild)(const Inputs&);
+        void (*newBuild)(const Inputs&, std::string&);
+        bool keptBuffer; // The bot reuses this buffer between calls
+    } cases[] = {
+        { "heartbeat", oldHeartbeat, newHeartbeat, true },
+        { "Discord post", oldPost, newPost, true },
+        { "IDENTIFY", oldIdentify, newIdentify, false },
+        { "Kindroid body", oldKindroidBody, newKindroidBody, false },
+    };
+
+    int failures = 0;
+    printf("%d payloads each, old builder against JsonWriter:\n", REPEATS);
+    for (const auto& c : cases) {
+        std::string buffer;
+        c.newBuild(in, buffer);
+        std::string expected = c.oldBuild(in);
+        if (buffer != expected) {
+            printf("  %s: JsonWriter wrote %s\n    expected %s\n", c.name, buffer.c_str(), expected.c_str());
+            failures++;
+            continue;
+        }
+
+        size_t sink = 0;
+        Result oldResult = measure([&]() { sink += c.oldBuild(in).size(); });
+        Result newResult = measure([&]() {
+            if (c.keptBuffer) {
+                c.newBuild(in, buffer);
+                sink += buffer.size();
+            } else {
+                std::string fresh;
+                c.newBuild(in, fresh);
+                sink += fresh.size();
+            }
+        });
+        printf("  %-13s %4zu B: old %4.1f allocs, %5.0f ns; JsonWriter %4.1f allocs, %5.0f ns (%s)\n", c.name,
+               expected.size(), oldResult.allocs, oldResult.ns, newResult.allocs, newResult.ns,
+               c.keptBuffer ? "kept buffer" : "fresh string");
+        if (c.keptBuffer && newResult.allocs != 0) {
+            printf("  %s: a warm buffer still allocated %.2f times per payload\n", c.name, newResult.allocs);
+            failures++;
+        }
+        if (sink == 0) failures++;
+    }
+
+    printf("BenchJsonWriter: %d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
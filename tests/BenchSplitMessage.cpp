@@ -0,0 +1,165 @@
+// Benchmark for splitMessage (MessageSplitter.cpp) on long multilingual replies.
+// Builds REPLIES replies of 1 to 12 KB from English, German, Russian, Japanese,
+// Arabic and emoji sentences, some with code blocks, and splits each one:
+//   - for Twitch (450), with the byte-based substr loop sendChatMessage used
+//     before and with splitMessage: ns per reply, and chunks that cut a UTF-8
+//     character in two;
+//   - for Discord (2000, markdown), where the old code posted the reply whole: how
+//     many replies Discord would have refused, and splitMessage's ns per reply.
+// Every splitMessage chunk must be valid UTF-8 within the limit, and every Discord
+// chunk must close the code blocks it opens. Run tests\build_tests.bat from a
+// Visual Studio x64 Native Tools prompt; exits non-zero on any failed check.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <cctype>
+#include <chrono>
+#include <random>
+
+static const unsigned SEED = 36;
+static const int REPLIES = 2000;
+static const size_t TWITCH_MAX = 450;
+static const size_t DISCORD_MAX = 2000;
+
+static bool validUtf8(const std::string& s) {
+    size_t i = 0;
+    while (i < s.size()) {
+        unsigned char c = s[i];
+        size_t len = c < 0x80 ? 1 : (c >> 5) == 6 ? 2 : (c >> 4) == 14 ? 3 : (c >> 3) == 30 ? 4 : 0;
+        if (len == 0 || i + len > s.size()) return false;
+        for (size_t k = 1; k < len; k++) {
+            if ((s[i + k] & 0xC0) != 0x80) return false;
+        }
+        i += len;
+    }
+    return true;
+}
+
+static std::string stripSpace(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (!isspace((unsigned char)c)) out += c;
+    }
+    return out;
+}
+
+static int countFences(const std::string& s) {
+    int count = 0;
+    size_t pos = 0;
+    while ((pos = s.find("```", pos)) != std::string::npos) {
+        count++;
+        pos += 3;
+    }
+    return count;
+}
+
+// TwitchBot::sendChatMessage before splitMessage, minus the sending
+static std::vector<std::string> oldSplit(const std::string& message) {
+    std::vector<std::string> chunks;
+    std::string remaining = message;
+    while (!remaining.empty()) {
+        std::string chunk;
+        if (remaining.length() <= TWITCH_MAX) {
+            chunk = remaining;
+            remaining.clear();
+        } else {
+            size_t breakPos = remaining.rfind(' ', TWITCH_MAX);
+            if (breakPos == std::string::npos || breakPos < TWITCH_MAX / 2) {
+                breakPos = TWITCH_MAX;
+            }
+            chunk = remaining.substr(0, breakPos);
+            remaining = remaining.substr(breakPos);
+            while (!remaining.empty() && remaining[0] == ' ') {
+                remaining = remaining.substr(1);
+            }
+        }
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+static std::vector<std::string> buildReplies() {
+    const char* sentences[] = {
+        "That is a really good question, and I have been thinking about it all day. ",
+        "Das ist eine wirklich gute Frage, \xC3\xBC" "ber die ich lange nachgedacht habe. ",
+        "\xD0\xAD\xD1\x82\xD0\xBE \xD0\xBE\xD1\x87\xD0\xB5\xD0\xBD\xD1\x8C \xD1\x85\xD0\xBE\xD1\x80\xD0\xBE\xD1\x88"
+        "\xD0\xB8\xD0\xB9 \xD0\xB2\xD0\xBE\xD0\xBF\xD1\x80\xD0\xBE\xD1\x81, \xD0\xB4\xD1\x80\xD1\x83\xD0\xB3. ",
+        // Japanese runs for hundreds of bytes without a space
+        "\xE3\x81\x9D\xE3\x82\x8C\xE3\x81\xAF\xE6\x9C\xAC\xE5\xBD\x93\xE3\x81\xAB\xE8\x89\xAF\xE3\x81\x84\xE8"
+        "\xB3\xAA\xE5\x95\x8F\xE3\x81\xA7\xE3\x81\x99\xE3\x81\xAD\xE3\x80\x82\xE4\xBB\x8A\xE6\x97\xA5\xE3\x81"
+        "\xAF\xE4\xB8\x80\xE6\x97\xA5\xE4\xB8\xAD\xE8\x80\x83\xE3\x81\x88\xE3\x81\xA6\xE3\x81\x84\xE3\x81\xBE"
+        "\xE3\x81\x97\xE3\x81\x9F\xE3\x80\x82",
+        "\xD9\x87\xD8\xB0\xD8\xA7 \xD8\xB3\xD8\xA4\xD8\xA7\xD9\x84 \xD8\xAC\xD9\x8A\xD8\xAF \xD8\xAC\xD8\xAF"
+        "\xD8\xA7\xD8\x8C \xD8\xB4\xD9\x83\xD8\xB1\xD8\xA7 \xD9\x84\xD9\x83. ",
+        "Haha \xF0\x9F\x98\x82\xF0\x9F\x8E\x89\xF0\x9F\x94\xA5 that made my day! ",
+        "\n\n",
+        "\n```cpp\nint main() {\n    return 0;\n}\n```\n",
+    };
+    const size_t sentenceCount = sizeof(sentences) / sizeof(sentences[0]);
+
+    std::mt19937 rng(SEED);
+    std::vector<std::string> replies;
+    for (int i = 0; i < REPLIES; i++) {
+        size_t target = 1000 + rng() % 11000;
+        std::string reply;
+        while (reply.size() < target) reply += sentences[rng() % sentenceCount];
+        replies.push_back(reply);
+    }
+    return replies;
+}
+
+int main() {
+    std::vector<std::string> replies = buildReplies();
+    size_t bytes = 0;
+    for (const auto& reply : replies) bytes += reply.size();
+    int failures = 0;
+
+    // Correctness of both paths first
+    size_t oldChunks = 0, oldBroken = 0, newChunks = 0, refused = 0;
+    for (const auto& reply : replies) {
+        for (const auto& chunk : oldSplit(reply)) {
+            oldChunks++;
+            oldBroken += !validUtf8(chunk);
+        }
+
+        std::string joined;
+        for (const auto& chunk : splitMessage(reply, TWITCH_MAX, false)) {
+            newChunks++;
+            if (utf8Length(chunk) > TWITCH_MAX || !validUtf8(chunk)) failures++;
+            joined += chunk;
+        }
+        if (stripSpace(joined) != stripSpace(reply)) failures++;
+
+        if (utf8Length(reply) > DISCORD_MAX) refused++;
+        for (const auto& chunk : splitMessage(reply, DISCORD_MAX, true)) {
+            if (utf8Length(chunk) > DISCORD_MAX || !validUtf8(chunk) || countFences(chunk) % 2 != 0) failures++;
+        }
+    }
+    if (failures) printf("%d splitMessage chunk(s) over the limit, broken, unbalanced or changed\n", failures);
+
+    double bestOld = 1e18, bestTwitch = 1e18, bestDiscord = 1e18;
+    size_t sink = 0;
+    for (int trial = 0; trial < 3; trial++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& reply : replies) sink += oldSplit(reply).size();
+        auto t1 = std::chrono::steady_clock::now();
+        for (const auto& reply : replies) sink += splitMessage(reply, TWITCH_MAX, false).size();
+        auto t2 = std::chrono::steady_clock::now();
+        for (const auto& reply : replies) sink += splitMessage(reply, DISCORD_MAX, true).size();
+        auto t3 = std::chrono::steady_clock::now();
+
+        bestOld = std::min(bestOld, std::chrono::duration<double, std::nano>(t1 - t0).count() / REPLIES);
+        bestTwitch = std::min(bestTwitch, std::chrono::duration<double, std::nano>(t2 - t1).count() / REPLIES);
+        bestDiscord = std::min(bestDiscord, std::chrono::duration<double, std::nano>(t3 - t2).count() / REPLIES);
+    }
+
+    printf("%d multilingual replies, %zu bytes on average:\n", REPLIES, bytes / REPLIES);
+    printf("  Twitch %zu:  substr loop %7.0f ns/reply, %zu of %zu chunks cut a character; "
+           "splitMessage %7.0f ns/reply, %zu chunks\n", TWITCH_MAX, bestOld, oldBroken, oldChunks, bestTwitch, newChunks);
+    printf("  Discord %zu: posted whole, %d of %d replies over the limit; splitMessage %7.0f ns/reply\n",
+           DISCORD_MAX, (int)refused, REPLIES, bestDiscord);
+    if (sink == 0) failures++;
+
+    printf("BenchSplitMessage: %d failure(s) in %d replies\n", failures, REPLIES);
+    return failures == 0 ? 0 : 1;
+}
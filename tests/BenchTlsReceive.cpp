@@ -0,0 +1,268 @@
+// Benchmark for the TLS receive path (SchannelSSL.cpp). The bot's Schannel client
+// talks to a MockConnection over 127.0.0.1.
+//   - Memory: opens CONNECTIONS connections, reads one full record on each, and
+//     counts the heap bytes the client side still holds per connection (at most
+//     MAX_CONNECTION_KIB). Only operator new is counted: Schannel's own
+//     allocations are not.
+//   - Reads: the server sends STREAM_MB of 100-byte WebSocket frames, read three
+//     ways: the old SecureRecv pattern (each record's plaintext copied into a
+//     64 KiB decryptedBuffer, then copied out in 2-byte headers and payloads: 2
+//     bytes copied per byte received), the WebSocket readers' SchannelRecvAll and
+//     SchannelRecv (1 byte copied), and SchannelRecvView as the raw IRC transport
+//     reads (none). The old pattern is rebuilt on top of the view, so it also
+//     shares the new code's decrypt-in-place. Every path must see the same bytes.
+// The old context's buffers (about 330 KiB per connection) are not rebuilt here;
+// that figure is from the old source. Run tests\build_tests.bat from a Visual
+// Studio x64 Native Tools prompt; exits non-zero on any failed check.
+
+#include "MockTlsServer.h"
+#include <atomic>
+#include <cstdio>
+#include <chrono>
+#include <new>
+
+#pragma comment(lib, "user32.lib")
+
+static const int CONNECTIONS = 16;
+static const int STREAM_MB = 64;
+static const int FRAME_PAYLOAD = 98; // With its 2-byte header, a 100-byte frame
+static const double MAX_CONNECTION_KIB = 64; // One record to read and one to send, with room to spare
+static const wchar_t* KEY_CONTAINER = L"KinBotManagerTlsReceiveBench";
+
+// ============================================
+// Live heap bytes allocated while counting is on
+// ============================================
+
+static std::atomic<long long> liveBytes(0);
+static thread_local bool counting = false;
+
+// The header keeps the size, and whether it was counted, for whichever thread frees it
+void* operator new(size_t size) {
+    size_t* p = (size_t*)malloc(size + 16);
+    if (!p) throw std::bad_alloc();
+    p[0] = size;
+    p[1] = counting;
+    if (counting) liveBytes += (long long)size;
+    return p + 2;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    size_t* p = (size_t*)ptr - 2;
+    if (p[1]) liveBytes -= (long long)p[0];
+    free(p);
+}
+
+// ============================================
+// The three read paths
+// ============================================
+
+// SecureRecv before the receive path decrypted in place: whole records into a
+// context buffer, then pieces copied out of it
+struct OldReader {
+    std::vector<BYTE> decryptedBuffer = std::vector<BYTE>(0x10000);
+    size_t decryptedStart = 0;
+    size_t decryptedLen = 0;
+
+    int recv(SchannelContext* ssl, void* buffer, int len) {
+        if (decryptedLen == 0) {
+            const char* data = nullptr;
+            int got = SchannelRecvView(ssl, &data, (int)decryptedBuffer.size());
+            if (got <= 0) return got;
+            memcpy(decryptedBuffer.data(), data, got);
+            decryptedStart = 0;
+            decryptedLen = got;
+        }
+        int take = len < (int)decryptedLen ? len : (int)decryptedLen;
+        memcpy(buffer, decryptedBuffer.data() + decryptedStart, take);
+        decryptedStart += take;
+        decryptedLen -= take;
+        return take;
+    }
+
+    bool recvAll(SchannelContext* ssl, BYTE* buffer, int len) {
+        int got = 0;
+        while (got < len) {
+            int received = recv(ssl, buffer + got, len - got);
+            if (received <= 0) return false;
+            got += received;
+        }
+        return true;
+    }
+};
+
+// FNV-1a over everything read, so lost, repeated or reordered bytes all show
+static void hashBytes(uint64_t& hash, const BYTE* data, int len) {
+    for (int i = 0; i < len; i++) hash = (hash ^ data[i]) * 1099511628211ULL;
+}
+
+static bool readOld(SchannelContext* ssl, size_t total, uint64_t& hash) {
+    OldReader reader;
+    BYTE header[2];
+    BYTE payload[FRAME_PAYLOAD];
+    for (size_t done = 0; done < total; done += sizeof(header) + sizeof(payload)) {
+        if (!reader.recvAll(ssl, header, 2)) return false;
+        int len = header[1] & 0x7F;
+        if (len > FRAME_PAYLOAD || !reader.recvAll(ssl, payload, len)) return false;
+        hashBytes(hash, header, 2);
+        hashBytes(hash, payload, len);
+    }
+    return true;
+}
+
+static bool readFrames(SchannelContext* ssl, size_t total, uint64_t& hash) {
+    BYTE header[2];
+    BYTE payload[FRAME_PAYLOAD];
+    for (size_t done = 0; done < total; done += sizeof(header) + sizeof(payload)) {
+        if (SchannelRecvAll(ssl, header, 2) != 2) return false;
+        int len = header[1] & 0x7F;
+        if (len > FRAME_PAYLOAD || SchannelRecvAll(ssl, payload, len) != len) return false;
+        hashBytes(hash, header, 2);
+        hashBytes(hash, payload, len);
+    }
+    return true;
+}
+
+static bool readViews(SchannelContext* ssl, size_t total, uint64_t& hash) {
+    size_t done = 0;
+    while (done < total) {
+        const char* data = nullptr;
+        int got = SchannelRecvView(ssl, &data, 16384);
+        if (got <= 0) return false;
+        hashBytes(hash, (const BYTE*)data, got);
+        done += got;
+    }
+    return done == total;
+}
+
+// ============================================
+// Benchmark
+// ============================================
+
+static int measureMemory(SOCKET listener, const std::string& port, CredHandle* credentials) {
+    std::string record(16000, 'x');
+
+    // The first connection warms anything cached process-wide (DNS, Schannel's session cache)
+    {
+        LoopbackPair warm;
+        if (!openLoopbackPair(warm, listener, port, credentials)) {
+            printf("TLS handshake over loopback failed\n");
+            return 1;
+        }
+    }
+
+    std::vector<LoopbackPair> pairs(CONNECTIONS);
+    int opened = 0;
+    counting = true;
+    long long before = liveBytes;
+    for (auto& pair : pairs) {
+        if (!openLoopbackPair(pair, listener, port, credentials) || !pair.server.send(record)) break;
+        size_t got = 0;
+        while (got < record.size()) {
+            const char* data = nullptr;
+            int n = SchannelRecvView(pair.client, &data, 16384);
+            if (n <= 0) break;
+            got += n;
+        }
+        if (got != record.size()) break;
+        opened++;
+    }
+    long long held = liveBytes - before;
+    counting = false;
+
+    if (opened != CONNECTIONS) {
+        printf("Only %d of %d connections opened and read a record\n", opened, CONNECTIONS);
+        return 1;
+    }
+    double perConnection = held / 1024.0 / CONNECTIONS;
+    printf("Client heap per connection after a 16 KB record: %.1f KiB (old context: about 330 KiB)\n",
+           perConnection);
+    if (perConnection > MAX_CONNECTION_KIB) {
+        printf("Each connection holds more than %.0f KiB\n", MAX_CONNECTION_KIB);
+        return 1;
+    }
+    return 0;
+}
+
+static int measureReads(SOCKET listener, const std::string& port, CredHandle* credentials) {
+    LoopbackPair pair;
+    if (!openLoopbackPair(pair, listener, port, credentials)) {
+        printf("TLS handshake over loopback failed\n");
+        return 1;
+    }
+
+    // 1 MB of frames, sent STREAM_MB times
+    std::string chunk;
+    while (chunk.size() < (1 << 20)) {
+        std::string payload(FRAME_PAYLOAD, (char)('a' + chunk.size() / 100 % 26));
+        appendServerFrame(chunk, payload);
+    }
+    uint64_t expected = 14695981039346656037ULL;
+    for (int i = 0; i < STREAM_MB; i++) hashBytes(expected, (const BYTE*)chunk.data(), (int)chunk.size());
+    size_t total = chunk.size() * STREAM_MB;
+
+    struct Path {
+        const char* name;
+        bool (*read)(SchannelContext*, size_t, uint64_t&);
+    } paths[] = {
+        { "old SecureRecv pattern (2 B copied per B)", readOld },
+        { "SchannelRecvAll/SchannelRecv (1 B)      ", readFrames },
+        { "SchannelRecvView (0 B)                  ", readViews },
+    };
+
+    int failures = 0;
+    printf("%d MB of %d-byte WebSocket frames over loopback TLS:\n", STREAM_MB, FRAME_PAYLOAD + 2);
+    for (const auto& path : paths) {
+        bool sent = true;
+        std::thread server([&]() {
+            for (int i = 0; i < STREAM_MB && sent; i++) sent = pair.server.send(chunk);
+        });
+        uint64_t hash = 14695981039346656037ULL;
+        auto start = std::chrono::steady_clock::now();
+        bool read = path.read(pair.client, total, hash);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!read || hash != expected) shutdown(pair.sock, SD_BOTH); // Unblocks the server if the read went wrong
+        server.join();
+
+        if (!read || !sent || hash != expected) {
+            printf("  %s: bytes lost or changed\n", path.name);
+            failures++;
+            break;
+        }
+        printf("  %s %7.2f ms/MB\n", path.name, ms / STREAM_MB);
+    }
+    return failures;
+}
+
+int main() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("WSAStartup failed\n");
+        return 1;
+    }
+
+    PCCERT_CONTEXT cert = createCertificate(KEY_CONTAINER);
+    CredHandle credentials;
+    std::string port;
+    SOCKET listener = INVALID_SOCKET;
+    if (!cert || !acquireServerCredentials(cert, &credentials) ||
+        (listener = openLoopbackListener(CONNECTIONS, port)) == INVALID_SOCKET) {
+        printf("Could not set up the mock server (error %lu)\n", GetLastError());
+        if (cert) CertFreeCertificateContext(cert);
+        deleteKeyContainer(KEY_CONTAINER);
+        WSACleanup();
+        return 1;
+    }
+
+    int failures = measureMemory(listener, port, &credentials);
+    failures += measureReads(listener, port, &credentials);
+
+    closesocket(listener);
+    FreeCredentialsHandle(&credentials);
+    CertFreeCertificateContext(cert);
+    deleteKeyContainer(KEY_CONTAINER);
+    WSACleanup();
+
+    printf("BenchTlsReceive: %d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// Benchmark for TLS session resumption (SchannelSSL.cpp). The bot's Schannel client
+// connects to a MockConnection over 127.0.0.1 HANDSHAKES times each way:
+//   - full: every connection names a new target, so the client session cache has
+//     nothing to offer, as when each connection had its own credentials handle;
+//   - resumed: every connection names "127.0.0.1" after one connection has primed
+//     the cache, as a reconnect to the same host does.
+// Times connect plus handshake, both ends included, and checks that
+// SchannelSessionResumed reports each kind correctly. Loopback has no network
+// round trips, so against Discord or Twitch the resumed handshake also saves one
+// round trip that these times do not show. Run tests\build_tests.bat from a Visual
+// Studio x64 Native Tools prompt; exits non-zero on any failed check.
+
+#include "MockTlsServer.h"
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+
+#pragma comment(lib, "user32.lib")
+
+static const int HANDSHAKES = 50;
+static const wchar_t* KEY_CONTAINER = L"KinBotManagerTlsResumeBench";
+
+struct Timings {
+    int failed = 0;
+    int resumed = 0;
+    std::vector<double> ms;
+};
+
+static Timings connectMany(SOCKET listener, const std::string& port, CredHandle* credentials, bool newTarget) {
+    Timings timings;
+    for (int i = 0; i < HANDSHAKES; i++) {
+        std::string target = newTarget ? "full-" + std::to_string(i) + ".kinbot.test" : "127.0.0.1";
+        LoopbackPair pair;
+        auto start = std::chrono::steady_clock::now();
+        bool ok = openLoopbackPair(pair, listener, port, credentials, target.c_str());
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!ok) {
+            timings.failed++;
+            continue;
+        }
+        timings.ms.push_back(ms);
+        timings.resumed += SchannelSessionResumed(pair.client);
+    }
+    return timings;
+}
+
+static double median(std::vector<double> values) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+int main() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("WSAStartup failed\n");
+        return 1;
+    }
+
+    PCCERT_CONTEXT cert = createCertificate(KEY_CONTAINER);
+    CredHandle credentials;
+    std::string port;
+    SOCKET listener = INVALID_SOCKET;
+    if (!cert || !acquireServerCredentials(cert, &credentials) ||
+        (listener = openLoopbackListener(1, port)) == INVALID_SOCKET) {
+        printf("Could not set up the mock server (error %lu)\n", GetLastError());
+        if (cert) CertFreeCertificateContext(cert);
+        deleteKeyContainer(KEY_CONTAINER);
+        WSACleanup();
+        return 1;
+    }
+
+    int failures = 0;
+    {
+        // Primes the session cache for "127.0.0.1"
+        LoopbackPair first;
+        if (!openLoopbackPair(first, listener, port, &credentials)) {
+            printf("TLS handshake over loopback failed\n");
+            failures++;
+        }
+    }
+
+    if (failures == 0) {
+        Timings full = connectMany(listener, port, &credentials, true);
+        Timings resumed = connectMany(listener, port, &credentials, false);
+
+        printf("%d connections each, connect + handshake over loopback TLS:\n", HANDSHAKES);
+        printf("  full:    median %6.2f ms, %d of %zu resumed\n", median(full.ms), full.resumed, full.ms.size());
+        printf("  resumed: median %6.2f ms, %d of %zu resumed\n", median(resumed.ms), resumed.resumed,
+               resumed.ms.size());
+        if (full.failed || resumed.failed) {
+            printf("%d handshake(s) failed\n", full.failed + resumed.failed);
+            failures++;
+        }
+        if (full.resumed != 0) {
+            printf("A new target name resumed a session\n");
+            failures++;
+        }
+        if (resumed.resumed != (int)resumed.ms.size()) {
+            printf("Only %d of %zu reconnects to the same target resumed\n", resumed.resumed, resumed.ms.size());
+            failures++;
+        }
+    }
+
+    closesocket(listener);
+    FreeCredentialsHandle(&credentials);
+    CertFreeCertificateContext(cert);
+    deleteKeyContainer(KEY_CONTAINER);
+    WSACleanup();
+
+    printf("BenchTlsResume: %d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+// Mock-server benchmark for the two Twitch transports: IRC over WebSocket and raw
+// IRC over TLS (twitchRawIrc). A local TLS server stands in for Twitch. It sends the
+// same PRIVMSG traffic to a real TwitchBot over each transport, then a PING, and
+// stops the clock when the bot's PONG comes back. It reports wall time and the bot's
+// CPU time (process CPU minus the mock server's thread). Run tests\build_tests.bat
+// from a Visual Studio x64 Native Tools prompt.
+
+#include "MockTlsServer.h"
+#include <cstdio>
+
+#pragma comment(lib, "user32.lib")
+
+bool g_debugMode = false; // Normally Main.cpp's; off so chat lines are not logged
+
+static const int MESSAGES = 200000;
+static const int ROUNDS = 3;
+static const wchar_t* KEY_CONTAINER = L"KinBotManagerTransportBench";
+
+// ============================================
+// Traffic
+// ============================================
+
+// A chat line shaped like Twitch's (IRCv3 tags, display name, ids), not addressed to the bot
+static std::string chatLine(int i) {
+    std::string user = "viewer" + std::to_string(i % 997);
+    return "@badge-info=;badges=subscriber/12;color=#1E90FF;display-name=Viewer" + std::to_string(i % 997) +
+           ";emotes=;first-msg=0;flags=;id=6f1c2d3e-" + std::to_string(100000 + i) +
+           ";mod=0;room-id=12345;subscriber=1;tmi-sent-ts=1700000000000;turbo=0;user-id=" +
+           std::to_string(500000 + i % 997) + ";user-type= :" + user + "!" + user + "@" + user +
+           ".tmi.twitch.tv PRIVMSG #bench :message " + std::to_string(i) +
+           " about the stream, nothing for the bot here\r\n";
+}
+
+// ============================================
+// One timed run per transport
+// ============================================
+
+static double fileTimeMs(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return value.QuadPart / 10000.0;
+}
+
+static double processCpuMs() {
+    FILETIME created, exited, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user);
+    return fileTimeMs(kernel) + fileTimeMs(user);
+}
+
+static double threadCpuMs() {
+    FILETIME created, exited, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user);
+    return fileTimeMs(kernel) + fileTimeMs(user);
+}
+
+struct RunResult {
+    bool ok = false;
+    double wallMs = 0;
+    double botCpuMs = 0;
+};
+
+// Reads from the bot until text (unframed for WebSocket) contains marker
+static bool waitFor(MockConnection& conn, bool rawIrc, std::string& text, const char* marker) {
+    while (text.find(marker) == std::string::npos) {
+        if (!conn.receive()) return false;
+        if (rawIrc) {
+            text += conn.plain;
+            conn.plain.clear();
+        } else {
+            decodeClientFrames(conn.plain, text);
+        }
+    }
+    return true;
+}
+
+// TLS accept, the WebSocket upgrade when needed, then wait for the bot's JOIN
+static bool acceptBot(MockConnection& conn, SOCKET listener, CredHandle* credentials, bool rawIrc) {
+    if (!conn.accept(listener, credentials)) {
+        printf("  TLS accept failed\n");
+        return false;
+    }
+    
+    std::string text;
+    if (!rawIrc) {
+        // The upgrade request is plain HTTP, not a frame
+        if (!waitFor(conn, true, text, "\r\n\r\n") ||
+            !conn.send("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n")) {
+            printf("  WebSocket upgrade failed\n");
+            return false;
+        }
+        text.clear();
+    }
+    
+    if (!waitFor(conn, rawIrc, text, "JOIN #bench\r\n")) {
+        printf("  bot never joined\n");
+        return false;
+    }
+    return true;
+}
+
+static RunResult runTransport(bool rawIrc, CredHandle* credentials, const std::string& traffic,
+                              const std::string& ping) {
+    RunResult result;
+    
+    std::string port;
+    SOCKET listener = openLoopbackListener(1, port);
+    if (listener == INVALID_SOCKET) {
+        printf("  could not open a loopback listener\n");
+        return result;
+    }
+    
+    TwitchBot* bot = new TwitchBot("kinbot", "oauth:benchmark", "bench", nullptr, NULL, 50, rawIrc);
+    bot->setServer("127.0.0.1", port);
+    bot->start();
+    
+    {
+        MockConnection conn;
+        if (acceptBot(conn, listener, credentials, rawIrc)) {
+            std::string text;
+            ULONGLONG wallStart = GetTickCount64();
+            double processStart = processCpuMs();
+            double serverStart = threadCpuMs();
+            
+            if (conn.send(traffic) && conn.send(ping) && waitFor(conn, rawIrc, text, "PONG :bench")) {
+                double serverMs = threadCpuMs() - serverStart;
+                result.wallMs = (double)(GetTickCount64() - wallStart);
+                result.botCpuMs = processCpuMs() - processStart - serverMs;
+                result.ok = true;
+            } else {
+                printf("  no PONG for the closing PING\n");
+            }
+        }
+        
+        bot->stop();
+    }
+    delete bot;
+    closesocket(listener);
+    return result;
+}
+
+int main() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("WSAStartup failed\n");
+        return 1;
+    }
+    
+    PCCERT_CONTEXT cert = createCertificate(KEY_CONTAINER);
+    CredHandle credentials;
+    if (!cert || !acquireServerCredentials(cert, &credentials)) {
+        printf("Could not set up the mock server certificate (error %lu)\n", GetLastError());
+        if (cert) CertFreeCertificateContext(cert);
+        deleteKeyContainer(KEY_CONTAINER);
+        WSACleanup();
+        return 1;
+    }
+    
+    // The same chat lines for both transports; the WebSocket server frames each line
+    std::string rawTraffic;
+    std::string wsTraffic;
+    for (int i = 0; i < MESSAGES; i++) {
+        std::string line = chatLine(i);
+        rawTraffic += line;
+        appendServerFrame(wsTraffic, line);
+    }
+    std::string rawPing = "PING :bench\r\n";
+    std::string wsPing;
+    appendServerFrame(wsPing, rawPing);
+    
+    printf("%d chat lines, %zu bytes of IRC (%zu as WebSocket frames), best of %d rounds\n",
+           MESSAGES, rawTraffic.size(), wsTraffic.size(), ROUNDS);
+    
+    int failures = 0;
+    for (int transport = 0; transport < 2; transport++) {
+        bool rawIrc = transport == 1;
+        RunResult best;
+        for (int round = 0; round < ROUNDS; round++) {
+            RunResult run = runTransport(rawIrc, &credentials, rawIrc ? rawTraffic : wsTraffic,
+                                         rawIrc ? rawPing : wsPing);
+            if (!run.ok) {
+                failures++;
+                continue;
+            }
+            if (!best.ok || run.wallMs < best.wallMs) best = run;
+        }
+        
+        const char* name = rawIrc ? "raw IRC over TLS " : "IRC over WebSocket";
+        if (!best.ok) {
+            printf("%s: failed\n", name);
+            continue;
+        }
+        printf("%s: %8.1f ms wall, %8.1f ms bot CPU, %.3f us CPU per line\n", name, best.wallMs,
+               best.botCpuMs, best.botCpuMs * 1000.0 / MESSAGES);
+    }
+    
+    FreeCredentialsHandle(&credentials);
+    CertFreeCertificateContext(cert);
+    deleteKeyContainer(KEY_CONTAINER);
+    WSACleanup();
+    return failures == 0 ? 0 : 1;
+}
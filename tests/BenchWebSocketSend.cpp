@@ -0,0 +1,226 @@
+// Before/after benchmark for outbound WebSocket frames (WebSocket.cpp). The bot's
+// Schannel client talks to a MockConnection over 127.0.0.1, and each frame is sent
+// two ways:
+//   - the old path: the frame built byte by byte in a std::vector, then copied into
+//     a fresh record vector, as the old SecureSend did before encrypting;
+//   - WebSocketSend: the frame written and masked straight into the TLS record.
+// Counts heap allocations per frame on the sending thread and times each frame,
+// encryption and send included. The server unmasks everything it gets and checks it
+// against what was sent. The old path also gets one extra copy here (SchannelSend
+// copies into its record), so its times are slightly high. Frames over one record
+// are only sent the new way: the old SecureSend could not encrypt them. Run
+// tests\build_tests.bat from a Visual Studio x64 Native Tools prompt; exits non-zero
+// on any failed check.
+
+#include "MockTlsServer.h"
+#include <cstdio>
+#include <chrono>
+#include <new>
+
+#pragma comment(lib, "user32.lib")
+
+static const int FRAMES = 20000;
+static const wchar_t* KEY_CONTAINER = L"KinBotManagerWebSocketBench";
+
+// ============================================
+// Allocation counting
+// ============================================
+
+static thread_local size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+// ============================================
+// The two send paths
+// ============================================
+
+// DiscordBot's sendWSFrame and SecureSend before WebSocketSend
+static bool oldSend(SchannelContext* ssl, const std::string& data) {
+    std::vector<unsigned char> frame;
+    frame.push_back(0x81); // FIN + text frame
+
+    size_t len = data.length();
+    if (len < 126) {
+        frame.push_back((unsigned char)(0x80 | len));
+    } else if (len < 65536) {
+        frame.push_back(0x80 | 126);
+        frame.push_back((unsigned char)((len >> 8) & 0xFF));
+        frame.push_back((unsigned char)(len & 0xFF));
+    } else {
+        frame.push_back(0x80 | 127);
+        for (int i = 7; i >= 0; i--) frame.push_back((unsigned char)((len >> (i * 8)) & 0xFF));
+    }
+
+    unsigned char mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+    for (int i = 0; i < 4; i++) frame.push_back(mask[i]);
+    for (size_t i = 0; i < data.length(); i++) frame.push_back(data[i] ^ mask[i % 4]);
+
+    // SecureSend's per-call [header][data][trailer] vector
+    std::vector<BYTE> record(frame.size());
+    memcpy(record.data(), frame.data(), frame.size());
+    return SchannelSend(ssl, record.data(), (int)record.size()) == (int)record.size();
+}
+
+static bool newSend(SchannelContext* ssl, const std::string& data) {
+    return WebSocketSend(ssl, 1, data.data(), data.size());
+}
+
+// ============================================
+// Server side: unmask and compare
+// ============================================
+
+static std::mutex receivedMutex;
+static std::string expected;  // What the current batch should unmask to, repeated
+static size_t expectedBytes = 0;
+static size_t receivedBytes = 0;
+static bool mismatch = false;
+
+static void serve(MockConnection* conn) {
+    std::string text;
+    while (conn->receive()) {
+        decodeClientFrames(conn->plain, text);
+        std::lock_guard<std::mutex> lock(receivedMutex);
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] != expected[(receivedBytes + i) % expected.size()]) mismatch = true;
+        }
+        receivedBytes += text.size();
+        text.clear();
+    }
+}
+
+static bool waitForBatch() {
+    ULONGLONG start = GetTickCount64();
+    while (GetTickCount64() - start < MOCK_TIMEOUT_MS) {
+        {
+            std::lock_guard<std::mutex> lock(receivedMutex);
+            if (receivedBytes >= expectedBytes) return receivedBytes == expectedBytes && !mismatch;
+        }
+        Sleep(1);
+    }
+    return false;
+}
+
+struct BatchResult {
+    bool ok;
+    double allocsPerFrame;
+    double nsPerFrame;
+};
+
+static BatchResult runBatch(SchannelContext* ssl, bool (*send)(SchannelContext*, const std::string&),
+                            const std::string& payload, int frames) {
+    {
+        std::lock_guard<std::mutex> lock(receivedMutex);
+        expected = payload;
+        expectedBytes = payload.size() * frames;
+        receivedBytes = 0;
+        mismatch = false;
+    }
+
+    bool sent = true;
+    size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames && sent; i++) sent = send(ssl, payload);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    size_t allocated = allocations - before;
+
+    BatchResult result = { sent && waitForBatch(), (double)allocated / frames, ns / frames };
+    return result;
+}
+
+int main() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("WSAStartup failed\n");
+        return 1;
+    }
+
+    PCCERT_CONTEXT cert = createCertificate(KEY_CONTAINER);
+    CredHandle credentials;
+    std::string port;
+    SOCKET listener = INVALID_SOCKET;
+    if (!cert || !acquireServerCredentials(cert, &credentials) ||
+        (listener = openLoopbackListener(1, port)) == INVALID_SOCKET) {
+        printf("Could not set up the mock server (error %lu)\n", GetLastError());
+        if (cert) CertFreeCertificateContext(cert);
+        deleteKeyContainer(KEY_CONTAINER);
+        WSACleanup();
+        return 1;
+    }
+
+    int failures = 0;
+    {
+        LoopbackPair pair;
+        if (!openLoopbackPair(pair, listener, port, &credentials)) {
+            printf("TLS handshake over loopback failed\n");
+            failures++;
+        } else {
+            std::thread server(serve, &pair.server);
+
+            // Lengths are 3 past a multiple of 4, so the masking tail uses three key bytes
+            std::string post = "{\"content\":\"";
+            while (post.size() < 1900 || post.size() % 4 != 1) post += "A long reply, split for Discord. ";
+            post += "\"}";
+            std::string large;
+            while (large.size() < 40000 || large.size() % 4 != 3) large += "Large frames take several records. ";
+            struct Case {
+                const char* name;
+                std::string payload;
+                bool oldPath;
+            } cases[] = {
+                { "heartbeat", "{\"op\":1,\"d\":1234567890}", true },
+                { "IRC PRIVMSG", "PRIVMSG #channel :@viewer here is a reply of an ordinary length, "
+                                 "about as long as chat replies tend to be on Twitch!!\r\n", true },
+                { "Discord post", post, true },
+                { "40 KB payload", large, false },
+            };
+
+            printf("%d frames each, sent over loopback TLS:\n", FRAMES);
+            for (const auto& c : cases) {
+                BatchResult oldResult = { true, 0, 0 };
+                if (c.oldPath) oldResult = runBatch(pair.client, oldSend, c.payload, FRAMES);
+                BatchResult newResult = runBatch(pair.client, newSend, c.payload, FRAMES);
+                if (!oldResult.ok || !newResult.ok) {
+                    printf("  %s: frames lost or garbled (%s path)\n", c.name, oldResult.ok ? "new" : "old");
+                    failures++;
+                    continue;
+                }
+                if (c.oldPath) {
+                    printf("  %-13s %5zu B: old %.1f allocs, %6.0f ns; WebSocketSend %.1f allocs, %6.0f ns\n",
+                           c.name, c.payload.size(), oldResult.allocsPerFrame, oldResult.nsPerFrame,
+                           newResult.allocsPerFrame, newResult.nsPerFrame);
+                } else {
+                    printf("  %-13s %5zu B: old path cannot send it;  WebSocketSend %.1f allocs, %6.0f ns\n",
+                           c.name, c.payload.size(), newResult.allocsPerFrame, newResult.nsPerFrame);
+                }
+            }
+
+            // One record's frame must not touch the heap once the buffers are warm
+            BatchResult warm = runBatch(pair.client, newSend, cases[2].payload, 100);
+            if (warm.allocsPerFrame != 0) {
+                printf("WebSocketSend allocated %.2f times per one-record frame\n", warm.allocsPerFrame);
+                failures++;
+            }
+
+            shutdown(pair.sock, SD_BOTH);
+            server.join();
+        }
+    }
+
+    closesocket(listener);
+    FreeCredentialsHandle(&credentials);
+    CertFreeCertificateContext(cert);
+    deleteKeyContainer(KEY_CONTAINER);
+    WSACleanup();
+
+    printf("BenchWebSocketSend: %d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
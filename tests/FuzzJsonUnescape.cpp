@@ -0,0 +1,81 @@
+// Randomized check for SimpleJSON::unescape (Utils.cpp).
+// Feeds strings built from valid, lone and malformed \u escapes and checks that
+// unescape never throws and always returns valid UTF-8 (no surrogates, no
+// overlong forms). Run tests\build_tests.bat from a Visual Studio x64 Native
+// Tools prompt; exits non-zero on failure.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <random>
+
+static const unsigned SEED = 7;
+static const int ITERATIONS = 500000;
+
+static bool validUtf8(const std::string& s) {
+    size_t i = 0;
+    while (i < s.size()) {
+        unsigned char c = s[i];
+        size_t len;
+        unsigned int cp;
+        if (c < 0x80) { i++; continue; }
+        else if ((c >> 5) == 6) { len = 2; cp = c & 0x1F; }
+        else if ((c >> 4) == 14) { len = 3; cp = c & 0x0F; }
+        else if ((c >> 3) == 30) { len = 4; cp = c & 0x07; }
+        else return false;
+
+        if (i + len > s.size()) return false;
+        for (size_t k = 1; k < len; k++) {
+            if ((s[i + k] & 0xC0) != 0x80) return false;
+            cp = (cp << 6) | (s[i + k] & 0x3F);
+        }
+        if (cp >= 0xD800 && cp <= 0xDFFF) return false;
+        if (cp > 0x10FFFF) return false;
+        if ((len == 2 && cp < 0x80) || (len == 3 && cp < 0x800) || (len == 4 && cp < 0x10000)) return false;
+        i += len;
+    }
+    return true;
+}
+
+static int expect(const char* input, const std::string& expected) {
+    std::string actual = SimpleJSON::unescape(input);
+    if (actual == expected) return 0;
+    printf("unescape(%s) gave %zu bytes, expected %zu\n", input, actual.size(), expected.size());
+    return 1;
+}
+
+int main() {
+    int failures = 0;
+
+    // Surrogate pairs combine; lone halves become U+FFFD
+    failures += expect("\\uD83D\\uDE00", "\xF0\x9F\x98\x80");
+    failures += expect("\\uDBFF\\uDFFF", "\xF4\x8F\xBF\xBF");
+    failures += expect("x\\uD83Dy", "x\xEF\xBF\xBDy");
+    failures += expect("\\uD800\\u0041", "\xEF\xBF\xBD" "A");
+    failures += expect("\\u00e9", "\xC3\xA9");
+
+    const char* tokens[] = {
+        "\\u", "\\ud83d", "\\ude00", "\\uD83D\\uDE00", "\\u00e9", "\\uZZZZ", "\\u12",
+        "\\", "\\n", "a", "\\uDBFF\\uDFFF", "\\u0000", "\\uFFFF", "g", "\\uD800\\u0041"
+    };
+    const size_t tokenCount = sizeof(tokens) / sizeof(tokens[0]);
+
+    std::mt19937 rng(SEED);
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        std::string input;
+        int count = rng() % 12;
+        for (int k = 0; k < count; k++) input += tokens[rng() % tokenCount];
+
+        try {
+            if (!validUtf8(SimpleJSON::unescape(input))) {
+                if (failures < 5) printf("invalid UTF-8 from [%s]\n", input.c_str());
+                failures++;
+            }
+        } catch (...) {
+            if (failures < 5) printf("threw on [%s]\n", input.c_str());
+            failures++;
+        }
+    }
+
+    printf("SimpleJSON::unescape: %d iterations, %d failures\n", ITERATIONS, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+// Randomized check and benchmark for LineBuffer (IrcMessage.cpp).
+// Random lines, including empty ones, end in "\r\n" or a bare "\n" and are fed in
+// random chunks that can split a "\r\n" in two; the lines handed out must equal a
+// reference split, with the unterminated tail left pending. Then times frames of
+// Twitch-sized lines through the old substr loop and through LineBuffer. Run
+// tests\build_tests.bat from a Visual Studio x64 Native Tools prompt; exits non-zero
+// on any mismatch.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+static const unsigned SEED = 43;
+static const int ITERATIONS = 20000;
+
+// What TwitchBot's receive loop did before LineBuffer; returns the line bytes seen
+static size_t oldSplit(std::string& lineBuffer, const std::string& frame) {
+    size_t bytes = 0;
+    lineBuffer += frame;
+    size_t pos;
+    while ((pos = lineBuffer.find("\r\n")) != std::string::npos) {
+        std::string line = lineBuffer.substr(0, pos);
+        lineBuffer = lineBuffer.substr(pos + 2);
+        bytes += line.size();
+    }
+    return bytes;
+}
+
+int main() {
+    std::mt19937 rng(SEED);
+    int failures = 0;
+
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        std::string stream;
+        std::vector<std::string> expected;
+        int lineCount = rng() % 50;
+        for (int i = 0; i < lineCount; i++) {
+            std::string line;
+            int len = rng() % 5 == 0 ? 0 : rng() % 40;
+            for (int k = 0; k < len; k++) line += (char)('a' + rng() % 26);
+            expected.push_back(line);
+            stream += line + (rng() % 2 ? "\r\n" : "\n");
+        }
+        std::string tail = rng() % 2 ? "partial" : "";
+        stream += tail;
+
+        // Lines are copied out before the next append, which may move the buffer
+        LineBuffer lines;
+        std::vector<std::string> got;
+        size_t pos = 0;
+        while (pos < stream.size()) {
+            size_t chunk = 1 + rng() % 30;
+            if (chunk > stream.size() - pos) chunk = stream.size() - pos;
+            lines.append(stream.data() + pos, chunk);
+            pos += chunk;
+            std::string_view line;
+            while (lines.next(line)) got.emplace_back(line);
+        }
+
+        if (got != expected || lines.pending() != tail.size()) {
+            if (failures < 5) printf("iteration %d: %zu line(s), %zu pending; expected %zu and %zu\n", iter,
+                                     got.size(), lines.pending(), expected.size(), tail.size());
+            failures++;
+        }
+    }
+
+    // A long-lived connection: many small frames, so consumed bytes get compacted away
+    {
+        LineBuffer lines;
+        std::string frame = "PING :tmi.twitch.tv\r\n";
+        size_t seen = 0;
+        for (int i = 0; i < 100000; i++) {
+            lines.append(frame.data(), frame.size());
+            std::string_view line;
+            while (lines.next(line)) seen++;
+        }
+        if (seen != 100000 || lines.pending() != 0) {
+            printf("steady stream: %zu of 100000 lines, %zu bytes pending\n", seen, lines.pending());
+            failures++;
+        }
+    }
+
+    printf("Per frame of tagged PRIVMSG lines:\n");
+    std::string line = "@badges=;color=#FF0000;display-name=someone :someone!someone@someone.tmi.twitch.tv "
+                       "PRIVMSG #chan :hello there chat\r\n";
+    for (int count : { 10, 100, 1000, 5000 }) {
+        std::string frame;
+        for (int i = 0; i < count; i++) frame += line;
+        int repeats = 2000000 / count / (count >= 1000 ? 10 : 1);
+        if (repeats < 3) repeats = 3;
+
+        auto t0 = std::chrono::steady_clock::now();
+        size_t oldBytes = 0;
+        for (int r = 0; r < repeats; r++) {
+            std::string lineBuffer;
+            oldBytes += oldSplit(lineBuffer, frame);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        LineBuffer lines;
+        size_t newBytes = 0;
+        for (int r = 0; r < repeats; r++) {
+            lines.append(frame.data(), frame.size());
+            std::string_view view;
+            while (lines.next(view)) newBytes += view.size();
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        double oldUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / repeats;
+        double newUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / repeats;
+        printf("  %5d lines: substr loop %9.1f us, LineBuffer %7.1f us\n", count, oldUs, newUs);
+        if (oldBytes != newBytes) {
+            printf("  %d lines: substr loop saw %zu bytes, LineBuffer %zu\n", count, oldBytes, newBytes);
+            failures++;
+        }
+    }
+
+    printf("FuzzLineBuffer: %d failure(s) in %d streams\n", failures, ITERATIONS);
+    return failures == 0 ? 0 : 1;
+}
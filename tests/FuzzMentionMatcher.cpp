@@ -0,0 +1,187 @@
+// Differential check for MentionMatcher (MentionMatcher.cpp).
+// Random strings built from the bytes mentions are made of are searched with the
+// matcher and with a naive one that lowercases and tries every pattern at every
+// position: both must find the same leftmost, longest mention, and strip() must
+// agree with a strip built on the naive search. Strings run up to three 16-byte
+// blocks, so mentions fall in the SSE2 scan, across block edges and in the tail.
+// Then times the matcher against the old lowercase-and-find path on chat lines. Run
+// tests\build_tests.bat from a Visual Studio x64 Native Tools prompt; exits non-zero
+// on any disagreement.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <cctype>
+#include <chrono>
+#include <random>
+
+static const unsigned SEED = 45;
+static const int ITERATIONS = 300000;
+static const int CHAT_LINES = 200000;
+static const int MENTION_EVERY = 100; // 1% of chat lines mention the bot
+
+struct NaivePattern {
+    std::string text; // Lowercase
+    bool wordEnd;
+};
+
+static bool isNameByte(unsigned char c) {
+    return isalnum(c) || c == '_';
+}
+
+// Names as "@name" that must not run into another name character; IDs as <@id> and <@!id>
+static std::vector<NaivePattern> naivePatterns(const std::vector<std::string>& names,
+                                               const std::vector<std::string>& ids) {
+    std::vector<NaivePattern> patterns;
+    for (const auto& name : names) {
+        std::string lower = "@" + name;
+        for (char& c : lower) c = (char)tolower((unsigned char)c);
+        patterns.push_back({ lower, true });
+    }
+    for (const auto& id : ids) {
+        patterns.push_back({ "<@" + id + ">", false });
+        patterns.push_back({ "<@!" + id + ">", false });
+    }
+    return patterns;
+}
+
+static bool naiveFind(const std::vector<NaivePattern>& patterns, const std::string& text, size_t from,
+                      MentionMatcher::Span& span) {
+    std::string lower = text;
+    for (char& c : lower) c = (char)tolower((unsigned char)c);
+    for (size_t pos = from; pos < lower.size(); pos++) {
+        size_t best = 0;
+        for (const auto& p : patterns) {
+            if (lower.compare(pos, p.text.size(), p.text) != 0) continue;
+            size_t end = pos + p.text.size();
+            if (p.wordEnd && end < lower.size() && isNameByte((unsigned char)lower[end])) continue;
+            if (p.text.size() > best) best = p.text.size();
+        }
+        if (best > 0) {
+            span.start = pos;
+            span.length = best;
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::string naiveStrip(const std::vector<NaivePattern>& patterns, const std::string& text) {
+    std::string result;
+    size_t pos = 0;
+    MentionMatcher::Span span;
+    while (naiveFind(patterns, text, pos, span)) {
+        result += text.substr(pos, span.start - pos);
+        pos = span.start + span.length;
+        if (!result.empty() && result.back() == ' ' && pos < text.size() && text[pos] == ' ') pos++;
+    }
+    result += text.substr(pos);
+
+    size_t start = result.find_first_not_of(" \t\n\r");
+    if (start == std::string::npos) return std::string();
+    size_t end = result.find_last_not_of(" \t\n\r");
+    return result.substr(start, end - start + 1);
+}
+
+struct Setup {
+    const char* label;
+    std::vector<std::string> names;
+    std::vector<std::string> ids;
+    const char* alphabet; // Bytes the random strings are made of
+};
+
+static int checkSetup(const Setup& setup, std::mt19937& rng) {
+    MentionMatcher matcher;
+    for (const auto& name : setup.names) matcher.addName(name);
+    for (const auto& id : setup.ids) matcher.addUserId(id);
+    std::vector<NaivePattern> patterns = naivePatterns(setup.names, setup.ids);
+
+    int failures = 0;
+    size_t alphabetSize = strlen(setup.alphabet);
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        std::string text;
+        int len = rng() % 48;
+        for (int k = 0; k < len; k++) text += setup.alphabet[rng() % alphabetSize];
+
+        MentionMatcher::Span expected = { 0, 0 };
+        MentionMatcher::Span actual = { 0, 0 };
+        size_t from = text.empty() ? 0 : rng() % (text.size() + 1);
+        bool naiveHit = naiveFind(patterns, text, from, expected);
+        bool hit = matcher.find(text, actual, from);
+        if (hit != naiveHit || (hit && (actual.start != expected.start || actual.length != expected.length))) {
+            if (failures < 5) printf("%s: \"%s\" from %zu: found %d at %zu+%zu, naive %d at %zu+%zu\n", setup.label,
+                                     text.c_str(), from, (int)hit, actual.start, actual.length, (int)naiveHit,
+                                     expected.start, expected.length);
+            failures++;
+            continue;
+        }
+
+        std::string stripped = matcher.strip(text);
+        std::string naiveStripped = naiveStrip(patterns, text);
+        if (stripped != naiveStripped) {
+            if (failures < 5) printf("%s: strip(\"%s\") gave \"%s\", naive \"%s\"\n", setup.label, text.c_str(),
+                                     stripped.c_str(), naiveStripped.c_str());
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main() {
+    std::mt19937 rng(SEED);
+    int failures = 0;
+
+    // "@kb" is a prefix of "@kbot" and of "@kb.t", where only the longest is right;
+    // both IDs share "<@1"
+    Setup setups[] = {
+        { "bot names", { "KinBot", "kb", "kbot", "kb.t" }, { "12", "123" }, "@kKiInNbBoOtT_. <>!123x" },
+        { "aliases", { "kinbot", "Alias", "zed", "Q9", "_u" }, { "7" }, "@kKiInNbBoOtTaAlLsSzZeEdDqQ9_u7 <>!x" },
+    };
+    for (const auto& setup : setups) failures += checkSetup(setup, rng);
+
+    // Throughput on chat lines, against the lowercase copy and find it replaced
+    const char* words[] = { "PogChamp", "lol", "hello", "what", "is", "this", "stream", "KEKW",
+                            "gg", "nice", "play", "chat", "@someone", "LUL" };
+    std::vector<std::string> lines;
+    for (int i = 0; i < CHAT_LINES; i++) {
+        std::string line;
+        int count = 2 + rng() % 14;
+        for (int w = 0; w < count; w++) {
+            line += words[rng() % 14];
+            line += ' ';
+        }
+        if (i % MENTION_EVERY == 0) line += "@KinBot hi";
+        lines.push_back(line);
+    }
+
+    MentionMatcher matcher;
+    matcher.addName("KinBot");
+    double bestOld = 0, bestNew = 0;
+    int oldHits = 0, newHits = 0;
+    for (int trial = 0; trial < 3; trial++) {
+        oldHits = 0;
+        newHits = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& line : lines) {
+            std::string lower = line;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            oldHits += lower.find("@kinbot") != std::string::npos;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (const auto& line : lines) newHits += matcher.matches(line);
+        auto t2 = std::chrono::steady_clock::now();
+
+        double oldRate = lines.size() / std::chrono::duration<double>(t1 - t0).count();
+        double newRate = lines.size() / std::chrono::duration<double>(t2 - t1).count();
+        if (oldRate > bestOld) bestOld = oldRate;
+        if (newRate > bestNew) bestNew = newRate;
+    }
+    printf("%zu chat lines, 1 in %d a mention: lowercase+find %.1fM lines/s, matcher %.1fM lines/s\n",
+           lines.size(), MENTION_EVERY, bestOld / 1e6, bestNew / 1e6);
+    if (oldHits != newHits) {
+        printf("hit counts differ: lowercase+find %d, matcher %d\n", oldHits, newHits);
+        failures++;
+    }
+
+    printf("FuzzMentionMatcher: %d failure(s) in %d strings\n", failures, ITERATIONS * 2);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Randomized check for splitMessage (MessageSplitter.cpp).
+// Builds random replies from multi-byte words, code fences and newlines and
+// checks every chunk against the chat limits. Run tests\build_tests.bat from a
+// Visual Studio x64 Native Tools prompt; exits non-zero on the first failures.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <cctype>
+#include <random>
+
+static const unsigned SEED = 42;
+static const int ITERATIONS = 20000;
+
+static bool validUtf8(const std::string& s) {
+    size_t i = 0;
+    while (i < s.size()) {
+        unsigned char c = s[i];
+        size_t len = c < 0x80 ? 1 : (c >> 5) == 6 ? 2 : (c >> 4) == 14 ? 3 : (c >> 3) == 30 ? 4 : 0;
+        if (len == 0 || i + len > s.size()) return false;
+        for (size_t k = 1; k < len; k++) {
+            if ((s[i + k] & 0xC0) != 0x80) return false;
+        }
+        i += len;
+    }
+    return true;
+}
+
+static std::string stripSpace(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (!isspace((unsigned char)c)) out += c;
+    }
+    return out;
+}
+
+static int countFences(const std::string& s) {
+    int count = 0;
+    size_t pos = 0;
+    while ((pos = s.find("```", pos)) != std::string::npos) {
+        count++;
+        pos += 3;
+    }
+    return count;
+}
+
+int main() {
+    const char* words[] = {
+        "hello", "world.", "\xC3\xBCn\xC3\xAF" "c\xC3\xB6" "d\xC3\xA9",
+        "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x80\x82",
+        "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82!",
+        "emoji\xF0\x9F\x98\x80\xF0\x9F\x8E\x89", "?", "a", "```", "```cpp\n",
+        "\n", "\n\n", "int x = 1;", "    indented",
+        "\xD9\x85\xD8\xB1\xD8\xAD\xD8\xA8\xD8\xA7", "x"
+    };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    std::mt19937 rng(SEED);
+    int failures = 0;
+
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        std::string text;
+        int count = rng() % 400;
+        for (int w = 0; w < count; w++) {
+            text += words[rng() % wordCount];
+            if (rng() % 5 != 0) text += ' ';
+        }
+        size_t maxChars = 20 + rng() % 300;
+        bool markdown = (rng() % 2) != 0;
+        bool balanced = countFences(text) % 2 == 0;
+
+        std::vector<std::string> chunks = splitMessage(text, maxChars, markdown);
+        std::string joined;
+        for (const auto& chunk : chunks) {
+            const char* problem = nullptr;
+            if (utf8Length(chunk) > maxChars) problem = "chunk over limit";
+            else if (!validUtf8(chunk)) problem = "chunk is not valid UTF-8";
+            else if (markdown && balanced && countFences(chunk) % 2 != 0) problem = "unbalanced code fence";
+
+            if (problem) {
+                if (failures < 5) printf("iteration %d: %s (max %zu)\n", iter, problem, maxChars);
+                failures++;
+            }
+            joined += chunk;
+        }
+
+        // Without markdown nothing is added, so only whitespace may differ
+        if (!markdown && stripSpace(joined) != stripSpace(text)) {
+            if (failures < 5) printf("iteration %d: content changed\n", iter);
+            failures++;
+        }
+    }
+
+    printf("splitMessage: %d iterations, %d failures\n", ITERATIONS, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+// Differential check for TriggerRules (TriggerRules.cpp).
+// Random rules (pieces, '*' gaps, [...] classes, '^'/'$' anchors) are written out
+// as profile text for the automaton and also kept as data for a naive matcher that
+// tries every position. Every random message must get the same answer from both.
+// Then times both on 1000 rules. Run tests\build_tests.bat from a Visual Studio
+// x64 Native Tools prompt; exits non-zero on any disagreement.
+
+#include "../KindroidBot.h"
+#include <cstdio>
+#include <cctype>
+#include <chrono>
+#include <random>
+
+static const unsigned SEED = 46;
+static const int ITERATIONS = 3000;
+static const int MESSAGES_PER_RULE_SET = 50;
+
+// One pattern character: the bytes it accepts, and how it is written
+struct PatternChar {
+    std::string accepts;
+    std::string text;
+};
+
+struct PatternPiece {
+    std::vector<PatternChar> chars;
+    bool wordStart;
+    bool wordEnd;
+};
+
+struct PatternRule {
+    bool ignore;
+    bool anchorStart;
+    bool anchorEnd;
+    std::vector<PatternPiece> pieces;
+};
+
+static bool isWordByte(unsigned char c) {
+    return isalnum(c) || c == '_';
+}
+
+// Earliest match of each piece in turn, each starting after the previous one ends
+// (all spellings of a piece have one length, so earliest start is earliest end)
+static bool naiveMatches(const PatternRule& rule, const std::string& message) {
+    size_t n = message.size();
+    size_t textStart = 0;
+    size_t textEnd = n;
+    while (textStart < n && isspace((unsigned char)message[textStart])) textStart++;
+    while (textEnd > textStart && isspace((unsigned char)message[textEnd - 1])) textEnd--;
+
+    size_t from = 0;
+    for (size_t p = 0; p < rule.pieces.size(); p++) {
+        const PatternPiece& piece = rule.pieces[p];
+        size_t len = piece.chars.size();
+        bool found = false;
+        for (size_t start = from; start + len <= n && !found; start++) {
+            size_t end = start + len;
+            bool ok = true;
+            for (size_t k = 0; k < len && ok; k++) {
+                char c = (char)tolower((unsigned char)message[start + k]);
+                ok = piece.chars[k].accepts.find(c) != std::string::npos;
+            }
+            if (!ok) continue;
+            if (piece.wordStart && start > 0 && isWordByte((unsigned char)message[start - 1])) continue;
+            if (piece.wordEnd && end < n && isWordByte((unsigned char)message[end])) continue;
+            if (rule.anchorStart && p == 0 && start != textStart) continue;
+            if (rule.anchorEnd && p + 1 == rule.pieces.size() && end != textEnd) continue;
+            from = end;
+            found = true;
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+static TriggerRules::Result naiveEvaluate(const std::vector<PatternRule>& rules, const std::string& message) {
+    bool triggered = false;
+    for (const auto& rule : rules) {
+        if (!naiveMatches(rule, message)) continue;
+        if (rule.ignore) return TriggerRules::IGNORED;
+        triggered = true;
+    }
+    return triggered ? TriggerRules::TRIGGERED : TriggerRules::NO_MATCH;
+}
+
+static PatternChar randomChar(std::mt19937& rng) {
+    switch (rng() % 8) {
+        case 0: return { "ab", "[ab]" };
+        case 1: return { "abc", "[a-c]" };
+        case 2: return { "b", "[b]" };
+        default: {
+            char c = "abc"[rng() % 3];
+            return { std::string(1, c), std::string(1, c) };
+        }
+    }
+}
+
+static PatternRule randomRule(std::mt19937& rng) {
+    PatternRule rule;
+    rule.ignore = rng() % 4 == 0;
+    int pieceCount = 1 + rng() % 3;
+    for (int p = 0; p < pieceCount; p++) {
+        PatternPiece piece;
+        int len = 1 + rng() % 3;
+        for (int k = 0; k < len; k++) piece.chars.push_back(randomChar(rng));
+        piece.wordStart = rng() % 3 != 0;
+        piece.wordEnd = rng() % 3 != 0;
+        rule.pieces.push_back(piece);
+    }
+    // An anchor next to an open end would pin nothing
+    rule.anchorStart = rule.pieces.front().wordStart && rng() % 4 == 0;
+    rule.anchorEnd = rule.pieces.back().wordEnd && rng() % 4 == 0;
+    return rule;
+}
+
+// Spaces around a '*' keep the neighbouring ends on word boundaries; glued ends may run on
+static std::string ruleText(const PatternRule& rule) {
+    std::string text = rule.ignore ? "ignore " : "trigger ";
+    if (rule.anchorStart) text += '^';
+    for (size_t p = 0; p < rule.pieces.size(); p++) {
+        const PatternPiece& piece = rule.pieces[p];
+        if (p == 0 && !piece.wordStart) text += '*';
+        if (p > 0) text += piece.wordStart ? " " : "";
+        for (const auto& c : piece.chars) text += c.text;
+        if (p + 1 < rule.pieces.size()) text += piece.wordEnd ? " *" : "*";
+        else if (!piece.wordEnd) text += '*';
+    }
+    if (rule.anchorEnd) text += '$';
+    return text + " cooldown=0\n";
+}
+
+static std::string randomMessage(std::mt19937& rng) {
+    const char* words[] = { "a", "b", "c", "ab", "ba", "abc", "cab", "bb", "ca", "x" };
+    const char* gaps[] = { " ", " ", " ", "  ", ",", "", "!" };
+    std::string message = rng() % 5 == 0 ? " " : "";
+    int count = 1 + rng() % 8;
+    for (int w = 0; w < count; w++) {
+        if (w > 0) message += gaps[rng() % 7];
+        message += words[rng() % 10];
+    }
+    if (rng() % 5 == 0) message += ' ';
+    for (char& c : message) {
+        if (rng() % 4 == 0) c = (char)toupper((unsigned char)c);
+    }
+    return message;
+}
+
+int main() {
+    std::mt19937 rng(SEED);
+    int failures = 0;
+
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        std::vector<PatternRule> rules;
+        std::string text;
+        int ruleCount = 1 + rng() % 4;
+        for (int r = 0; r < ruleCount; r++) {
+            rules.push_back(randomRule(rng));
+            text += ruleText(rules.back());
+        }
+
+        TriggerRules triggers;
+        std::vector<std::string> problems = triggers.load(text);
+        if (!problems.empty() || triggers.ruleCount() != rules.size()) {
+            if (failures < 5) printf("iteration %d: rules rejected: %s\n%s", iter,
+                                     problems.empty() ? "" : problems[0].c_str(), text.c_str());
+            failures++;
+            continue;
+        }
+
+        for (int m = 0; m < MESSAGES_PER_RULE_SET; m++) {
+            std::string message = randomMessage(rng);
+            TriggerRules::Result expected = naiveEvaluate(rules, message);
+            TriggerRules::Result actual = triggers.evaluate(message, "c", true, false);
+            if (actual != expected) {
+                if (failures < 5) printf("iteration %d: \"%s\" gave %d, naive %d, rules:\n%s", iter,
+                                         message.c_str(), (int)actual, (int)expected, text.c_str());
+                failures++;
+            }
+        }
+    }
+
+    // Bad lines are reported, not loaded
+    {
+        TriggerRules triggers;
+        std::vector<std::string> problems = triggers.load("trigger gr[ae\ntrigger [z-a]\ntrigger [a-z][a-z]\n");
+        if (problems.size() != 3) {
+            printf("malformed classes: %zu problem(s) reported, expected 3\n", problems.size());
+            failures++;
+        }
+    }
+
+    // Throughput on a larger rule set, against the naive matcher
+    std::vector<PatternRule> rules;
+    std::string text;
+    for (int r = 0; r < 1000; r++) {
+        PatternRule rule;
+        rule.ignore = r % 10 == 0;
+        rule.anchorStart = false;
+        rule.anchorEnd = false;
+        int pieceCount = 1 + rng() % 2;
+        for (int p = 0; p < pieceCount; p++) {
+            PatternPiece piece;
+            int len = 4 + rng() % 5;
+            for (int k = 0; k < len; k++) {
+                char c = (char)('a' + rng() % 26);
+                piece.chars.push_back({ std::string(1, c), std::string(1, c) });
+            }
+            piece.wordStart = true;
+            piece.wordEnd = true;
+            rule.pieces.push_back(piece);
+        }
+        rules.push_back(rule);
+        text += ruleText(rule);
+    }
+    TriggerRules triggers;
+    triggers.load(text);
+
+    std::vector<std::string> messages;
+    for (int i = 0; i < 2000; i++) {
+        std::string message;
+        int words = 3 + rng() % 12;
+        for (int w = 0; w < words; w++) {
+            int len = 2 + rng() % 8;
+            for (int k = 0; k < len; k++) message += (char)('a' + rng() % 26);
+            message += ' ';
+        }
+        messages.push_back(message);
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    int automatonHits = 0;
+    for (int pass = 0; pass < 10; pass++) {
+        for (const auto& message : messages) automatonHits += triggers.evaluate(message, "c", true, false) != 0;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    int naiveHits = 0;
+    for (const auto& message : messages) naiveHits += naiveEvaluate(rules, message) != 0;
+    auto t2 = std::chrono::steady_clock::now();
+
+    double automatonSecs = std::chrono::duration<double>(t1 - t0).count() / 10;
+    double naiveSecs = std::chrono::duration<double>(t2 - t1).count();
+    printf("1000 rules, %zu messages: automaton %.0f msg/s, naive %.0f msg/s\n", messages.size(),
+           messages.size() / automatonSecs, messages.size() / naiveSecs);
+    if (automatonHits != naiveHits * 10) {
+        printf("hit counts differ: automaton %d, naive %d\n", automatonHits / 10, naiveHits);
+        failures++;
+    }
+
+    printf("FuzzTriggerRules: %d failure(s) in %d rule sets\n", failures, ITERATIONS);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Discord gateway side of the mock-server tests, on top of MockTlsServer.h: the
+// /gateway/bot answer that points the bot at the local server, the WebSocket
+// upgrade, HELLO, IDENTIFY and READY, dispatches, and heartbeat ACKs. The rest of
+// Discord's REST API and Kindroid are faked by each test's HttpClient::request.
+
+#pragma once
+
+#include "MockTlsServer.h"
+
+static const char* MOCK_BOT_ID = "42";
+
+// GET /api/v10/gateway/bot: one shard, on the mock server's port
+static std::string mockGatewayBot(const std::string& port) {
+    return "{\"url\":\"wss://127.0.0.1:" + port + "\",\"shards\":1,\"session_start_limit\":"
+           "{\"total\":1000,\"remaining\":1000,\"reset_after\":0,\"max_concurrency\":1}}";
+}
+
+static int mockSequence = 0;
+
+static void sendDispatch(MockConnection& conn, const char* type, const std::string& d) {
+    std::string frame;
+    appendServerFrame(frame, std::string("{\"t\":\"") + type + "\",\"s\":" + std::to_string(++mockSequence) +
+                             ",\"op\":0,\"d\":" + d + "}");
+    conn.send(frame);
+}
+
+// MESSAGE_CREATE and MESSAGE_UPDATE body; with mention the text starts with <@bot>
+// and the bot is in d.mentions, as Discord sends it
+static std::string messageBody(const std::string& channelId, const std::string& messageId,
+                               const std::string& authorId, const std::string& text, bool mention) {
+    std::string content = mention ? std::string("<@") + MOCK_BOT_ID + "> " + text : text;
+    return "{\"id\":\"" + messageId + "\",\"channel_id\":\"" + channelId + "\",\"guild_id\":\"9\","
+           "\"author\":{\"id\":\"" + authorId + "\",\"username\":\"viewer" + authorId + "\"},"
+           "\"content\":\"" + content + "\",\"mentions\":[" +
+           (mention ? std::string("{\"id\":\"") + MOCK_BOT_ID + "\",\"username\":\"kinbot\"}" : std::string()) + "]}";
+}
+
+// Reads client frames until text holds marker; false once the bot is gone
+static bool waitForFrames(MockConnection& conn, std::string& text, const char* marker) {
+    while (text.find(marker) == std::string::npos) {
+        if (!conn.receive()) return false;
+        decodeClientFrames(conn.plain, text);
+    }
+    return true;
+}
+
+// Upgrade, HELLO, the bot's IDENTIFY, then READY; false if the bot went away first
+static bool greetBot(MockConnection& conn, const std::string& port) {
+    // The upgrade request is plain HTTP, not a frame; nothing else is in flight yet
+    while (conn.plain.find("\r\n\r\n") == std::string::npos) {
+        if (!conn.receive()) return false;
+    }
+    conn.plain.clear();
+    conn.send("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n");
+
+    std::string hello;
+    appendServerFrame(hello, "{\"t\":null,\"s\":null,\"op\":10,\"d\":{\"heartbeat_interval\":45000}}");
+    conn.send(hello);
+    std::string text;
+    if (!waitForFrames(conn, text, "\"op\":2")) return false;
+    sendDispatch(conn, "READY", std::string("{\"v\":10,\"user\":{\"id\":\"") + MOCK_BOT_ID +
+                                "\",\"username\":\"kinbot\"},\"session_id\":\"replay\","
+                                "\"resume_gateway_url\":\"wss://127.0.0.1:" + port + "\"}");
+    return true;
+}
+
+// ACKs heartbeats until the bot hangs up
+static void answerHeartbeats(MockConnection& conn) {
+    std::string text;
+    while (conn.receive()) {
+        decodeClientFrames(conn.plain, text);
+        if (text.find("\"op\":1,") != std::string::npos) {
+            std::string ack;
+            appendServerFrame(ack, "{\"t\":null,\"s\":null,\"op\":11,\"d\":null}");
+            conn.send(ack);
+        }
+        text.clear();
+    }
+}
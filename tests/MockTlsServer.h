@@ -0,0 +1,345 @@
+// Server side of a local TLS endpoint for the mock-server tests: a self-signed
+// certificate, Schannel server credentials, one accepted connection that sends and
+// receives plaintext, and WebSocket framing. Stands in for Twitch or Discord on
+// 127.0.0.1 (the bots take a setServer() override). Included by one test each.
+
+#pragma once
+
+#include "../KindroidBot.h"
+#define SECURITY_WIN32
+#include <schannel.h>
+#include <security.h>
+#include <wincrypt.h>
+
+#pragma comment(lib, "advapi32.lib")
+#pragma comment(lib, "secur32.lib")
+#pragma comment(lib, "crypt32.lib")
+
+static const DWORD MOCK_TIMEOUT_MS = 30000;
+
+// ============================================
+// Self-signed server certificate (the bot validates certificates manually)
+// ============================================
+
+static PCCERT_CONTEXT createCertificate(const wchar_t* keyContainer) {
+    HCRYPTPROV prov = 0;
+    
+    // A fresh container each run so a stale key never gets in the way
+    CryptAcquireContextW(&prov, keyContainer, MS_ENH_RSA_AES_PROV_W, PROV_RSA_AES, CRYPT_DELETEKEYSET);
+    if (!CryptAcquireContextW(&prov, keyContainer, MS_ENH_RSA_AES_PROV_W, PROV_RSA_AES, CRYPT_NEWKEYSET)) {
+        return nullptr;
+    }
+    HCRYPTKEY key = 0;
+    if (!CryptGenKey(prov, AT_KEYEXCHANGE, (2048 << 16) | CRYPT_EXPORTABLE, &key)) {
+        CryptReleaseContext(prov, 0);
+        return nullptr;
+    }
+    CryptDestroyKey(key);
+    
+    BYTE nameBuffer[256];
+    DWORD nameSize = sizeof(nameBuffer);
+    if (!CertStrToNameW(X509_ASN_ENCODING, L"CN=localhost", CERT_X500_NAME_STR, NULL,
+                        nameBuffer, &nameSize, NULL)) {
+        CryptReleaseContext(prov, 0);
+        return nullptr;
+    }
+    CERT_NAME_BLOB name = { nameSize, nameBuffer };
+    
+    CRYPT_KEY_PROV_INFO keyInfo = {0};
+    keyInfo.pwszContainerName = (LPWSTR)keyContainer;
+    keyInfo.pwszProvName = (LPWSTR)MS_ENH_RSA_AES_PROV_W;
+    keyInfo.dwProvType = PROV_RSA_AES;
+    keyInfo.dwKeySpec = AT_KEYEXCHANGE;
+    
+    PCCERT_CONTEXT cert = CertCreateSelfSignCertificate(prov, &name, 0, &keyInfo, NULL, NULL, NULL, NULL);
+    CryptReleaseContext(prov, 0);
+    return cert;
+}
+
+static void deleteKeyContainer(const wchar_t* keyContainer) {
+    HCRYPTPROV prov = 0;
+    CryptAcquireContextW(&prov, keyContainer, MS_ENH_RSA_AES_PROV_W, PROV_RSA_AES, CRYPT_DELETEKEYSET);
+}
+
+// ============================================
+// One TLS connection, server side
+// ============================================
+
+static bool sendAll(SOCKET sock, const BYTE* data, int len) {
+    while (len > 0) {
+        int sent = ::send(sock, (const char*)data, len, 0);
+        if (sent <= 0) return false;
+        data += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+class MockConnection {
+public:
+    SOCKET sock = INVALID_SOCKET;
+    std::string plain; // Decrypted bytes from the bot not consumed yet
+    
+    ~MockConnection() {
+        if (haveContext) DeleteSecurityContext(&context);
+        if (sock != INVALID_SOCKET) closesocket(sock);
+    }
+    
+    bool accept(SOCKET listener, CredHandle* credentials) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listener, &readable);
+        timeval wait = { (long)(MOCK_TIMEOUT_MS / 1000), 0 };
+        if (select(0, &readable, NULL, NULL, &wait) <= 0) return false;
+        
+        sock = ::accept(listener, NULL, NULL);
+        if (sock == INVALID_SOCKET) return false;
+        DWORD timeout = MOCK_TIMEOUT_MS;
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+        return handshake(credentials);
+    }
+    
+    // Encrypts and sends data, one TLS record per cbMaximumMessage bytes
+    bool send(const char* data, size_t len) {
+        while (len > 0) {
+            DWORD chunk = (DWORD)(len < sizes.cbMaximumMessage ? len : sizes.cbMaximumMessage);
+            memcpy(record.data() + sizes.cbHeader, data, chunk);
+            
+            SecBuffer bufs[4] = {0};
+            bufs[0].BufferType = SECBUFFER_STREAM_HEADER;
+            bufs[0].pvBuffer = record.data();
+            bufs[0].cbBuffer = sizes.cbHeader;
+            bufs[1].BufferType = SECBUFFER_DATA;
+            bufs[1].pvBuffer = record.data() + sizes.cbHeader;
+            bufs[1].cbBuffer = chunk;
+            bufs[2].BufferType = SECBUFFER_STREAM_TRAILER;
+            bufs[2].pvBuffer = record.data() + sizes.cbHeader + chunk;
+            bufs[2].cbBuffer = sizes.cbTrailer;
+            bufs[3].BufferType = SECBUFFER_EMPTY;
+            SecBufferDesc desc = { SECBUFFER_VERSION, 4, bufs };
+            
+            if (EncryptMessage(&context, 0, &desc, 0) != SEC_E_OK) return false;
+            if (!sendAll(sock, record.data(), (int)(bufs[0].cbBuffer + bufs[1].cbBuffer + bufs[2].cbBuffer))) {
+                return false;
+            }
+            data += chunk;
+            len -= chunk;
+        }
+        return true;
+    }
+    
+    bool send(const std::string& data) { return send(data.data(), data.size()); }
+    
+    // Decrypts the next record from the bot into plain; false once the bot is gone
+    bool receive() {
+        while (true) {
+            if (inLen > 0) {
+                SecBuffer bufs[4] = {0};
+                bufs[0].BufferType = SECBUFFER_DATA;
+                bufs[0].pvBuffer = in.data();
+                bufs[0].cbBuffer = inLen;
+                bufs[1].BufferType = SECBUFFER_EMPTY;
+                bufs[2].BufferType = SECBUFFER_EMPTY;
+                bufs[3].BufferType = SECBUFFER_EMPTY;
+                SecBufferDesc desc = { SECBUFFER_VERSION, 4, bufs };
+                
+                SECURITY_STATUS status = DecryptMessage(&context, &desc, 0, NULL);
+                if (status == SEC_E_OK) {
+                    DWORD extra = 0;
+                    for (int i = 1; i < 4; i++) {
+                        if (bufs[i].BufferType == SECBUFFER_DATA) {
+                            plain.append((const char*)bufs[i].pvBuffer, bufs[i].cbBuffer);
+                        } else if (bufs[i].BufferType == SECBUFFER_EXTRA) {
+                            extra = bufs[i].cbBuffer;
+                        }
+                    }
+                    memmove(in.data(), in.data() + (inLen - extra), extra);
+                    inLen = extra;
+                    return true;
+                }
+                if (status != SEC_E_INCOMPLETE_MESSAGE) return false;
+            }
+            
+            if (inLen == in.size()) in.resize(in.size() * 2);
+            int received = ::recv(sock, (char*)in.data() + inLen, (int)(in.size() - inLen), 0);
+            if (received <= 0) return false;
+            inLen += received;
+        }
+    }
+
+private:
+    CtxtHandle context;
+    bool haveContext = false;
+    SecPkgContext_StreamSizes sizes = {0};
+    std::vector<BYTE> in = std::vector<BYTE>(32768);
+    DWORD inLen = 0;
+    std::vector<BYTE> record;
+    
+    bool handshake(CredHandle* credentials) {
+        DWORD flags = ASC_REQ_SEQUENCE_DETECT | ASC_REQ_REPLAY_DETECT | ASC_REQ_CONFIDENTIALITY |
+                      ASC_REQ_EXTENDED_ERROR | ASC_REQ_ALLOCATE_MEMORY | ASC_REQ_STREAM;
+        SECURITY_STATUS status = SEC_E_INCOMPLETE_MESSAGE;
+        
+        while (true) {
+            if (inLen == 0 || status == SEC_E_INCOMPLETE_MESSAGE) {
+                if (inLen == in.size()) in.resize(in.size() * 2);
+                int received = ::recv(sock, (char*)in.data() + inLen, (int)(in.size() - inLen), 0);
+                if (received <= 0) return false;
+                inLen += received;
+            }
+            
+            SecBuffer inBuffers[2] = {0};
+            inBuffers[0].BufferType = SECBUFFER_TOKEN;
+            inBuffers[0].pvBuffer = in.data();
+            inBuffers[0].cbBuffer = inLen;
+            inBuffers[1].BufferType = SECBUFFER_EMPTY;
+            SecBufferDesc inDesc = { SECBUFFER_VERSION, 2, inBuffers };
+            
+            SecBuffer outBuffer = {0};
+            outBuffer.BufferType = SECBUFFER_TOKEN;
+            SecBufferDesc outDesc = { SECBUFFER_VERSION, 1, &outBuffer };
+            
+            DWORD outFlags = 0;
+            status = AcceptSecurityContext(credentials, haveContext ? &context : NULL, &inDesc, flags, 0,
+                                           &context, &outDesc, &outFlags, NULL);
+            if (status == SEC_E_INCOMPLETE_MESSAGE) continue;
+            if (status != SEC_E_OK && status != SEC_I_CONTINUE_NEEDED) return false;
+            haveContext = true;
+            
+            if (outBuffer.cbBuffer > 0 && outBuffer.pvBuffer) {
+                bool sent = sendAll(sock, (const BYTE*)outBuffer.pvBuffer, (int)outBuffer.cbBuffer);
+                FreeContextBuffer(outBuffer.pvBuffer);
+                if (!sent) return false;
+            }
+            
+            if (inBuffers[1].BufferType == SECBUFFER_EXTRA) {
+                memmove(in.data(), in.data() + (inLen - inBuffers[1].cbBuffer), inBuffers[1].cbBuffer);
+                inLen = inBuffers[1].cbBuffer;
+            } else {
+                inLen = 0;
+            }
+            
+            if (status == SEC_E_OK) {
+                QueryContextAttributes(&context, SECPKG_ATTR_STREAM_SIZES, &sizes);
+                record.resize(sizes.cbHeader + sizes.cbMaximumMessage + sizes.cbTrailer);
+                return true;
+            }
+        }
+    }
+};
+
+static bool acquireServerCredentials(PCCERT_CONTEXT cert, CredHandle* credentials) {
+    SCHANNEL_CRED cred = {0};
+    cred.dwVersion = SCHANNEL_CRED_VERSION;
+    cred.cCreds = 1;
+    cred.paCred = &cert;
+    cred.grbitEnabledProtocols = SP_PROT_TLS1_2_SERVER; // What the bot offers
+    
+    return AcquireCredentialsHandleA(NULL, (LPSTR)UNISP_NAME_A, SECPKG_CRED_INBOUND,
+                                     NULL, &cred, NULL, NULL, credentials, NULL) == SEC_E_OK;
+}
+
+// A loopback listener on a free port; INVALID_SOCKET if none could be opened
+static SOCKET openLoopbackListener(int backlog, std::string& port) {
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET) return INVALID_SOCKET;
+    sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    int addrLen = sizeof(addr);
+    if (bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, backlog) != 0 ||
+        getsockname(listener, (sockaddr*)&addr, &addrLen) != 0) {
+        closesocket(listener);
+        return INVALID_SOCKET;
+    }
+    port = std::to_string(ntohs(addr.sin_port));
+    return listener;
+}
+
+// ============================================
+// The bot's end of a loopback connection (the transport benchmarks)
+// ============================================
+
+// The bot's own Schannel client on one end, a MockConnection on the other
+struct LoopbackPair {
+    MockConnection server;
+    SOCKET sock = INVALID_SOCKET;
+    SchannelContext* client = nullptr;
+    
+    ~LoopbackPair() {
+        if (client) SchannelDestroy(client);
+        if (sock != INVALID_SOCKET) closesocket(sock);
+    }
+};
+
+// Accepts on a helper thread while this one connects and handshakes as the bots do.
+// targetName keys Schannel's client session cache, so a new name means a full handshake.
+static bool openLoopbackPair(LoopbackPair& pair, SOCKET listener, const std::string& port,
+                             CredHandle* credentials, const char* targetName = "127.0.0.1") {
+    bool accepted = false;
+    std::thread acceptor([&]() { accepted = pair.server.accept(listener, credentials); });
+    
+    pair.sock = NetConnect("127.0.0.1", port);
+    bool connected = false;
+    if (pair.sock != INVALID_SOCKET) {
+        pair.client = SchannelCreate(pair.sock);
+        connected = pair.client && SchannelHandshake(pair.client, targetName);
+    }
+    if (!connected && pair.sock != INVALID_SOCKET) shutdown(pair.sock, SD_BOTH); // Unblocks the acceptor
+    acceptor.join();
+    return connected && accepted;
+}
+
+// ============================================
+// WebSocket framing
+// ============================================
+
+// Server-to-client WebSocket text frame (unmasked), as irc-ws.chat.twitch.tv sends
+static void appendServerFrame(std::string& out, const std::string& payload) {
+    size_t len = payload.size();
+    out += (char)0x81;
+    if (len < 126) {
+        out += (char)len;
+    } else if (len <= 0xFFFF) {
+        out += (char)126;
+        out += (char)(len >> 8);
+        out += (char)(len & 0xFF);
+    } else {
+        out += (char)127;
+        for (int i = 7; i >= 0; i--) out += (char)((len >> (i * 8)) & 0xFF);
+    }
+    out += payload;
+}
+
+// Unmasks the complete client frames at the front of wire into text
+static void decodeClientFrames(std::string& wire, std::string& text) {
+    size_t pos = 0;
+    while (wire.size() - pos >= 2) {
+        unsigned char second = (unsigned char)wire[pos + 1];
+        uint64_t len = second & 0x7F;
+        size_t headerLen = 2;
+        if (len == 126) {
+            if (wire.size() - pos < 4) break;
+            len = ((unsigned char)wire[pos + 2] << 8) | (unsigned char)wire[pos + 3];
+            headerLen = 4;
+        } else if (len == 127) {
+            if (wire.size() - pos < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = (len << 8) | (unsigned char)wire[pos + 2 + i];
+            headerLen = 10;
+        }
+        bool masked = (second & 0x80) != 0;
+        size_t maskAt = pos + headerLen;
+        if (masked) headerLen += 4;
+        if (wire.size() - pos < headerLen + len) break;
+        
+        for (size_t i = 0; i < len; i++) {
+            char c = wire[pos + headerLen + i];
+            if (masked) c ^= wire[maskAt + (i % 4)];
+            text += c;
+        }
+        pos += headerLen + (size_t)len;
+    }
+    wire.erase(0, pos);
+}
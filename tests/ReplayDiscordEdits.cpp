@@ -0,0 +1,267 @@
+// Mock-gateway replay of Discord edits and deletes against queued and running
+// replies. A local TLS server stands in for the gateway (HELLO, READY, then
+// MESSAGE_CREATE/UPDATE/DELETE dispatches); Discord's REST API and Kindroid are
+// faked in this file (HttpClient::request), and Kindroid takes KINDROID_MS per
+// answer. Each channel gets its mentions, and while its first answer is still with
+// Kindroid the gateway sends that channel's edits or deletes. Checks which questions
+// reach Kindroid and which answers are posted, in order: deleting the running or a
+// queued mention, editing either, a burst of edits, an edit that drops the mention,
+// an embed-only update, and mentions past the per-channel reply depth. Run
+// tests\build_tests.bat from a Visual Studio x64 Native Tools prompt; exits non-zero
+// on any failed check.
+
+#include "MockDiscordGateway.h"
+#include <cstdio>
+#include <map>
+
+#pragma comment(lib, "user32.lib")
+
+bool g_debugMode = false; // Normally Main.cpp's; off so chat lines are not logged
+
+static const DWORD KINDROID_MS = 600;
+static const DWORD RUNNING_AFTER_MS = 100; // First mention goes alone, so it is running when the rest arrive
+static const DWORD EVENTS_AFTER_MS = 100;  // Edits and deletes, still inside the first answer's KINDROID_MS
+static const DWORD EDIT_GAP_MS = 300;      // Between the edits of a burst; it outlasts KINDROID_MS
+static const DWORD DEADLINE_MS = 60000;
+static const wchar_t* KEY_CONTAINER = L"KinBotManagerDiscordReplay";
+
+// Each mention asks "<channel> question <k>"; edits replace <k> with a new token.
+// A step is "d<k>" (delete), "e<k><token>" (edit), "n<k>" (edit without the mention),
+// "u<k>" (embed-only update) or "x" (delete of a message nobody asked about).
+struct Scenario {
+    int mentions;
+    const char* steps;    // Space separated, sent EDIT_GAP_MS apart
+    const char* asked;    // Question tokens that reach Kindroid, in call order
+    const char* answered; // Answer tokens posted, in order
+};
+
+static const Scenario SCENARIOS[] = {
+    { 3, "", "012", "012" },
+    { 3, "d0", "012", "12" },
+    { 3, "d1", "02", "02" },
+    { 3, "e1b", "0b2", "0b2" },
+    { 3, "e0b", "0b12", "b12" },
+    { 3, "e1b e1c e1d e1e", "0e2", "0e2" },
+    { 3, "n2", "01", "01" },
+    { 3, "u1 x", "012", "012" },
+    { 8, "", "012345", "012345" }, // One running and five waiting; the last two are skipped
+};
+static const int CHANNELS = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+static std::string gatewayPort;
+
+// ============================================
+// Fake REST: Discord's API and Kindroid
+// ============================================
+
+static std::mutex seenMutex;
+static std::map<std::string, std::string> asked;    // Channel -> question tokens, in call order
+static std::map<std::string, std::string> answered; // Channel -> answer tokens, in post order
+static size_t answerCount = 0;
+
+// "... <channel> question <token>" -> channel and token
+static void splitQuestion(const std::string& text, std::string& channel, std::string& token) {
+    size_t question = text.rfind(" question ");
+    size_t channelStart = text.rfind(' ', question - 1);
+    channel = text.substr(channelStart + 1, question - channelStart - 1);
+    token = text.substr(question + 10);
+}
+
+std::string HttpClient::request(const std::string& method, const std::string& host, const std::string& path,
+                                const std::string& headers, const std::string& body, DWORD* statusCode) {
+    if (statusCode) *statusCode = 200;
+    std::string channel, token;
+
+    if (host == "discord.com") {
+        if (path == "/api/v10/gateway/bot") {
+            return mockGatewayBot(gatewayPort);
+        }
+        if (path.size() > 9 && path.compare(path.size() - 9, 9, "/messages") == 0) {
+            // The outbox may merge queued answers into one post, one per line
+            std::string content = SimpleJSON::getString(SimpleJSON::parseObject(body), "content");
+            std::lock_guard<std::mutex> lock(seenMutex);
+            size_t lineStart = 0;
+            while (lineStart < content.size()) {
+                size_t lineEnd = content.find('\n', lineStart);
+                if (lineEnd == std::string::npos) lineEnd = content.size();
+                splitQuestion(content.substr(lineStart, lineEnd - lineStart), channel, token);
+                answered[channel] += token;
+                answerCount++;
+                lineStart = lineEnd + 1;
+            }
+            return "{\"id\":\"1\"}";
+        }
+        if (path.size() > 7 && path.compare(path.size() - 7, 7, "/typing") == 0) {
+            if (statusCode) *statusCode = 204;
+            return "";
+        }
+        // Channel and guild lookups for the reply context
+        return path.find("/guilds/") != std::string::npos ? "{\"name\":\"Replay\"}"
+                                                          : "{\"name\":\"general\",\"guild_id\":\"9\"}";
+    }
+
+    // Kindroid: KindroidAPI wraps the text as "<Message to you from ... in channel ...> text"
+    std::string message = SimpleJSON::getString(SimpleJSON::parseObject(body), "message");
+    splitQuestion(message, channel, token);
+    {
+        std::lock_guard<std::mutex> lock(seenMutex);
+        asked[channel] += token;
+    }
+    Sleep(KINDROID_MS);
+
+    std::string response;
+    JsonWriter(response).beginObject().key("response_text").string("re: " + channel + " question " + token).endObject();
+    return response;
+}
+
+void HttpClient::prewarm(const std::string& host) {
+}
+
+// ============================================
+// Mock gateway
+// ============================================
+
+static std::string channelId(int i) {
+    return std::to_string(7000 + i);
+}
+
+static std::string messageId(int i, int k) {
+    return std::to_string(900000 + i * 100 + k);
+}
+
+// A mention asks "ch<i> question <token>"; without one the same text is just chat
+static std::string questionBody(int i, int k, const std::string& token, bool mention) {
+    return messageBody(channelId(i), messageId(i, k), std::to_string(1000 + k),
+                       (mention ? "ch" : "hi ch") + std::to_string(i) + " question " + token, mention);
+}
+
+static std::string refBody(int i, const std::string& id) {
+    return "{\"id\":\"" + id + "\",\"channel_id\":\"" + channelId(i) + "\",\"guild_id\":\"9\"}";
+}
+
+static void sendStep(MockConnection& conn, int i, const std::string& step) {
+    int k = step.size() > 1 ? step[1] - '0' : 0;
+    switch (step[0]) {
+        case 'd': sendDispatch(conn, "MESSAGE_DELETE", refBody(i, messageId(i, k))); break;
+        case 'e': sendDispatch(conn, "MESSAGE_UPDATE", questionBody(i, k, step.substr(2), true)); break;
+        case 'n': sendDispatch(conn, "MESSAGE_UPDATE", questionBody(i, k, step.substr(2), false)); break;
+        case 'u': sendDispatch(conn, "MESSAGE_UPDATE", refBody(i, messageId(i, k)).insert(1, "\"embeds\":[],")); break;
+        case 'x': sendDispatch(conn, "MESSAGE_DELETE", refBody(i, messageId(i, 99))); break;
+    }
+}
+
+// Greets the bot, runs the script, then answers heartbeats
+static void serveGateway(MockConnection* conn, bool* ready) {
+    if (!greetBot(*conn, gatewayPort)) return;
+    *ready = true;
+
+    for (int i = 0; i < CHANNELS; i++) sendDispatch(*conn, "MESSAGE_CREATE", questionBody(i, 0, "0", true));
+    Sleep(RUNNING_AFTER_MS);
+    for (int i = 0; i < CHANNELS; i++) {
+        for (int k = 1; k < SCENARIOS[i].mentions; k++) {
+            sendDispatch(*conn, "MESSAGE_CREATE", questionBody(i, k, std::to_string(k), true));
+        }
+    }
+    Sleep(EVENTS_AFTER_MS);
+
+    // Step n of every channel goes out together, EDIT_GAP_MS after step n-1
+    for (size_t n = 0; ; n++) {
+        bool any = false;
+        for (int i = 0; i < CHANNELS; i++) {
+            std::string steps = SCENARIOS[i].steps;
+            size_t start = 0;
+            for (size_t skip = 0; skip < n && start != std::string::npos; skip++) {
+                start = steps.find(' ', start);
+                if (start != std::string::npos) start++;
+            }
+            if (start == std::string::npos || start >= steps.size()) continue;
+            sendStep(*conn, i, steps.substr(start, steps.find(' ', start) - start));
+            any = true;
+        }
+        if (!any) break;
+        Sleep(EDIT_GAP_MS);
+    }
+
+    answerHeartbeats(*conn);
+}
+
+int main() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("WSAStartup failed\n");
+        return 1;
+    }
+
+    PCCERT_CONTEXT cert = createCertificate(KEY_CONTAINER);
+    CredHandle credentials;
+    SOCKET listener = INVALID_SOCKET;
+    if (!cert || !acquireServerCredentials(cert, &credentials) ||
+        (listener = openLoopbackListener(1, gatewayPort)) == INVALID_SOCKET) {
+        printf("Could not set up the mock server (error %lu)\n", GetLastError());
+        if (cert) CertFreeCertificateContext(cert);
+        deleteKeyContainer(KEY_CONTAINER);
+        WSACleanup();
+        return 1;
+    }
+
+    size_t expectedAnswers = 0;
+    for (int i = 0; i < CHANNELS; i++) expectedAnswers += strlen(SCENARIOS[i].answered);
+
+    KindroidAPI kindroid("replay-key", "replay-ai", "https://kindroid.invalid/v1");
+    DiscordBot* bot = new DiscordBot("replay-token", &kindroid, NULL);
+    bot->start();
+
+    int failures = 0;
+    bool ready = false;
+    MockConnection conn;
+    std::thread server;
+    if (conn.accept(listener, &credentials)) {
+        server = std::thread(serveGateway, &conn, &ready);
+    } else {
+        printf("TLS accept failed\n");
+        failures++;
+    }
+
+    // Wait for the answers that should come, then long enough for one that shouldn't
+    ULONGLONG start = GetTickCount64();
+    while (failures == 0 && GetTickCount64() - start < DEADLINE_MS) {
+        {
+            std::lock_guard<std::mutex> lock(seenMutex);
+            if (answerCount >= expectedAnswers) break;
+        }
+        Sleep(50);
+    }
+    Sleep(3 * KINDROID_MS);
+
+    bot->stop();
+    if (server.joinable()) server.join();
+    delete bot;
+
+    if (failures == 0 && !ready) {
+        printf("the bot never identified\n");
+        failures++;
+    }
+    size_t calls = 0;
+    if (failures == 0) {
+        for (int i = 0; i < CHANNELS; i++) {
+            std::string channel = "ch" + std::to_string(i);
+            calls += asked[channel].size();
+            if (asked[channel] != SCENARIOS[i].asked || answered[channel] != SCENARIOS[i].answered) {
+                printf("%s (%s): asked \"%s\", answered \"%s\"; expected \"%s\" and \"%s\"\n", channel.c_str(),
+                       SCENARIOS[i].steps[0] ? SCENARIOS[i].steps : "no edits", asked[channel].c_str(),
+                       answered[channel].c_str(), SCENARIOS[i].asked, SCENARIOS[i].answered);
+                failures++;
+            }
+        }
+    }
+    printf("%zu Kindroid calls, %zu answers posted\n", calls, answerCount);
+
+    closesocket(listener);
+    FreeCredentialsHandle(&credentials);
+    CertFreeCertificateContext(cert);
+    deleteKeyContainer(KEY_CONTAINER);
+    WSACleanup();
+
+    printf("ReplayDiscordEdits: %d failure(s) in %d channels\n", failures, CHANNELS);
+    return failures == 0 ? 0 : 1;
+}
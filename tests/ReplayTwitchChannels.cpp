@@ -0,0 +1,298 @@
+// Mock-server replay for TwitchBot across many channels (raw IRC over TLS). A local
+// TLS server stands in for Twitch and takes every connection the bot opens for 300
+// channels at 100 per connection. When a channel's JOIN arrives, every third channel
+// is asked three numbered questions by different viewers. Kindroid is faked in this
+// file (HttpClient::request answers each question, later ones faster), so nothing
+// leaves the machine. Checks that:
+//   - each connection joins exactly its own block of channels, each channel once;
+//   - no JOIN window or PRIVMSG window holds more than the account limit;
+//   - every answer comes back on the channel's connection, in the order asked.
+// The limits are Twitch's counts with shorter windows (setRateLimits), so the run
+// takes seconds. Run tests\build_tests.bat from a Visual Studio x64 Native Tools
+// prompt; exits non-zero on any failed check.
+
+#include "MockTlsServer.h"
+#include <cstdio>
+#include <algorithm>
+#include <map>
+
+#pragma comment(lib, "user32.lib")
+
+bool g_debugMode = false; // Normally Main.cpp's; off so chat lines are not logged
+
+static const int CHANNELS = 300;
+static const int CHANNELS_PER_CONNECTION = 100;
+static const int CONNECTIONS = (CHANNELS + CHANNELS_PER_CONNECTION - 1) / CHANNELS_PER_CONNECTION;
+static const int ASKED_EVERY = 3;    // Every third channel gets questions
+static const int QUESTIONS = 3;      // Per asked channel, one viewer each
+static const size_t JOINS = 20;      // Twitch: 20 JOINs per 10 s
+static const DWORD JOIN_WINDOW_MS = 500;
+static const size_t MESSAGES = 20;   // Twitch: 20 PRIVMSGs per 30 s
+static const DWORD MESSAGE_WINDOW_MS = 500;
+static const DWORD CLOCK_SLACK_MS = 40; // Times are taken on receipt, with a coarse tick
+static const DWORD DEADLINE_MS = 60000;
+static const wchar_t* KEY_CONTAINER = L"KinBotManagerChannelReplay";
+
+// ============================================
+// Fake Kindroid: answers "<channel> question <k>" with "re: <channel> question <k>"
+// ============================================
+
+std::string HttpClient::request(const std::string& method, const std::string& host, const std::string& path,
+                                const std::string& headers, const std::string& body, DWORD* statusCode) {
+    // KindroidAPI wraps the text as "<Message to you from ... in channel ...> text"
+    std::map<std::string, std::string> fields = SimpleJSON::parseObject(body);
+    std::string message = SimpleJSON::getString(fields, "message");
+    size_t textStart = message.find("> ");
+    std::string question = textStart == std::string::npos ? message : message.substr(textStart + 2);
+
+    // Later questions come back sooner, so an unordered queue would overtake
+    int k = atoi(question.c_str() + question.rfind(' ') + 1);
+    Sleep((DWORD)(QUESTIONS - k) * 20);
+
+    if (statusCode) *statusCode = 200;
+    std::string response;
+    JsonWriter(response).beginObject().key("response_text").string("re: " + question).endObject();
+    return response;
+}
+
+void HttpClient::prewarm(const std::string& host) {
+}
+
+// ============================================
+// What the mock server saw
+// ============================================
+
+struct Seen {
+    ULONGLONG time;
+    int connection;
+    std::string channel;
+    std::string text; // PRIVMSG text, empty for JOIN
+};
+
+static std::mutex seenMutex;
+static std::vector<Seen> joins;
+static std::vector<Seen> replies;
+
+static std::string channelName(int i) {
+    char name[16];
+    snprintf(name, sizeof(name), "ch%03d", i);
+    return name;
+}
+
+static std::string questionLine(const std::string& channel, int k) {
+    std::string user = "viewer" + std::to_string(k);
+    return "@display-name=Viewer" + std::to_string(k) + ";id=" + channel + "-" + std::to_string(k) +
+           ";user-id=" + std::to_string(1000 + k) + " :" + user + "!" + user + "@" + user +
+           ".tmi.twitch.tv PRIVMSG #" + channel + " :@kinbot " + channel + " question " + std::to_string(k) +
+           "\r\n";
+}
+
+// Reads one connection's lines until the bot hangs up
+static void serveConnection(MockConnection* conn, int index) {
+    std::string text;
+    while (conn->receive()) {
+        text += conn->plain;
+        conn->plain.clear();
+
+        size_t lineStart = 0;
+        size_t lineEnd;
+        while ((lineEnd = text.find("\r\n", lineStart)) != std::string::npos) {
+            std::string line = text.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 2;
+            ULONGLONG now = GetTickCount64();
+
+            if (line.compare(0, 5, "NICK ") == 0) {
+                conn->send(":tmi.twitch.tv 001 kinbot :Welcome, GLHF!\r\n");
+            } else if (line.compare(0, 6, "JOIN #") == 0) {
+                std::string channel = line.substr(6);
+                {
+                    std::lock_guard<std::mutex> lock(seenMutex);
+                    joins.push_back({ now, index, channel, "" });
+                }
+                if (atoi(channel.c_str() + 2) % ASKED_EVERY == 0) {
+                    std::string questions;
+                    for (int k = 0; k < QUESTIONS; k++) questions += questionLine(channel, k);
+                    conn->send(questions);
+                }
+            } else if (line.compare(0, 9, "PRIVMSG #") == 0) {
+                size_t colon = line.find(" :");
+                if (colon == std::string::npos) continue;
+                std::lock_guard<std::mutex> lock(seenMutex);
+                replies.push_back({ now, index, line.substr(9, colon - 9), line.substr(colon + 2) });
+            }
+        }
+        text.erase(0, lineStart);
+    }
+}
+
+// ============================================
+// Checks
+// ============================================
+
+// Any limit+1 events closer together than the window broke the limit
+static int checkPacing(const char* what, const std::vector<Seen>& events, size_t limit, DWORD windowMs) {
+    std::vector<ULONGLONG> times;
+    for (const auto& e : events) times.push_back(e.time);
+    std::sort(times.begin(), times.end());
+
+    int failures = 0;
+    for (size_t i = 0; i + limit < times.size(); i++) {
+        ULONGLONG span = times[i + limit] - times[i];
+        if (span + CLOCK_SLACK_MS < windowMs) {
+            if (failures < 5) printf("%s: %zu within %llu ms (limit %zu per %lu ms)\n", what, limit + 1,
+                                     span, limit, windowMs);
+            failures++;
+        }
+    }
+    if (!times.empty()) {
+        printf("%zu %s over %llu ms (at least %lu ms at the limit)\n", times.size(), what,
+               times.back() - times.front(), (DWORD)((times.size() - 1) / limit) * windowMs);
+    }
+    return failures;
+}
+
+// Each connection must join one block of CHANNELS_PER_CONNECTION channels, in list order
+static int checkSpreading(std::map<std::string, int>& owner) {
+    int failures = 0;
+    std::vector<std::vector<std::string>> joined(CONNECTIONS);
+    for (const auto& join : joins) {
+        if (!owner.insert({ join.channel, join.connection }).second) {
+            printf("#%s joined twice\n", join.channel.c_str());
+            failures++;
+        }
+        joined[join.connection].push_back(join.channel);
+    }
+    if ((int)owner.size() != CHANNELS) {
+        printf("%zu of %d channels joined\n", owner.size(), CHANNELS);
+        failures++;
+    }
+
+    std::vector<bool> blockTaken(CONNECTIONS, false);
+    for (int c = 0; c < CONNECTIONS; c++) {
+        const auto& names = joined[c];
+        int block = names.empty() ? -1 : atoi(names[0].c_str() + 2) / CHANNELS_PER_CONNECTION;
+        bool ok = block >= 0 && block < CONNECTIONS && !blockTaken[block] &&
+                  (int)names.size() == CHANNELS_PER_CONNECTION;
+        for (size_t i = 0; ok && i < names.size(); i++) {
+            ok = names[i] == channelName(block * CHANNELS_PER_CONNECTION + (int)i);
+        }
+        if (!ok) {
+            printf("connection %d joined %zu channel(s), not one block of %d in order\n", c, names.size(),
+                   CHANNELS_PER_CONNECTION);
+            failures++;
+            continue;
+        }
+        blockTaken[block] = true;
+    }
+    return failures;
+}
+
+// Every asked channel gets its answers, on its own connection, in the order asked
+static int checkReplies(const std::map<std::string, int>& owner) {
+    int failures = 0;
+    std::map<std::string, std::vector<std::string>> answers;
+    for (const auto& reply : replies) {
+        auto it = owner.find(reply.channel);
+        if (it == owner.end() || it->second != reply.connection) {
+            printf("reply for #%s on connection %d, which never joined it\n", reply.channel.c_str(),
+                   reply.connection);
+            failures++;
+        }
+        answers[reply.channel].push_back(reply.text);
+    }
+
+    for (int i = 0; i < CHANNELS; i++) {
+        std::string channel = channelName(i);
+        std::vector<std::string> expected;
+        if (i % ASKED_EVERY == 0) {
+            for (int k = 0; k < QUESTIONS; k++) expected.push_back("re: " + channel + " question " + std::to_string(k));
+        }
+        if (answers[channel] != expected) {
+            if (failures < 5) {
+                printf("#%s got %zu answer(s)%s%s, expected %zu in order\n", channel.c_str(),
+                       answers[channel].size(), answers[channel].empty() ? "" : ", first: ",
+                       answers[channel].empty() ? "" : answers[channel][0].c_str(), expected.size());
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("WSAStartup failed\n");
+        return 1;
+    }
+
+    PCCERT_CONTEXT cert = createCertificate(KEY_CONTAINER);
+    CredHandle credentials;
+    std::string port;
+    SOCKET listener = INVALID_SOCKET;
+    if (!cert || !acquireServerCredentials(cert, &credentials) ||
+        (listener = openLoopbackListener(CONNECTIONS, port)) == INVALID_SOCKET) {
+        printf("Could not set up the mock server (error %lu)\n", GetLastError());
+        if (cert) CertFreeCertificateContext(cert);
+        deleteKeyContainer(KEY_CONTAINER);
+        WSACleanup();
+        return 1;
+    }
+
+    std::string channelList;
+    for (int i = 0; i < CHANNELS; i++) channelList += channelName(i) + " ";
+
+    KindroidAPI kindroid("replay-key", "replay-ai", "https://kindroid.invalid/v1");
+    TwitchBot* bot = new TwitchBot("kinbot", "oauth:replay", channelList, &kindroid, NULL,
+                                   CHANNELS_PER_CONNECTION, true);
+    bot->setServer("127.0.0.1", port);
+    bot->setRateLimits(JOINS, JOIN_WINDOW_MS, MESSAGES, MESSAGE_WINDOW_MS);
+    bot->start();
+
+    int failures = 0;
+    size_t expectedReplies = (size_t)((CHANNELS + ASKED_EVERY - 1) / ASKED_EVERY) * QUESTIONS;
+    std::vector<std::unique_ptr<MockConnection>> conns;
+    std::vector<std::thread> servers;
+    for (int c = 0; c < CONNECTIONS; c++) {
+        conns.push_back(std::make_unique<MockConnection>());
+        if (!conns.back()->accept(listener, &credentials)) {
+            printf("connection %d: TLS accept failed\n", c);
+            failures++;
+            break;
+        }
+        servers.emplace_back(serveConnection, conns.back().get(), c);
+    }
+
+    // Wait for every JOIN and every answer, then give stragglers a moment to show up
+    ULONGLONG start = GetTickCount64();
+    while (failures == 0 && GetTickCount64() - start < DEADLINE_MS) {
+        {
+            std::lock_guard<std::mutex> lock(seenMutex);
+            if (joins.size() >= CHANNELS && replies.size() >= expectedReplies) break;
+        }
+        Sleep(50);
+    }
+    Sleep(MESSAGE_WINDOW_MS);
+
+    bot->stop();
+    for (auto& server : servers) server.join();
+    delete bot;
+
+    if (failures == 0) {
+        std::map<std::string, int> owner;
+        failures += checkSpreading(owner);
+        failures += checkPacing("JOINs", joins, JOINS, JOIN_WINDOW_MS);
+        failures += checkPacing("PRIVMSGs", replies, MESSAGES, MESSAGE_WINDOW_MS);
+        failures += checkReplies(owner);
+    }
+
+    closesocket(listener);
+    FreeCredentialsHandle(&credentials);
+    CertFreeCertificateContext(cert);
+    deleteKeyContainer(KEY_CONTAINER);
+    WSACleanup();
+
+    printf("ReplayTwitchChannels: %d failure(s), %d channels over %d connections\n", failures, CHANNELS,
+           CONNECTIONS);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+// Mock-server replay of Twitch moderation against queued and running replies.
+// A local TLS server stands in for Twitch (raw IRC over TLS); Kindroid is faked in
+// this file and takes KINDROID_MS per answer. Eight channels each get five mentions
+// at once. While every channel's first answer is still with Kindroid, the server
+// sends one moderation event per channel: nothing, CLEARMSG of the running or of a
+// queued message, a timeout of the running user, a ban of a queued user, /clear,
+// emote-only (followed by one more mention) and slow mode. Checks which questions
+// reach Kindroid, which answers are posted and in what order, and that slow mode
+// spaces a channel's answers. Run tests\build_tests.bat from a Visual Studio x64
+// Native Tools prompt; exits non-zero on any failed check.
+
+#include "MockTlsServer.h"
+#include <cstdio>
+#include <map>
+
+#pragma comment(lib, "user32.lib")
+
+bool g_debugMode = false; // Normally Main.cpp's; off so chat lines are not logged
+
+static const int CHANNELS = 8;
+static const int MENTIONS = 5;          // Per channel, one viewer each; fits a reply lane
+static const DWORD KINDROID_MS = 600;
+static const DWORD MODERATION_AFTER_MS = 200; // Well inside the first answer's KINDROID_MS
+static const int SLOW_SECS = 2;        // As sent in SCENARIOS
+static const DWORD CLOCK_SLACK_MS = 40;
+static const DWORD DEADLINE_MS = 60000;
+static const wchar_t* KEY_CONTAINER = L"KinBotManagerModerationReplay";
+
+// What each channel goes through, and what should come of it
+struct Scenario {
+    const char* event;    // IRC line sent mid-flight, "%s" for the channel; empty for none
+    const char* asked;    // Questions that reach Kindroid, by number
+    const char* answered; // Answers posted, in order
+};
+
+static const Scenario SCENARIOS[CHANNELS] = {
+    { "", "01234", "01234" },
+    { "@login=viewer0;target-msg-id=ch0-0 :tmi.twitch.tv CLEARMSG #%s :question 0", "01234", "1234" },
+    { "@login=viewer3;target-msg-id=ch0-3 :tmi.twitch.tv CLEARMSG #%s :question 3", "0124", "0124" },
+    { "@ban-duration=600;target-user-id=1000 :tmi.twitch.tv CLEARCHAT #%s :viewer0", "01234", "1234" },
+    { "@target-user-id=1002 :tmi.twitch.tv CLEARCHAT #%s :viewer2", "0134", "0134" },
+    { ":tmi.twitch.tv CLEARCHAT #%s", "0", "" },
+    { "@emote-only=1 :tmi.twitch.tv ROOMSTATE #%s", "0", "" },
+    { "@slow=2 :tmi.twitch.tv ROOMSTATE #%s", "01234", "01234" },
+};
+static const int EMOTE_ONLY_CHANNEL = 6;
+static const int SLOW_CHANNEL = 7;
+
+// ============================================
+// Fake Kindroid: answers "<channel> question <k>" with "re: <channel> question <k>"
+// ============================================
+
+static std::mutex seenMutex;
+static std::map<std::string, std::string> asked;    // Channel -> question numbers, in call order
+static std::map<std::string, std::string> answered; // Channel -> answer numbers, in post order
+static std::map<std::string, std::vector<ULONGLONG>> answerTimes;
+static size_t answerCount = 0;
+
+std::string HttpClient::request(const std::string& method, const std::string& host, const std::string& path,
+                                const std::string& headers, const std::string& body, DWORD* statusCode) {
+    // KindroidAPI wraps the text as "<Message to you from ... in channel ...> text"
+    std::map<std::string, std::string> fields = SimpleJSON::parseObject(body);
+    std::string message = SimpleJSON::getString(fields, "message");
+    size_t textStart = message.find("> ");
+    std::string question = textStart == std::string::npos ? message : message.substr(textStart + 2);
+    {
+        std::lock_guard<std::mutex> lock(seenMutex);
+        asked[question.substr(0, question.find(' '))] += question.back();
+    }
+
+    Sleep(KINDROID_MS);
+
+    if (statusCode) *statusCode = 200;
+    std::string response;
+    JsonWriter(response).beginObject().key("response_text").string("re: " + question).endObject();
+    return response;
+}
+
+void HttpClient::prewarm(const std::string& host) {
+}
+
+// ============================================
+// Mock Twitch: the script runs on the connection's reader
+// ============================================
+
+static std::string channelName(int i) {
+    return "ch" + std::to_string(i);
+}
+
+static std::string mentionLine(const std::string& channel, int k) {
+    std::string user = "viewer" + std::to_string(k);
+    return "@display-name=Viewer" + std::to_string(k) + ";id=" + channel + "-" + std::to_string(k) +
+           ";user-id=" + std::to_string(1000 + k) + " :" + user + "!" + user + "@" + user +
+           ".tmi.twitch.tv PRIVMSG #" + channel + " :@kinbot " + channel + " question " + std::to_string(k) +
+           "\r\n";
+}
+
+static std::string eventLine(int i) {
+    // CLEARMSG ids are written for ch0 and moved to the channel they are sent in
+    std::string line = SCENARIOS[i].event;
+    std::string channel = channelName(i);
+    size_t at;
+    while ((at = line.find("%s")) != std::string::npos) line.replace(at, 2, channel);
+    if ((at = line.find("=ch0-")) != std::string::npos) line.replace(at + 1, 3, channel);
+    return line + "\r\n";
+}
+
+static void serveConnection(MockConnection* conn) {
+    std::string text;
+    int joined = 0;
+    while (conn->receive()) {
+        text += conn->plain;
+        conn->plain.clear();
+
+        size_t lineStart = 0;
+        size_t lineEnd;
+        while ((lineEnd = text.find("\r\n", lineStart)) != std::string::npos) {
+            std::string line = text.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 2;
+
+            if (line.compare(0, 5, "NICK ") == 0) {
+                conn->send(":tmi.twitch.tv 001 kinbot :Welcome, GLHF!\r\n");
+            } else if (line.compare(0, 6, "JOIN #") == 0 && ++joined == CHANNELS) {
+                // Everyone asks at once, then moderation lands while the first answers are out
+                std::string mentions;
+                for (int i = 0; i < CHANNELS; i++) {
+                    for (int k = 0; k < MENTIONS; k++) mentions += mentionLine(channelName(i), k);
+                }
+                conn->send(mentions);
+                Sleep(MODERATION_AFTER_MS);
+
+                std::string events;
+                for (int i = 0; i < CHANNELS; i++) {
+                    if (SCENARIOS[i].event[0]) events += eventLine(i);
+                }
+                events += mentionLine(channelName(EMOTE_ONLY_CHANNEL), MENTIONS); // Ignored: emote-only
+                conn->send(events);
+            } else if (line.compare(0, 9, "PRIVMSG #") == 0) {
+                size_t colon = line.find(" :");
+                if (colon == std::string::npos) continue;
+                std::string channel = line.substr(9, colon - 9);
+                std::lock_guard<std::mutex> lock(seenMutex);
+                answered[channel] += line.back();
+                answerTimes[channel].push_back(GetTickCount64());
+                answerCount++;
+            }
+        }
+        text.erase(0, lineStart);
+    }
+}
+
+int main() {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("WSAStartup failed\n");
+        return 1;
+    }
+
+    PCCERT_CONTEXT cert = createCertificate(KEY_CONTAINER);
+    CredHandle credentials;
+    std::string port;
+    SOCKET listener = INVALID_SOCKET;
+    if (!cert || !acquireServerCredentials(cert, &credentials) ||
+        (listener = openLoopbackListener(1, port)) == INVALID_SOCKET) {
+        printf("Could not set up the mock server (error %lu)\n", GetLastError());
+        if (cert) CertFreeCertificateContext(cert);
+        deleteKeyContainer(KEY_CONTAINER);
+        WSACleanup();
+        return 1;
+    }
+
+    std::string channelList;
+    size_t expectedAnswers = 0;
+    for (int i = 0; i < CHANNELS; i++) {
+        channelList += channelName(i) + " ";
+        expectedAnswers += strlen(SCENARIOS[i].answered);
+    }
+
+    KindroidAPI kindroid("replay-key", "replay-ai", "https://kindroid.invalid/v1");
+    TwitchBot* bot = new TwitchBot("kinbot", "oauth:replay", channelList, &kindroid, NULL, 50, true);
+    bot->setServer("127.0.0.1", port);
+    bot->setRateLimits(20, 10000, 100, 30000); // The message limit is not what this test is about
+    bot->start();
+
+    int failures = 0;
+    MockConnection conn;
+    std::thread server;
+    if (conn.accept(listener, &credentials)) {
+        server = std::thread(serveConnection, &conn);
+    } else {
+        printf("TLS accept failed\n");
+        failures++;
+    }
+
+    // Wait for the answers that should come, then long enough for one that shouldn't
+    ULONGLONG start = GetTickCount64();
+    while (failures == 0 && GetTickCount64() - start < DEADLINE_MS) {
+        {
+            std::lock_guard<std::mutex> lock(seenMutex);
+            if (answerCount >= expectedAnswers) break;
+        }
+        Sleep(50);
+    }
+    Sleep(SLOW_SECS * 1000 + KINDROID_MS);
+
+    bot->stop();
+    if (server.joinable()) server.join();
+    delete bot;
+
+    size_t calls = 0;
+    if (failures == 0) {
+        for (int i = 0; i < CHANNELS; i++) {
+            std::string channel = channelName(i);
+            calls += asked[channel].size();
+            if (asked[channel] != SCENARIOS[i].asked || answered[channel] != SCENARIOS[i].answered) {
+                printf("#%s: asked \"%s\", answered \"%s\"; expected \"%s\" and \"%s\"\n", channel.c_str(),
+                       asked[channel].c_str(), answered[channel].c_str(), SCENARIOS[i].asked,
+                       SCENARIOS[i].answered);
+                failures++;
+            }
+        }
+
+        // Slow mode came in during the first answer, so every later one waits it out
+        const std::vector<ULONGLONG>& times = answerTimes[channelName(SLOW_CHANNEL)];
+        for (size_t i = 1; i < times.size(); i++) {
+            if (times[i] - times[i - 1] + CLOCK_SLACK_MS < (ULONGLONG)SLOW_SECS * 1000) {
+                printf("#%s: answers %zu and %zu %llu ms apart in %d s slow mode\n",
+                       channelName(SLOW_CHANNEL).c_str(), i - 1, i, times[i] - times[i - 1], SLOW_SECS);
+                failures++;
+            }
+        }
+    }
+
+    printf("%d mentions, %zu Kindroid calls, %zu answers posted\n", CHANNELS * MENTIONS + 1, calls, answerCount);
+
+    closesocket(listener);
+    FreeCredentialsHandle(&credentials);
+    CertFreeCertificateContext(cert);
+    deleteKeyContainer(KEY_CONTAINER);
+    WSACleanup();
+
+    printf("ReplayTwitchModeration: %d failure(s) in %d channels\n", failures, CHANNELS);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+@echo off
+REM Builds and runs the standalone checks in this folder, the mock-server
+REM replays, then the benchmarks. Run from a "x64 Native Tools Command Prompt for VS 2022".
+
+cd /d "%~dp0"
+if not exist out mkdir out
+
+set FAILED=0
+call :run FuzzSplitMessage "..\MessageSplitter.cpp"
+call :run FuzzJsonUnescape "..\Utils.cpp"
+call :run FuzzTriggerRules "..\TriggerRules.cpp ..\CooldownTable.cpp"
+call :run FuzzMentionMatcher "..\MentionMatcher.cpp"
+
+echo.
+echo Mock-server replays (127.0.0.1; Kindroid is faked inside each test):
+call :run ReplayTwitchChannels "..\TwitchBot.cpp ..\IrcMessage.cpp ..\MentionMatcher.cpp ..\TriggerRules.cpp ..\CooldownTable.cpp ..\ReplyQueue.cpp ..\MessageSplitter.cpp ..\Network.cpp ..\SchannelSSL.cpp ..\WebSocket.cpp ..\Utils.cpp ..\KindroidAPI.cpp"
+call :run ReplayTwitchModeration "..\TwitchBot.cpp ..\IrcMessage.cpp ..\MentionMatcher.cpp ..\TriggerRules.cpp ..\CooldownTable.cpp ..\ReplyQueue.cpp ..\MessageSplitter.cpp ..\Network.cpp ..\SchannelSSL.cpp ..\WebSocket.cpp ..\Utils.cpp ..\KindroidAPI.cpp"
+call :run ReplayDiscordEdits "..\DiscordBot.cpp ..\DiscordCache.cpp ..\DiscordOutbox.cpp ..\MentionMatcher.cpp ..\TriggerRules.cpp ..\CooldownTable.cpp ..\ReplyQueue.cpp ..\MessageSplitter.cpp ..\Network.cpp ..\SchannelSSL.cpp ..\WebSocket.cpp ..\Utils.cpp ..\KindroidAPI.cpp"
+
+echo.
+echo JSON escape benchmark, with and without the AVX2 path:
+call :run BenchJsonEscape "..\Utils.cpp"
+call :run BenchJsonEscapeSse2 "/DSIMPLEJSON_NO_AVX2 ..\Utils.cpp"
+
+echo.
+echo JSON payloads, operator+ and buildObject against JsonWriter:
+call :run BenchJsonWriter "..\Utils.cpp"
+
+echo.
+echo Gateway field extraction, JsonPathSet against find and a DOM parse:
+call :run BenchJsonPathSet "..\Utils.cpp"
+
+echo.
+echo Reply splitting on long multilingual replies, against the code it replaced:
+call :run BenchSplitMessage "..\MessageSplitter.cpp"
+
+echo.
+echo Twitch line handling, against the code it replaced:
+call :run BenchIrcMessage "..\IrcMessage.cpp ..\MentionMatcher.cpp"
+call :run FuzzLineBuffer "..\IrcMessage.cpp"
+
+echo.
+echo Cooldown table, far more users than slots:
+call :run BenchCooldownTable "..\CooldownTable.cpp"
+
+echo.
+echo Twitch transport benchmark (mock servers on 127.0.0.1):
+call :run BenchTwitchTransport "..\TwitchBot.cpp ..\IrcMessage.cpp ..\MentionMatcher.cpp ..\TriggerRules.cpp ..\CooldownTable.cpp ..\ReplyQueue.cpp ..\MessageSplitter.cpp ..\Network.cpp ..\SchannelSSL.cpp ..\WebSocket.cpp ..\Utils.cpp ..\KindroidAPI.cpp ..\HttpClient.cpp"
+
+echo.
+echo TLS transport, old code against new (loopback TLS with the bot's Schannel client):
+call :run BenchWebSocketSend "..\WebSocket.cpp ..\SchannelSSL.cpp ..\Network.cpp"
+call :run BenchTlsReceive "..\SchannelSSL.cpp ..\Network.cpp"
+call :run BenchTlsResume "..\SchannelSSL.cpp ..\Network.cpp"
+
+echo.
+echo Discord typing indicator: repeat mentions under a patience model, and REST cost:
+call :run BenchDiscordTyping "..\DiscordBot.cpp ..\DiscordCache.cpp ..\DiscordOutbox.cpp ..\MentionMatcher.cpp ..\TriggerRules.cpp ..\CooldownTable.cpp ..\ReplyQueue.cpp ..\MessageSplitter.cpp ..\Network.cpp ..\SchannelSSL.cpp ..\WebSocket.cpp ..\Utils.cpp ..\KindroidAPI.cpp"
+
+echo.
+if %FAILED% EQU 0 (
+    echo All checks passed.
+) else (
+    echo Some checks FAILED.
+)
+exit /b %FAILED%
+
+:run
+cl /nologo /std:c++17 /EHsc /O2 /W3 /DUNICODE /D_UNICODE /Fo:out\ /Fe:out\%1.exe %1.cpp %~2 >out\%1.log
+if %ERRORLEVEL% NEQ 0 (
+    type out\%1.log
+    set FAILED=1
+    goto :eof
+)
+REM Run from out\ so anything the code under test logs stays there
+pushd out
+%1.exe
+if %ERRORLEVEL% NEQ 0 set FAILED=1
+popd
+goto :eof